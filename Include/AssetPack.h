@@ -0,0 +1,445 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <streambuf>
+#include <algorithm>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "LZ4Block.h"
+
+/*
+ * Every asset (models, Images, Shaders) in one file, made by Tools/AssetPacker and mapped into memory once at startup.
+ *
+ * The file is a header, a table of contents sorted by the hash of each name, the names, then each entry's data
+ * starting on its own 4 KiB page. Loading an asset is a binary search of the table and a pointer into the mapping,
+ * so nothing is read until it's touched and nothing is copied unless the entry is LZ4 compressed (see LZ4Block.h).
+ *
+ * Names are matched ignoring case and with either slash, so "Images/crate.png" finds Images/crate.png.
+ * Anything that isn't in the pack (or everything, if there's no pack) is read from the loose file as before.
+ */
+
+/* Where the demo looks for its pack, next to the executable like the asset folders */
+const char* const ASSET_PACK_PATH = "assets.pack";
+
+const uint32_t ASSET_PACK_VERSION = 1;
+const uint32_t ASSET_PACK_ALIGNMENT = 4096;
+
+/* Entry flags */
+const uint32_t ASSET_LZ4 = 1;
+
+struct AssetPackHeader
+{
+    char magic[4];          //"APAK"
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t namesBytes;    //Size of the names, which come straight after the table
+};
+
+/* One asset in the table of contents */
+struct AssetPackEntry
+{
+    uint64_t hash;          //AssetNameHash of the name, which the table's sorted by
+    uint64_t offset;        //From the start of the file, a multiple of ASSET_PACK_ALIGNMENT
+    uint32_t storedSize;    //Bytes in the file
+    uint32_t size;          //Bytes once it's decompressed
+    uint32_t nameOffset;    //Into the names
+    uint32_t flags;
+};
+
+static_assert(sizeof(AssetPackHeader) == 16 && sizeof(AssetPackEntry) == 32, "Asset pack structures are read straight from the file");
+
+/* How a name is compared: lower case, forward slashes */
+inline char NormaliseAssetChar(char c)
+{
+    return (c == '\\') ? '/' : (char)tolower((unsigned char)c);
+}
+
+/* A name as it's compared, also without any leading "./" */
+std::string NormaliseAssetName(const std::string& name)
+{
+    std::string normalised(name);
+    std::transform(normalised.begin(), normalised.end(), normalised.begin(), NormaliseAssetChar);
+    while(normalised.compare(0, 2, "./") == 0)
+        normalised.erase(0, 2);
+    return normalised;
+}
+
+/* 64-bit FNV-1a of a normalised name */
+uint64_t AssetNameHash(const std::string& normalised)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for(size_t i = 0; i < normalised.size(); i++)
+    {
+        hash ^= (unsigned char)normalised[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/* The bytes of an asset. Straight out of the pack's mapping when it's stored as it is (good until the pack's closed),
+   otherwise in buffer (so copying one isn't safe) */
+struct Asset
+{
+    const unsigned char* data;
+    size_t size;
+    std::vector<unsigned char> buffer;
+    bool packed;    //From the pack rather than a loose file
+
+    Asset() : data(NULL), size(0), packed(false) {}
+};
+
+/* Lets something that wants a std::istream (e.g. TinyOBJ) read an asset where it is */
+class AssetStreamBuf: public std::streambuf
+{
+public:
+    AssetStreamBuf(const Asset& asset)
+    {
+        char* begin = (char*)asset.data;
+        setg(begin, begin, begin + asset.size);
+    }
+};
+
+class AssetPack
+{
+public:
+    AssetPack() : mapping(NULL), mappedBytes(0), entries(NULL), names(NULL), entryCount(0) {}
+
+    ~AssetPack()
+    {
+        Close();
+    }
+
+    /* Map a pack. False (with any pack that was open closed) if there isn't one or it's not a pack */
+    bool Open(const std::string& path)
+    {
+        Close();
+        if(!Map(path))
+            return false;
+
+        const AssetPackHeader* header = (const AssetPackHeader*)mapping;
+        if(mappedBytes < sizeof(AssetPackHeader) || memcmp(header->magic, "APAK", 4) != 0 || header->version != ASSET_PACK_VERSION ||
+           sizeof(AssetPackHeader) + (uint64_t)header->entryCount * sizeof(AssetPackEntry) + header->namesBytes > mappedBytes)
+        {
+            std::cout << path << " isn't an asset pack (or is from another version of AssetPacker)" << std::endl;
+            Close();
+            return false;
+        }
+        entries = (const AssetPackEntry*)(mapping + sizeof(AssetPackHeader));
+        names = (const char*)(entries + header->entryCount);
+        entryCount = (int)header->entryCount;
+
+        //Check everything the table points at is in the file once, rather than on every load
+        for(int e = 0; e < entryCount; e++)
+        {
+            const AssetPackEntry& entry = entries[e];
+            if(entry.offset + entry.storedSize > mappedBytes || entry.nameOffset >= header->namesBytes ||
+               memchr(names + entry.nameOffset, '\0', header->namesBytes - entry.nameOffset) == NULL ||
+               (!(entry.flags & ASSET_LZ4) && entry.storedSize != entry.size) || (e > 0 && entries[e - 1].hash > entry.hash))
+            {
+                std::cout << path << " has a bad entry " << e << std::endl;
+                Close();
+                return false;
+            }
+        }
+
+        this->path = path;
+        return true;
+    }
+
+    void Close()
+    {
+        if(mapping != NULL)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(mapping);
+#else
+            munmap((void*)mapping, mappedBytes);
+#endif
+        }
+        mapping = NULL;
+        mappedBytes = 0;
+        entries = NULL;
+        names = NULL;
+        entryCount = 0;
+        path.clear();
+    }
+
+    bool IsOpen() const
+    {
+        return mapping != NULL;
+    }
+
+    /* The table entry for a name, or NULL if it's not in the pack */
+    const AssetPackEntry* Find(const std::string& name) const
+    {
+        if(entryCount == 0)
+            return NULL;
+        std::string normalised = NormaliseAssetName(name);
+        uint64_t hash = AssetNameHash(normalised);
+
+        AssetPackEntry key;
+        key.hash = hash;
+        const AssetPackEntry* found = std::lower_bound(entries, entries + entryCount, key, EntryBefore);
+        //Names with the same hash sit next to each other
+        for(; found != entries + entryCount && found->hash == hash; found++)
+            if(NameMatches(names + found->nameOffset, normalised))
+                return found;
+        return NULL;
+    }
+
+    /* Fill in an asset from the pack. False if it's not in the pack or won't decompress */
+    bool Read(const std::string& name, Asset& asset) const
+    {
+        const AssetPackEntry* entry = Find(name);
+        if(entry == NULL)
+            return false;
+
+        const unsigned char* stored = mapping + entry->offset;
+        asset.packed = true;
+        asset.size = entry->size;
+        if(!(entry->flags & ASSET_LZ4))
+        {
+            asset.buffer.clear();
+            asset.data = stored;
+            return true;
+        }
+
+        asset.buffer.resize(entry->size);
+        asset.data = asset.buffer.data();
+        if(!LZ4Decompress(stored, (int)entry->storedSize, asset.buffer.data(), (int)entry->size))
+        {
+            std::cout << "Asset " << name << " in " << path << " is corrupt" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    int EntryCount() const
+    {
+        return entryCount;
+    }
+
+    const AssetPackEntry& GetEntry(int e) const
+    {
+        return entries[e];
+    }
+
+    /* An entry's name as it was packed, e.g. Images/thunderbird.png */
+    const char* GetName(int e) const
+    {
+        return names + entries[e].nameOffset;
+    }
+
+    const std::string& GetPath() const
+    {
+        return path;
+    }
+
+    /* Size of the whole file */
+    size_t GetBytes() const
+    {
+        return mappedBytes;
+    }
+
+private:
+    const unsigned char* mapping;
+    size_t mappedBytes;
+    const AssetPackEntry* entries;
+    const char* names;
+    int entryCount;
+    std::string path;
+
+    static bool EntryBefore(const AssetPackEntry& a, const AssetPackEntry& b)
+    {
+        return a.hash < b.hash;
+    }
+
+    static bool NameMatches(const char* stored, const std::string& normalised)
+    {
+        size_t i = 0;
+        for(; stored[i] != '\0'; i++)
+            if(i >= normalised.size() || NormaliseAssetChar(stored[i]) != normalised[i])
+                return false;
+        return i == normalised.size();
+    }
+
+    /* Map the whole file read-only. Pages come in from disk as they're first touched */
+    bool Map(const std::string& path)
+    {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if(file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER size;
+        HANDLE fileMapping = NULL;
+        if(GetFileSizeEx(file, &size) && size.QuadPart > 0)
+            fileMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        CloseHandle(file);
+        if(fileMapping == NULL)
+            return false;
+        //The view keeps the mapping alive by itself
+        void* view = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(fileMapping);
+        if(view == NULL)
+            return false;
+        mapping = (const unsigned char*)view;
+        mappedBytes = (size_t)size.QuadPart;
+#else
+        int file = open(path.c_str(), O_RDONLY);
+        if(file < 0)
+            return false;
+        struct stat status;
+        void* view = MAP_FAILED;
+        if(fstat(file, &status) == 0 && status.st_size > 0)
+            view = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);
+        if(view == MAP_FAILED)
+            return false;
+        mapping = (const unsigned char*)view;
+        mappedBytes = (size_t)status.st_size;
+#endif
+        return true;
+    }
+};
+
+/* The demo's pack, opened in main */
+AssetPack assetPack;
+
+/* Look in the pack for assets. Off to read every one from its loose file, e.g. to compare */
+bool useAssetPack = true;
+
+/* Read a whole loose file into an asset. False if it isn't there */
+bool ReadLooseAsset(const std::string& path, Asset& asset)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if(file == NULL)
+        return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    asset.buffer.resize(size > 0 ? size : 0);
+    bool read = (size >= 0) && fread(asset.buffer.data(), 1, asset.buffer.size(), file) == asset.buffer.size();
+    fclose(file);
+
+    asset.data = asset.buffer.data();
+    asset.size = asset.buffer.size();
+    asset.packed = false;
+    return read;
+}
+
+/* An asset from the pack if it's there, otherwise from the loose file. False if it's in neither */
+bool LoadAsset(const std::string& path, Asset& asset)
+{
+    if(useAssetPack && assetPack.IsOpen() && assetPack.Read(path, asset))
+        return true;
+    return ReadLooseAsset(path, asset);
+}
+
+/* What goes into a pack: the name it's found by and its contents */
+struct AssetPackSource
+{
+    std::string name;
+    std::vector<unsigned char> data;
+};
+
+/* Entries only stay compressed if it saves at least an eighth, as decompressing costs more than reading the difference */
+inline bool WorthCompressing(size_t size, size_t compressed)
+{
+    return compressed + size / 8 <= size;
+}
+
+/* Write a pack of assets, compressing the ones that are worth it if compress is set. Names must differ (ignoring case) */
+bool WriteAssetPack(const std::string& path, const std::vector<AssetPackSource>& assets, bool compress)
+{
+    std::vector<AssetPackEntry> table(assets.size());
+    std::vector<size_t> order(assets.size());
+    std::string names;
+    for(size_t a = 0; a < assets.size(); a++)
+    {
+        AssetPackEntry& entry = table[a];
+        memset(&entry, 0, sizeof(entry));
+        entry.hash = AssetNameHash(NormaliseAssetName(assets[a].name));
+        entry.size = (uint32_t)assets[a].data.size();
+        entry.nameOffset = (uint32_t)names.size();
+        names += assets[a].name;
+        names += '\0';
+        order[a] = a;
+    }
+    std::sort(order.begin(), order.end(), [&table](size_t a, size_t b) { return table[a].hash < table[b].hash; });
+    for(size_t i = 1; i < order.size(); i++)
+    {
+        if(table[order[i - 1]].hash == table[order[i]].hash &&
+           NormaliseAssetName(assets[order[i - 1]].name) == NormaliseAssetName(assets[order[i]].name))
+        {
+            std::cout << "Can't pack both " << assets[order[i - 1]].name << " and " << assets[order[i]].name << std::endl;
+            return false;
+        }
+    }
+
+    //Data starts on the first page after the table and names
+    std::vector<unsigned char> data;
+    uint64_t offset = sizeof(AssetPackHeader) + table.size() * sizeof(AssetPackEntry) + names.size();
+    std::vector<unsigned char> compressed;
+    for(size_t i = 0; i < order.size(); i++)
+    {
+        AssetPackEntry& entry = table[order[i]];
+        const std::vector<unsigned char>& contents = assets[order[i]].data;
+        const unsigned char* stored = contents.data();
+        entry.storedSize = entry.size;
+        if(compress && !contents.empty())
+        {
+            compressed.resize(LZ4CompressBound((int)contents.size()));
+            int compressedSize = LZ4Compress(contents.data(), (int)contents.size(), compressed.data());
+            if(WorthCompressing(contents.size(), compressedSize))
+            {
+                stored = compressed.data();
+                entry.storedSize = (uint32_t)compressedSize;
+                entry.flags |= ASSET_LZ4;
+            }
+        }
+
+        offset = (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+        entry.offset = offset;
+        data.resize(offset - (sizeof(AssetPackHeader) + table.size() * sizeof(AssetPackEntry) + names.size()), 0);
+        data.insert(data.end(), stored, stored + entry.storedSize);
+        offset += entry.storedSize;
+    }
+
+    std::vector<AssetPackEntry> sorted;
+    for(size_t i = 0; i < order.size(); i++)
+        sorted.push_back(table[order[i]]);
+    AssetPackHeader header = {{'A', 'P', 'A', 'K'}, ASSET_PACK_VERSION, (uint32_t)sorted.size(), (uint32_t)names.size()};
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if(file == NULL)
+    {
+        std::cout << "Couldn't write " << path << std::endl;
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   (sorted.empty() || fwrite(sorted.data(), sizeof(AssetPackEntry), sorted.size(), file) == sorted.size()) &&
+                   fwrite(names.data(), 1, names.size(), file) == names.size() &&
+                   fwrite(data.data(), 1, data.size(), file) == data.size();
+    fclose(file);
+    return written;
+}
+
+#endif // ASSET_PACK_H
@@ -0,0 +1,1921 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "ImGUI/imgui.h"
+#include "JobSystem.h"
+#include "UVSphereGeometry.h"
+#include "VertexKernels.h"
+#include "MeshCache.h"
+#include "IcosphereGeometry.h"
+#include "PrimitiveTables.h"
+#include "CubeGeometry.h"
+#include "PlaneGeomtery.h"
+#include "ProceduralMesh.h"
+#include "DebugDraw.h"
+#include "OBJMesh.h"
+#include "NormalVisualiser.h"
+#include "UniformBuffers.h"
+#include "ShaderManager.h"
+#include "ShaderPermutations.h"
+#include "GraphicsObject.h"
+#include "TextureLoader.h"
+#include "TextureArrays.h"
+#include "InstancedMesh.h"
+#include "AssetPack.h"
+#include "TextureStreaming.h"
+#include "GPUResources.h"
+#include "PointLights.h"
+#include "DeferredShading.h"
+#include "LightClusters.h"
+
+/*
+ * Micro-benchmarks that can be started from the Menu.
+ * Results go to the console and are kept in a log shown under the buttons.
+ */
+
+typedef std::chrono::high_resolution_clock BenchmarkClock;
+
+std::vector<std::string> benchmarkLog;
+
+/* printf to the console and the on-screen log */
+void BenchmarkLog(const char* format, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    std::cout << line << std::endl;
+    benchmarkLog.push_back(line);
+}
+
+double SecondsSince(BenchmarkClock::time_point start)
+{
+    return std::chrono::duration<double>(BenchmarkClock::now() - start).count();
+}
+
+void EmptyJob(void* data, int begin, int end)
+{
+}
+
+/* How many tiny jobs per second the shared job system gets through */
+void BenchmarkJobThroughput()
+{
+    const int batches = 100;
+    const int jobsPerBatch = 4000;
+
+    BenchmarkClock::time_point start = BenchmarkClock::now();
+    for(int batch = 0; batch < batches; batch++)
+    {
+        JobCounter counter;
+        for(int i = 0; i < jobsPerBatch; i++)
+            jobSystem.Run(EmptyJob, NULL, 0, 1, &counter);
+        jobSystem.Wait(&counter);
+    }
+    double seconds = SecondsSince(start);
+
+    BenchmarkLog("Job throughput: %.2f M jobs/s on %d threads", batches * jobsPerBatch / seconds / 1.0e6, jobSystem.ThreadCount());
+}
+
+/* The same parallel-for run on job systems of 1 to N threads */
+void BenchmarkParallelForScaling()
+{
+    const int itemCount = 1 << 22;
+    std::vector<float> results(itemCount);
+
+    int maxThreads = (int)std::thread::hardware_concurrency();
+    if(maxThreads < 1)
+        maxThreads = 1;
+
+    double singleThreadSeconds = 0.0;
+    for(int threads = 1; threads <= maxThreads; threads++)
+    {
+        JobSystem scheduler(threads - 1);
+
+        BenchmarkClock::time_point start = BenchmarkClock::now();
+        scheduler.ParallelFor(itemCount, 0, [&results](int begin, int end)
+        {
+            for(int i = begin; i < end; i++)
+                results[i] = (float)(sin(i * 0.001) * cos(i * 0.0007));
+        });
+        double seconds = SecondsSince(start);
+
+        if(threads == 1)
+            singleThreadSeconds = seconds;
+        BenchmarkLog("Parallel-for, %d threads: %.2f ms (x%.2f)", threads, seconds * 1000.0, singleThreadSeconds / seconds);
+    }
+}
+
+/*
+ * GetSpherePhong as it was before the trig tables and the job system,
+ * kept as the baseline for BenchmarkSphereGeneration.
+ */
+std::vector<struct Vertex> GetSpherePhongReference(int segments, int rings, double radius)
+{
+    /* Minimum of 3 segments and 3 rings */
+    if(segments < 3) segments = 3;
+    if(rings < 3) rings = 3;
+
+    std::vector<struct Vertex> vertices;
+
+    double ringAngle = 180.0f / rings;
+    double segmentAngle = 360.0f / segments;
+
+    /*
+     * NB: rn is the nth line of latitude, starting at the top
+     * bn is the nth line of longitude, starting from positive X direction
+     * This notation is to save space; the parameters still define the number of
+     * quad bands in the respective direction, NOT the lines of lat/long
+     */
+
+    //Oth line of latitude is the point on top
+    int i;
+    double theta = glm::radians(90.0 - ringAngle);
+    for(i = 0; i < segments; i++)
+    {
+        struct Vertex r0 = {{0.0, radius, 0.0},   {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}};
+
+        double phii = glm::radians(i * segmentAngle); //phi(i)
+        double r1biX = radius * cos(theta) * cos(phii);
+        double r1biY = radius * sin(theta);
+        double r1biZ = radius * cos(theta) * sin(phii);
+        glm::vec3 normali = glm::normalize(glm::vec3(r1biX, r1biY, r1biZ));
+        struct Vertex r1bi = {{r1biX, r1biY, r1biZ},    {normali.x, normali.y, normali.z},    {0.0f, 0.0f}};
+
+        double phii2 = glm::radians(((i + 1) % segments) * segmentAngle); //phi(i+1)
+        double r1bi2X = radius * cos(theta) * cos(phii2);
+        double r1bi2Y = radius * sin(theta);
+        double r1bi2Z = radius * cos(theta) * sin(phii2);
+        glm::vec3 normali2 = glm::normalize(glm::vec3(r1bi2X, r1bi2Y, r1bi2Z));
+        struct Vertex r1bi2 = {{r1bi2X, r1bi2Y, r1bi2Z},    {normali2.x, normali2.y, normali2.z},    {0.0f, 0.0f}};
+
+        vertices.push_back(r0);
+        vertices.push_back(r1bi);
+        vertices.push_back(r1bi2);
+
+    }
+
+    //Middle rings are made from quads (kinda...), so require different attention
+    for(int j = 1; j < rings - 1; j++)
+    {
+        double thetaj = glm::radians(90 - (j * ringAngle)); //theta(j)
+        double thetaj2 = glm::radians(90 - ((j + 1) * ringAngle)); //theta(j+1)
+        for(i = 0; i < segments; i++)
+        {
+            double phii = glm::radians(i * segmentAngle); //phi(i)
+            double phii2 = glm::radians(((i + 1) % segments) * segmentAngle); //phi(i+1)
+
+            double rjbiX = radius * cos(thetaj) * cos(phii);
+            double rjbiY = radius * sin(thetaj);
+            double rjbiZ = radius * cos(thetaj) * sin(phii);
+            glm::vec3 normalrjbi = glm::normalize(glm::vec3(rjbiX, rjbiY, rjbiZ));
+            struct Vertex rjbi = {{rjbiX, rjbiY, rjbiZ},    {normalrjbi.x, normalrjbi.y, normalrjbi.z}, {0.0f, 0.0f}};
+
+            double rjbi2X = radius * cos(thetaj) * cos(phii2);
+            double rjbi2Y = radius * sin(thetaj);
+            double rjbi2Z = radius * cos(thetaj) * sin(phii2);
+            glm::vec3 normalrjbi2 = glm::normalize(glm::vec3(rjbi2X, rjbi2Y, rjbi2Z));
+            struct Vertex rjbi2 = {{rjbi2X, rjbi2Y, rjbi2Z},    {normalrjbi2.x, normalrjbi2.y, normalrjbi2.z}, {0.0f, 0.0f}};
+
+            double rj2biX = radius * cos(thetaj2) * cos(phii);
+            double rj2biY = radius * sin(thetaj2);
+            double rj2biZ = radius * cos(thetaj2) * sin(phii);
+            glm::vec3 normalrj2bi = glm::normalize(glm::vec3(rj2biX, rj2biY, rj2biZ));
+            struct Vertex rj2bi = {{rj2biX, rj2biY, rj2biZ},    {normalrj2bi.x, normalrj2bi.y, normalrj2bi.z}, {0.0f, 0.0f}};
+
+            double rj2bi2X = radius * cos(thetaj2) * cos(phii2);
+            double rj2bi2Y = radius * sin(thetaj2);
+            double rj2bi2Z = radius * cos(thetaj2) * sin(phii2);
+            glm::vec3 normalrj2bi2 = glm::normalize(glm::vec3(rj2bi2X, rj2bi2Y, rj2bi2Z));
+            struct Vertex rj2bi2 = {{rj2bi2X, rj2bi2Y, rj2bi2Z},    {normalrj2bi2.x, normalrj2bi2.y, normalrj2bi2.z}, {0.0f, 0.0f}};
+
+            vertices.push_back(rjbi);
+            vertices.push_back(rjbi2);
+            vertices.push_back(rj2bi);
+
+            vertices.push_back(rjbi2);
+            vertices.push_back(rj2bi2);
+            vertices.push_back(rj2bi);
+        }
+    }
+
+    //(rings + 1)th line of latitude is the point on bottom
+    theta = glm::radians(ringAngle - 90);
+    for(i = 0; i < segments; i++)
+    {
+        struct Vertex rn2 = {{0.0, -radius, 0.0},   {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f}};
+
+        double phii = glm::radians(i * segmentAngle); //phi(i)
+        double rnbiX = radius * cos(theta) * cos(phii);
+        double rnbiY = radius * sin(theta);
+        double rnbiZ = radius * cos(theta) * sin(phii);
+        glm::vec3 normali = glm::normalize(glm::vec3(rnbiX, rnbiY, rnbiZ));
+        struct Vertex rnbi = {{rnbiX, rnbiY, rnbiZ},    {normali.x, normali.y, normali.z},    {0.0f, 0.0f}};
+
+        double phii2 = glm::radians(((i + 1) % segments) * segmentAngle); //phi(i+1)
+        double rnbi2X = radius * cos(theta) * cos(phii2);
+        double rnbi2Y = radius * sin(theta);
+        double rnbi2Z = radius * cos(theta) * sin(phii2);
+        glm::vec3 normali2 = glm::normalize(glm::vec3(rnbi2X, rnbi2Y, rnbi2Z));
+        struct Vertex rnbi2 = {{rnbi2X, rnbi2Y, rnbi2Z},    {normali2.x, normali2.y, normali2.z},    {0.0f, 0.0f}};
+
+        vertices.push_back(rn2);
+        vertices.push_back(rnbi);
+        vertices.push_back(rnbi2);
+    }
+
+    return vertices;
+}
+
+/* Largest difference in any position or normal component between two vertex lists of the same layout */
+double MaxVertexDifference(const std::vector<struct Vertex>& a, const std::vector<struct Vertex>& b)
+{
+    if(a.size() != b.size())
+        return INFINITY;
+
+    double largest = 0.0;
+    for(size_t v = 0; v < a.size(); v++)
+    {
+        for(int k = 0; k < 3; k++)
+        {
+            largest = fmax(largest, fabs(a[v].position[k] - b[v].position[k]));
+            largest = fmax(largest, fabs(a[v].normal[k] - b[v].normal[k]));
+        }
+    }
+    return largest;
+}
+
+/* Time a 4096x2048 sphere with the original generator and the current one */
+void BenchmarkSphereGeneration()
+{
+    const int segments = 4096;
+    const int rings = 2048;
+
+    //Check they still agree on something small first
+    double difference = MaxVertexDifference(GetSpherePhongReference(64, 32, 1.0), GetSpherePhong(64, 32, 1.0));
+    BenchmarkLog("Sphere generators differ by at most %g", difference);
+
+    size_t vertexCount;
+    BenchmarkClock::time_point start = BenchmarkClock::now();
+    {
+        std::vector<struct Vertex> reference = GetSpherePhongReference(segments, rings, 1.0);
+        vertexCount = reference.size();
+    }
+    double referenceSeconds = SecondsSince(start);
+
+    start = BenchmarkClock::now();
+    {
+        std::vector<struct Vertex> current = GetSpherePhong(segments, rings, 1.0);
+    }
+    double currentSeconds = SecondsSince(start);
+
+    BenchmarkLog("%dx%d sphere (%lu vertices): before %.0f ms, after %.0f ms on %d threads",
+                 segments, rings, (unsigned long)vertexCount, referenceSeconds * 1000.0, currentSeconds * 1000.0, jobSystem.ThreadCount());
+}
+
+/*
+ * Each ring kernel the binary has, on one very long ring.
+ * The SIMD ones have to match the scalar one exactly, and the sphere built with
+ * whichever was selected has to stay within float precision of the original generator.
+ */
+void BenchmarkVertexKernels()
+{
+    const int pointCount = 1 << 20;
+    const int repeats = 50;
+
+    RingTable ring(TrigTable(pointCount, 0.0, 360.0 / pointCount));
+    RingPoints scalar;
+    scalar.Compute(ring, 1.5f, 0.0f, 0.75f, 0.0f, RingKernelScalar);
+
+    std::vector<RingKernelInfo> kernels = GetRingKernels();
+    for(size_t k = 0; k < kernels.size(); k++)
+    {
+        if(!kernels[k].supported)
+        {
+            BenchmarkLog("%s kernel: not supported on this CPU", kernels[k].name);
+            continue;
+        }
+
+        RingPoints points;
+        BenchmarkClock::time_point start = BenchmarkClock::now();
+        for(int r = 0; r < repeats; r++)
+            points.Compute(ring, 1.5f, 0.0f, 0.75f, 0.0f, kernels[k].kernel);
+        double seconds = SecondsSince(start);
+
+        bool exact = points.x == scalar.x && points.z == scalar.z && points.normalX == scalar.normalX && points.normalZ == scalar.normalZ;
+        BenchmarkLog("%s kernel: %.0f M points/s, %s scalar%s", kernels[k].name, (double)pointCount * repeats / seconds / 1.0e6,
+                     exact ? "matches" : "DOES NOT MATCH", kernels[k].kernel == ringKernel ? " (selected)" : "");
+    }
+
+    //Float maths, so allow a few ulps of the radius
+    const double radius = 5.0;
+    double difference = MaxVertexDifference(GetSpherePhongReference(256, 128, radius), GetSpherePhong(256, 128, radius));
+    BenchmarkLog("Sphere vs original generator: %g (%s)", difference, difference <= 1.0e-6 * radius ? "ok" : "TOO FAR OUT");
+}
+
+/*
+ * Build a couple of thousand spheres of different sizes the old way, one mesh generated
+ * and uploaded per object, and then again through a mesh cache with a unit mesh per shape.
+ * Needs the GL context, so it can only be run from the Menu.
+ */
+void BenchmarkMeshCache()
+{
+    const int sphereCount = 2000;
+    const int segments = 16;
+    const int rings = 8;
+    GLfloat colours[4][3] = {{1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {0.0f, 0.8f, 0.0f}, {0.0f, 0.5f, 1.0f}};
+
+    std::vector<TriangleMesh*> uncached;
+    long uncachedBytes = 0;
+    BenchmarkClock::time_point start = BenchmarkClock::now();
+    for(int i = 0; i < sphereCount; i++)
+    {
+        double radius = 0.05 + (i % 100) * 0.004;
+        uncached.push_back(new TriangleMesh(GetSpherePhong(segments, rings, radius), "_", colours[i % 4]));
+        uncachedBytes += uncached.back()->GetBufferBytes();
+    }
+    glFinish();
+    double uncachedSeconds = SecondsSince(start);
+    for(size_t i = 0; i < uncached.size(); i++)
+    {
+        uncached[i]->Release();
+        delete uncached[i];
+    }
+
+    MeshCache cache;
+    start = BenchmarkClock::now();
+    for(int i = 0; i < sphereCount; i++)
+        cache.GetSphere(segments, rings, "_", colours[i % 4]);
+    glFinish();
+    double cachedSeconds = SecondsSince(start);
+    long cachedBytes = cache.bufferBytes;
+    int cachedMeshes = cache.MeshCount();
+    cache.Clear();
+
+    BenchmarkLog("%d spheres, a mesh each: %.1f ms, %.2f MB of vertex data", sphereCount, uncachedSeconds * 1000.0, uncachedBytes / (1024.0 * 1024.0));
+    BenchmarkLog("%d spheres, cached: %.1f ms, %d meshes, %.2f MB of vertex data", sphereCount, cachedSeconds * 1000.0, cachedMeshes, cachedBytes / (1024.0 * 1024.0));
+}
+
+/*
+ * Triangles against how far the surface strays from a true unit sphere, for UV spheres and icospheres.
+ * Icosphere levels go up in steps of four times the triangles, so to compare at equal error the
+ * nearest level is scaled along error ~ 1 / triangles, which the levels follow closely.
+ */
+void BenchmarkIcosphere()
+{
+    const int uvResolutions[5][2] = {{12, 6}, {24, 12}, {48, 24}, {96, 48}, {192, 96}};
+    std::vector<GLuint> noIndices;
+
+    double icoError[8];
+    int icoTriangles[8];
+    int icoVertices[8];
+    for(int level = 0; level < 8; level++)
+    {
+        IndexedGeometry ico = GetIcosphere(level, 1.0);
+        icoError[level] = MaxSphereError(ico.vertices, ico.indices, 1.0);
+        icoTriangles[level] = (int)ico.indices.size() / 3;
+        icoVertices[level] = (int)ico.vertices.size();
+        BenchmarkLog("Icosphere level %d: %d tris, %d verts, error %.5f", level, icoTriangles[level], icoVertices[level], icoError[level]);
+    }
+
+    for(int r = 0; r < 5; r++)
+    {
+        int segments = uvResolutions[r][0], rings = uvResolutions[r][1];
+        std::vector<struct Vertex> uv = GetSpherePhong(segments, rings, 1.0);
+        double uvError = MaxSphereError(uv, noIndices, 1.0);
+        int uvTriangles = (int)uv.size() / 3;
+
+        int level = 0;
+        while(level < 7 && icoError[level] > uvError)
+            level++;
+        double scale = icoError[level] / uvError;
+        BenchmarkLog("UV %dx%d: %d tris, %d verts, error %.5f. Icosphere at that error: ~%.0f tris (x%.2f), ~%.0f verts",
+                     segments, rings, uvTriangles, (int)uv.size(), uvError, icoTriangles[level] * scale,
+                     icoTriangles[level] * scale / uvTriangles, icoVertices[level] * scale);
+    }
+}
+
+/*
+ * The startup work the compile-time tables save: generating every baked primitive (plus the cube
+ * and plane) into fresh vectors, as startup used to, against finding the tables. Uploading costs the
+ * same either way, so it's left out. Also checks the tables still match the runtime generators.
+ */
+void BenchmarkPrimitiveTables()
+{
+    const int repeats = 50;
+
+    double difference = 0.0;
+    for(int t = 0; t < PRIMITIVE_TABLE_COUNT; t++)
+    {
+        const PrimitiveTable& table = PRIMITIVE_TABLES[t];
+        std::vector<struct Vertex> baked(table.vertices, table.vertices + table.vertexCount);
+        if(table.rings > 0)
+            difference = fmax(difference, MaxVertexDifference(GetSpherePhong(table.segments, table.rings, 1.0), baked));
+        else
+            difference = fmax(difference, MaxVertexDifference(GetConePhong(table.segments, table.shape, 1.0), baked));
+    }
+    BenchmarkLog("Tables vs runtime generators: %g (%s)", difference, difference <= 1.0e-6 ? "ok" : "TOO FAR OUT");
+
+    long generatedBytes = 0;
+    BenchmarkClock::time_point start = BenchmarkClock::now();
+    for(int r = 0; r < repeats; r++)
+    {
+        generatedBytes = 0;
+        for(int t = 0; t < PRIMITIVE_TABLE_COUNT; t++)
+        {
+            const PrimitiveTable& table = PRIMITIVE_TABLES[t];
+            std::vector<struct Vertex> vertices = table.rings > 0 ? GetSpherePhong(table.segments, table.rings, 1.0)
+                                                                 : GetConePhong(table.segments, table.shape, 1.0);
+            generatedBytes += vertices.size() * sizeof(struct Vertex);
+        }
+        generatedBytes += GetCubeGeometry(3.0).size() * sizeof(struct Vertex);
+        generatedBytes += GetPlaneGeometry().size() * sizeof(struct Vertex);
+    }
+    double generatedSeconds = SecondsSince(start) / repeats;
+
+    //What the mesh cache does now: look the table up and hand its pointer to glBufferData
+    long tableBytes = 0;
+    start = BenchmarkClock::now();
+    for(int r = 0; r < repeats; r++)
+    {
+        tableBytes = 0;
+        for(int t = 0; t < PRIMITIVE_TABLE_COUNT; t++)
+        {
+            const PrimitiveTable* table = PRIMITIVE_TABLES[t].rings > 0 ? FindSphereTable(PRIMITIVE_TABLES[t].segments, PRIMITIVE_TABLES[t].rings)
+                                                                        : FindConeTable(PRIMITIVE_TABLES[t].segments, PRIMITIVE_TABLES[t].shape);
+            tableBytes += table->vertexCount * sizeof(struct Vertex);
+        }
+        tableBytes += (CUBE_VERTEX_COUNT + PLANE_VERTEX_COUNT) * sizeof(struct Vertex);
+    }
+    double tableSeconds = SecondsSince(start) / repeats;
+
+    BenchmarkLog("%d primitives generated at startup: %.3f ms, %.1f KB allocated", PRIMITIVE_TABLE_COUNT + 2, generatedSeconds * 1000.0, generatedBytes / 1024.0);
+    BenchmarkLog("%d primitives from tables: %.4f ms, %.1f KB of read-only data, nothing allocated", PRIMITIVE_TABLE_COUNT + 2, tableSeconds * 1000.0, tableBytes / 1024.0);
+}
+
+/*
+ * A thousand spheres, each with its own resolution, made three ways: a generated mesh per sphere,
+ * the mesh cache (a mesh per different resolution), and the vertex shader with only instance data.
+ * Then one very detailed sphere on the CPU against the GPU. Needs the GL context.
+ */
+void BenchmarkProceduralSpheres()
+{
+    const int sphereCount = 1000;
+    GLfloat white[3] = {1.0f, 1.0f, 1.0f};
+
+    std::vector<ProceduralShape> shapes;
+    for(int i = 0; i < sphereCount; i++)
+    {
+        int segments = 8 + (i * 7) % 33;
+        shapes.push_back(ProceduralShape::Sphere(glm::vec3(0.0f), 1.0f, segments, segments / 2));
+    }
+
+    std::vector<TriangleMesh*> perSphere;
+    long perSphereBytes = 0;
+    BenchmarkClock::time_point start = BenchmarkClock::now();
+    for(int i = 0; i < sphereCount; i++)
+    {
+        perSphere.push_back(new TriangleMesh(GetSpherePhong((int)shapes[i].segments, (int)shapes[i].rings, 1.0), "_", white));
+        perSphereBytes += perSphere.back()->GetBufferBytes();
+    }
+    glFinish();
+    double perSphereSeconds = SecondsSince(start);
+    for(size_t i = 0; i < perSphere.size(); i++)
+    {
+        perSphere[i]->Release();
+        delete perSphere[i];
+    }
+
+    MeshCache cache;
+    start = BenchmarkClock::now();
+    for(int i = 0; i < sphereCount; i++)
+        cache.GetSphere((int)shapes[i].segments, (int)shapes[i].rings, "_", white);
+    glFinish();
+    double cachedSeconds = SecondsSince(start);
+    long cachedBytes = cache.bufferBytes;
+    int cachedMeshes = cache.MeshCount();
+    cache.Clear();
+
+    start = BenchmarkClock::now();
+    ProceduralShapes procedural(shapes, white);
+    glFinish();
+    double proceduralSeconds = SecondsSince(start);
+    long proceduralBytes = procedural.GetBufferBytes();
+    int proceduralDraws = procedural.GetDrawCount();
+    procedural.Release();
+
+    BenchmarkLog("%d spheres, a mesh each: %.1f ms, %.2f MB of vertex data", sphereCount, perSphereSeconds * 1000.0, perSphereBytes / (1024.0 * 1024.0));
+    BenchmarkLog("%d spheres, cached: %.1f ms, %d meshes, %.2f MB of vertex data", sphereCount, cachedSeconds * 1000.0, cachedMeshes, cachedBytes / (1024.0 * 1024.0));
+    BenchmarkLog("%d spheres, GPU: %.2f ms, %d draws, %.1f KB of instance data", sphereCount, proceduralSeconds * 1000.0, proceduralDraws, proceduralBytes / 1024.0);
+
+    //One sphere at a resolution where the vertex buffer alone is tens of megabytes
+    const int segments = 512;
+    const int rings = 256;
+    start = BenchmarkClock::now();
+    TriangleMesh detailed(GetSpherePhong(segments, rings, 1.0), "_", white);
+    glFinish();
+    double detailedSeconds = SecondsSince(start);
+    long detailedBytes = detailed.GetBufferBytes();
+    detailed.Release();
+
+    std::vector<ProceduralShape> one(1, ProceduralShape::Sphere(glm::vec3(0.0f), 1.0f, segments, rings));
+    start = BenchmarkClock::now();
+    ProceduralShapes detailedProcedural(one, white);
+    glFinish();
+    double detailedProceduralSeconds = SecondsSince(start);
+    detailedProcedural.Release();
+
+    BenchmarkLog("%dx%d sphere: CPU %.1f ms, %.1f MB. GPU %.2f ms, %d bytes", segments, rings, detailedSeconds * 1000.0,
+                 detailedBytes / (1024.0 * 1024.0), detailedProceduralSeconds * 1000.0, (int)sizeof(ProceduralShape));
+}
+
+/* Where line i of the debug line benchmark goes: a grid of short upright lines in front of the camera */
+void BenchmarkLineEnds(int i, glm::vec3& start, glm::vec3& end)
+{
+    float x = (i % 1000) * 0.02f - 10.0f;
+    float z = (i / 1000) * -0.02f;
+    start = glm::vec3(x, 0.0f, z);
+    end = glm::vec3(x, 0.1f, z);
+}
+
+/*
+ * A million lines a frame for a few frames through a DebugDraw of its own, against uploading the same
+ * lines as struct Vertex with glBufferData every frame and drawing them like a Lines mesh did.
+ * Draws into the back buffer, which is cleared before the next frame is drawn anyway.
+ */
+void BenchmarkDebugLines()
+{
+    const int lineCount = 1000000;
+    const int frames = 10;
+    GLfloat green[3] = {0.0f, 1.0f, 0.0f};
+    glm::mat4 view = camera.GetViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+
+    DebugDraw lines(lineCount);
+    double addSeconds = 0.0;
+    BenchmarkClock::time_point start = BenchmarkClock::now();
+    for(int f = 0; f < frames; f++)
+    {
+        BenchmarkClock::time_point addStart = BenchmarkClock::now();
+        for(int i = 0; i < lineCount; i++)
+        {
+            glm::vec3 lineStart, lineEnd;
+            BenchmarkLineEnds(i, lineStart, lineEnd);
+            lines.AddLine(lineStart, lineEnd, green);
+        }
+        addSeconds += SecondsSince(addStart);
+        lines.Flush(view, projection);
+    }
+    glFinish();
+    double batchedSeconds = SecondsSince(start);
+    bool persistent = lines.persistent;
+    lines.Release();
+
+    Shader unshaded("Shaders/Object.vert", "Shaders/Object.frag");
+    std::vector<struct Vertex> vertices(2 * lineCount);
+    GLuint VAO, VBO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(0, 3, GL_DOUBLE, GL_FALSE, sizeof(struct Vertex), (const GLvoid*) offsetof (struct Vertex, position));
+    glEnableVertexAttribArray(0);
+
+    start = BenchmarkClock::now();
+    for(int f = 0; f < frames; f++)
+    {
+        for(int i = 0; i < lineCount; i++)
+        {
+            glm::vec3 lineStart, lineEnd;
+            BenchmarkLineEnds(i, lineStart, lineEnd);
+            struct Vertex a = {{lineStart.x, lineStart.y, lineStart.z}, {0.0, 1.0, 0.0}, {0.0f, 0.0f}};
+            struct Vertex b = {{lineEnd.x, lineEnd.y, lineEnd.z}, {0.0, 1.0, 0.0}, {0.0f, 0.0f}};
+            vertices[2 * i] = a;
+            vertices[2 * i + 1] = b;
+        }
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(struct Vertex), &vertices[0], GL_STREAM_DRAW);
+
+        unshaded.Use();
+        glm::mat4 MVP = projection * view;
+        uniformBuffers.SetObject(MVP, glm::mat4(), glm::vec4(green[0], green[1], green[2], 1.0f));
+        glDrawArrays(GL_LINES, 0, (GLsizei)vertices.size());
+    }
+    glFinish();
+    double vertexSeconds = SecondsSince(start);
+
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    unshaded.Release();
+
+    BenchmarkLog("%d lines a frame, batched (%s): %.1f ms a frame, %.1f of it adding lines, %.1f MB a frame",
+                 lineCount, persistent ? "persistent" : "glBufferSubData", batchedSeconds * 1000.0 / frames, addSeconds * 1000.0 / frames,
+                 2.0 * lineCount * sizeof(DebugVertex) / (1024.0 * 1024.0));
+    BenchmarkLog("%d lines a frame, as struct Vertex: %.1f ms a frame, %.1f MB a frame",
+                 lineCount, vertexSeconds * 1000.0 / frames, 2.0 * lineCount * sizeof(struct Vertex) / (1024.0 * 1024.0));
+}
+
+/*
+ * The thunderbird's normals drawn both ways: a mesh of lines made from its vertices, two struct Vertex
+ * per normal like the old sphere normals mesh, against the geometry shader reading the model's own buffer.
+ */
+void BenchmarkNormalVisualiser()
+{
+    const int draws = 1000;
+    const float length = 0.2f;
+    GLfloat red[3] = {1.0f, 0.0f, 0.0f};
+    glm::mat4 view = camera.GetViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+
+    std::vector<struct Vertex> vertices = LoadOBJVertices("models/thunderbird.obj");
+    TriangleMesh mesh(vertices, (GLuint)0, red);
+    GraphicsObject object(&mesh, glm::vec3(0.0f), glm::quat());
+
+    std::vector<struct Vertex> lines(2 * vertices.size());
+    for(size_t v = 0; v < vertices.size(); v++)
+    {
+        glm::vec3 normal = glm::normalize(glm::vec3(vertices[v].normal[0], vertices[v].normal[1], vertices[v].normal[2]));
+        lines[2 * v] = vertices[v];
+        lines[2 * v + 1] = vertices[v];
+        for(int k = 0; k < 3; k++)
+            lines[2 * v + 1].position[k] += length * normal[k];
+    }
+    long lineBytes = lines.size() * sizeof(struct Vertex);
+
+    GLuint VAO, VBO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, lineBytes, &lines[0], GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_DOUBLE, GL_FALSE, sizeof(struct Vertex), (const GLvoid*) offsetof (struct Vertex, position));
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    Shader unshaded("Shaders/Object.vert", "Shaders/Object.frag");
+    glm::mat4 MVP = projection * view;
+    glFinish();
+    BenchmarkClock::time_point start = BenchmarkClock::now();
+    for(int d = 0; d < draws; d++)
+    {
+        unshaded.Use();
+        uniformBuffers.SetObject(MVP, glm::mat4(), glm::vec4(red[0], red[1], red[2], 1.0f));
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_LINES, 0, (GLsizei)lines.size());
+    }
+    glBindVertexArray(0);
+    glFinish();
+    double lineSeconds = SecondsSince(start);
+
+    NormalVisualiser visualiser(length, red);
+    glFinish();
+    start = BenchmarkClock::now();
+    for(int d = 0; d < draws; d++)
+        visualiser.Draw(object, view, projection);
+    glFinish();
+    double geometrySeconds = SecondsSince(start);
+
+    visualiser.Release();
+    unshaded.Release();
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    mesh.Release();
+
+    BenchmarkLog("Thunderbird normals (%d), line mesh: %.1f KB extra, %.3f ms a draw", (int)vertices.size(), lineBytes / 1024.0, lineSeconds * 1000.0 / draws);
+    BenchmarkLog("Thunderbird normals (%d), geometry shader: no extra memory, %.3f ms a draw", (int)vertices.size(), geometrySeconds * 1000.0 / draws);
+}
+
+/* Where the i'th of the uniform benchmark's cubes goes, in a 100 x 100 grid in front of the camera */
+glm::mat4 BenchmarkGridModel(int i)
+{
+    glm::mat4 model = glm::translate(glm::mat4(), glm::vec3((i % 100) * 0.2f - 10.0f, (i / 100) * 0.2f - 10.0f, -20.0f));
+    return glm::scale(model, glm::vec3(0.05f));
+}
+
+/*
+ * 10000 small cubes a frame, with each draw's matrices and colour set:
+ *  - as the objects used to, with a glGetUniformLocation and glUniform call per value,
+ *  - in ObjectUniforms slots copied in with glBufferSubData,
+ *  - in ObjectUniforms slots in the persistently mapped buffer.
+ * The submit time is the CPU (and driver) cost of issuing the draws; the total waits for the GPU as well.
+ */
+void BenchmarkUniformUpload()
+{
+    const int draws = 10000;
+    const int frames = 20;
+    GLfloat white[3] = {1.0f, 1.0f, 1.0f};
+    glm::mat4 view = camera.GetViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+
+    std::vector<struct Vertex> cube = GetCubeGeometry(1.0);
+    GLuint VAO, VBO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, cube.size() * sizeof(struct Vertex), &cube[0], GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_DOUBLE, GL_FALSE, sizeof(struct Vertex), (const GLvoid*) offsetof (struct Vertex, position));
+    glEnableVertexAttribArray(0);
+
+    Shader plain("Shaders/UnshadedUniforms.vert", "Shaders/UnshadedUniforms.frag");
+    Shader blocks("Shaders/Object.vert", "Shaders/Object.frag");
+    const char* names[3] = {"glUniform", "glBufferSubData", "persistent"};
+    double submitSeconds[3] = {0.0, 0.0, 0.0};
+    double totalSeconds[3] = {0.0, 0.0, 0.0};
+    bool wasPersistent = uniformBuffers.usePersistentMapping;
+
+    for(int method = 0; method < 3; method++)
+    {
+        if(method > 0)
+        {
+            //Remake the shared buffer the way this run wants it
+            uniformBuffers.Release();
+            uniformBuffers.usePersistentMapping = (method == 2);
+            uniformBuffers.SetFrame(camera.GetCameraPosition());
+            if(method == 2 && !uniformBuffers.persistent)
+                names[method] = "glBufferSubData (no buffer storage)";
+            blocks.Use();
+        }
+        else
+        {
+            plain.Use();
+        }
+        glFinish();
+
+        for(int f = 0; f < frames; f++)
+        {
+            BenchmarkClock::time_point start = BenchmarkClock::now();
+            for(int i = 0; i < draws; i++)
+            {
+                glm::mat4 model = BenchmarkGridModel(i);
+                glm::mat4 MVP = projection * view * model;
+                if(method == 0)
+                {
+                    glUniformMatrix4fv(glGetUniformLocation(plain.getShaderProgram(), "MVPmatrix"), 1, GL_FALSE, glm::value_ptr(MVP));
+                    glUniformMatrix4fv(glGetUniformLocation(plain.getShaderProgram(), "modelMatrix"), 1, GL_FALSE, glm::value_ptr(model));
+                    glUniform4f(glGetUniformLocation(plain.getShaderProgram(), "baseColour"), white[0], white[1], white[2], 1.0f);
+                }
+                else
+                {
+                    uniformBuffers.SetObject(MVP, model, glm::vec4(white[0], white[1], white[2], 1.0f));
+                }
+                glDrawArrays(GL_TRIANGLES, 0, (GLsizei)cube.size());
+            }
+            if(method > 0)
+                uniformBuffers.EndFrame();
+            submitSeconds[method] += SecondsSince(start);
+            glFinish();
+            totalSeconds[method] += SecondsSince(start);
+        }
+    }
+
+    uniformBuffers.Release();
+    uniformBuffers.usePersistentMapping = wasPersistent;
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    plain.Release();
+    blocks.Release();
+
+    for(int method = 0; method < 3; method++)
+        BenchmarkLog("%d draws, %s: %.2f ms to submit, %.2f ms in all", draws, names[method],
+                     submitSeconds[method] * 1000.0 / frames, totalSeconds[method] * 1000.0 / frames);
+}
+
+/* A program the demo uses, for the shader benchmarks */
+struct BenchmarkProgram
+{
+    const char* vertex;
+    const char* geometry;
+    const char* fragment;
+    unsigned features;
+};
+
+const BenchmarkProgram BENCHMARK_PROGRAMS[] =
+{
+    {"Shaders/Object.vert", NULL, "Shaders/Object.frag", 0},
+    {"Shaders/Object.vert", NULL, "Shaders/Object.frag", SHADER_TEXTURED},
+    {"Shaders/Object.vert", NULL, "Shaders/Object.frag", SHADER_LIT},
+    {"Shaders/Object.vert", NULL, "Shaders/Object.frag", SHADER_PROCEDURAL | SHADER_LIT},
+    {"Shaders/NormalLines.vert", "Shaders/NormalLines.geom", "Shaders/Object.frag", 0},
+    {"Shaders/DebugLines.vert", NULL, "Shaders/DebugLines.frag", 0},
+    {"Shaders/UnshadedUniforms.vert", NULL, "Shaders/UnshadedUniforms.frag", 0}
+};
+
+const int BENCHMARK_PROGRAM_COUNT = sizeof(BENCHMARK_PROGRAMS) / sizeof(BENCHMARK_PROGRAMS[0]);
+
+/*
+ * Every program the demo uses, built from source and then from the program binary cache.
+ * The driver may have a shader cache of its own, which makes the cold numbers better than a true first run.
+ */
+void BenchmarkShaderCache()
+{
+    const int rounds = 5;
+
+    if(!shaderCache.Available())
+    {
+        BenchmarkLog("Shader cache: the driver has no program binary formats");
+        return;
+    }
+
+    //One untimed pass to make sure every program is in the cache, then compile them all, then load them all
+    double seconds[3] = {0.0, 0.0, 0.0};
+    int hits = 0;
+    for(int pass = 0; pass < 3; pass++)
+    {
+        shaderCache.enabled = (pass != 1);
+        int hitsBefore = shaderCache.hits;
+        BenchmarkClock::time_point start = BenchmarkClock::now();
+        for(int r = 0; r < (pass == 0 ? 1 : rounds); r++)
+        {
+            for(int p = 0; p < BENCHMARK_PROGRAM_COUNT; p++)
+            {
+                const BenchmarkProgram& program = BENCHMARK_PROGRAMS[p];
+                Shader shader(program.vertex, program.geometry, program.fragment, Shader::FeatureDefines(program.features), true);
+                shader.Release();
+            }
+        }
+        seconds[pass] = SecondsSince(start);
+        if(pass == 2)
+            hits = shaderCache.hits - hitsBefore;
+    }
+    shaderCache.enabled = true;
+
+    BenchmarkLog("%d programs compiled: %.2f ms", BENCHMARK_PROGRAM_COUNT, seconds[1] * 1000.0 / rounds);
+    BenchmarkLog("%d programs from the binary cache: %.2f ms (%d of %d hit)", BENCHMARK_PROGRAM_COUNT, seconds[2] * 1000.0 / rounds, hits, rounds * BENCHMARK_PROGRAM_COUNT);
+}
+
+/*
+ * Dozens of program variants built one after another, each waiting for its compile and link, against
+ * all of them started together through a ShaderManager. The binary cache is off, and every variant gets
+ * a #define no run has used before so the driver can't have any of them cached either.
+ */
+void BenchmarkShaderCompile()
+{
+    const int copies = 7;
+    const int variants = copies * BENCHMARK_PROGRAM_COUNT;
+    //Different every launch, as drivers keep their caches on disk
+    static long long run = (long long)std::chrono::system_clock::now().time_since_epoch().count();
+
+    shaderCache.enabled = false;
+    double seconds[2] = {0.0, 0.0};
+    double submitSeconds = 0.0;
+    ShaderManager manager;
+    for(int parallel = 0; parallel < 2; parallel++)
+    {
+        run++;
+        glFinish();
+        BenchmarkClock::time_point start = BenchmarkClock::now();
+        for(int v = 0; v < variants; v++)
+        {
+            const BenchmarkProgram& program = BENCHMARK_PROGRAMS[v % BENCHMARK_PROGRAM_COUNT];
+            std::string defines = Shader::FeatureDefines(program.features) + "#define SHADER_VARIANT " + std::to_string(v) + "\n#define BENCHMARK_RUN " + std::to_string(run) + "\n";
+            if(parallel)
+            {
+                manager.Add(program.vertex, program.geometry, program.fragment, defines);
+            }
+            else
+            {
+                Shader shader(program.vertex, program.geometry, program.fragment, defines, true);
+                shader.Release();
+            }
+        }
+        if(parallel)
+        {
+            submitSeconds = SecondsSince(start);
+            manager.FinishAll();
+        }
+        seconds[parallel] = SecondsSince(start);
+    }
+    shaderCache.enabled = true;
+
+    BenchmarkLog("%d shader variants one at a time: %.1f ms", variants, seconds[0] * 1000.0);
+    BenchmarkLog("%d shader variants started together (%s): %.1f ms, %.1f of it starting them, slowest ready after %.1f ms",
+                 variants, manager.ParallelCompile() ? "parallel compile" : "no parallel compile", seconds[1] * 1000.0, submitSeconds * 1000.0, manager.SlowestSeconds() * 1000.0);
+    manager.PrintTimes();
+    manager.Release();
+}
+
+/*
+ * GPU time for each permutation of the object shaders on the meshes from the first scenes (the crate sphere)
+ * and the imported mesh (the thunderbird), drawn big enough to fill most of the screen many times over,
+ * so the time is mostly fragment shading. Measured with GL_TIME_ELAPSED queries.
+ */
+void BenchmarkShaderPermutations()
+{
+    const int layers = 50;
+    const unsigned variants[4] = {0, SHADER_TEXTURED, SHADER_LIT, SHADER_TEXTURED | SHADER_LIT};
+    GLfloat white[3] = {1.0f, 1.0f, 1.0f};
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 2.5f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+
+    TriangleMesh thunderbirdMesh(LoadOBJVertices("models/thunderbird.obj"), "Images/thunderbird.png", white);
+    GraphicsObject objects[2] =
+    {
+        GraphicsObject(meshCache.GetSphere(30, 10, "Images/crate.png", white), glm::vec3(0.0f), glm::quat()),
+        GraphicsObject(&thunderbirdMesh, glm::vec3(0.0f), glm::quat(), 0.4f)
+    };
+    const char* names[2] = {"Crate sphere", "Thunderbird"};
+
+    ShaderManager manager;
+    ShaderPermutations permutations("Shaders/Object.vert", NULL, "Shaders/Object.frag", manager);
+    for(int v = 0; v < 4; v++)
+        permutations.Prepare(variants[v]);
+
+    GLuint query;
+    glGenQueries(1, &query);
+    glDisable(GL_DEPTH_TEST);
+    bool wasLod = lodEnabled;
+    lodEnabled = false;
+    for(int o = 0; o < 2; o++)
+    {
+        double unshaded = 0.0;
+        for(int v = 0; v < 4; v++)
+        {
+            //Once untimed so the driver has done any work it puts off to the first draw
+            objects[o].Draw(permutations, variants[v], view, projection);
+            glFinish();
+
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            for(int l = 0; l < layers; l++)
+                objects[o].Draw(permutations, variants[v], view, projection);
+            glEndQuery(GL_TIME_ELAPSED);
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+
+            double milliseconds = nanoseconds / 1.0e6 / layers;
+            if(v == 0)
+                unshaded = milliseconds;
+            BenchmarkLog("%s, %s: %.3f ms a layer on the GPU (x%.2f)", names[o], ShaderPermutations::FeatureNames(variants[v]).c_str(),
+                         milliseconds, unshaded > 0.0 ? milliseconds / unshaded : 1.0);
+        }
+    }
+    lodEnabled = wasLod;
+    glEnable(GL_DEPTH_TEST);
+    glDeleteQueries(1, &query);
+
+    //Meshes without a texture never pay for the fetch, whatever they're asked to draw with
+    Mesh* untextured = meshCache.GetSphere(20, 20, "_", white);
+    BenchmarkLog("Solar system sun asked for TEXTURED + LIT draws with %s", ShaderPermutations::FeatureNames(untextured->GetShaderFeatures(SHADER_TEXTURED | SHADER_LIT)).c_str());
+
+    manager.Release();
+    thunderbirdMesh.Release();
+}
+
+/* One of the texture benchmark's stand-in textures: smooth gradients, some hard edges and a little noise, opaque */
+RGBAImage BenchmarkTextureImage(int size, int seed)
+{
+    RGBAImage image;
+    image.width = image.height = size;
+    image.pixels.resize(size * size * 4);
+    for(int y = 0; y < size; y++)
+    {
+        for(int x = 0; x < size; x++)
+        {
+            unsigned int hash = (x * 73856093u) ^ (y * 19349663u) ^ (seed * 83492791u);
+            int noise = (int)((hash * 2654435761u) >> 28) - 8;
+            unsigned char* pixel = &image.pixels[(y * size + x) * 4];
+            pixel[0] = (unsigned char)std::max(0, std::min(255, (int)(128.0 + 120.0 * sin(x * 0.011 + seed)) + noise));
+            pixel[1] = (unsigned char)std::max(0, std::min(255, (int)(128.0 + 120.0 * sin(y * 0.017 + seed * 0.7)) + noise));
+            pixel[2] = (unsigned char)(((x / 64 + y / 64 + seed) & 1) ? 200 : 40);
+            pixel[3] = 255;
+        }
+    }
+    return image;
+}
+
+/*
+ * Baked (block-compressed KTX2) textures against PNGs. First the shipped images, loaded both ways from disk,
+ * which needs them baked with Tools/TextureBaker first. Then a set of large generated textures: how fast the
+ * baker gets through them on one thread and on the job system, and uploading them compressed with every level
+ * against uploading RGB and calling glGenerateMipmap, which is what loading the PNGs ends with.
+ */
+void BenchmarkTextureBaking()
+{
+    const char* images[2] = {"Images/glowstone.png", "Images/thunderbird.png"};
+    const int rounds = 10;
+    bool wasBaked = useBakedTextures;
+    for(int i = 0; i < 2; i++)
+    {
+        KTX2Texture baked;
+        if(!ReadKTX2(BakedTexturePath(images[i]), baked))
+        {
+            BenchmarkLog("%s: not baked, run TextureBaker on it first", images[i]);
+            continue;
+        }
+
+        double seconds[2] = {0.0, 0.0};
+        long bytes[2] = {0, 0};
+        for(int useBaked = 0; useBaked < 2; useBaked++)
+        {
+            useBakedTextures = (useBaked == 1);
+            glFinish();
+            BenchmarkClock::time_point start = BenchmarkClock::now();
+            for(int r = 0; r < rounds; r++)
+            {
+                GLuint texture = LoadTextureFile(images[i], &bytes[useBaked]);
+                glFinish();
+                glDeleteTextures(1, &texture);
+                perfStats.ReleaseTexture(bytes[useBaked]);
+            }
+            seconds[useBaked] = SecondsSince(start) / rounds;
+        }
+        BenchmarkLog("%s: PNG %.2f ms, %ld KB; %s KTX2 %.2f ms, %ld KB (%.0f%% less)", images[i], seconds[0] * 1000.0, bytes[0] / 1024,
+                     BLOCK_FORMAT_NAMES[baked.format], seconds[1] * 1000.0, bytes[1] / 1024, 100.0 - 100.0 * bytes[1] / std::max(bytes[0], 1L));
+    }
+    useBakedTextures = wasBaked;
+
+    //The large set, baked to BC1 and BC7
+    const int count = 8, size = 1024;
+    std::vector<RGBAImage> sources;
+    for(int i = 0; i < count; i++)
+        sources.push_back(BenchmarkTextureImage(size, i));
+    double pixels = (double)count * size * size * 4.0 / 3.0;
+
+    std::vector<KTX2Texture> bakedSets[2];
+    const BlockFormat formats[2] = {BLOCK_BC1, BLOCK_BC7};
+    for(int f = 0; f < 2; f++)
+    {
+        double seconds[2] = {0.0, 0.0};
+        double psnr = 0.0;
+        for(int threaded = 0; threaded < 2; threaded++)
+        {
+            bakedSets[f].assign(count, KTX2Texture());
+            BenchmarkClock::time_point start = BenchmarkClock::now();
+            for(int i = 0; i < count; i++)
+            {
+                std::vector<RGBAImage> mips = BuildMipChain(sources[i]);
+                bakedSets[f][i].format = formats[f];
+                bakedSets[f][i].width = bakedSets[f][i].height = size;
+                for(size_t l = 0; l < mips.size(); l++)
+                    bakedSets[f][i].levels.push_back(CompressImage(mips[l], formats[f], threaded ? &jobSystem : NULL));
+            }
+            seconds[threaded] = SecondsSince(start);
+        }
+        for(int i = 0; i < count; i++)
+            psnr += ImagePSNR(sources[i], DecompressImage(bakedSets[f][i].levels[0], formats[f], size, size), 3) / count;
+        BenchmarkLog("Baking %d %dx%d textures to %s: %.0f ms on 1 thread, %.0f ms on %d (%.1f Mpixels/s), %.1f dB", count, size, size,
+                     BLOCK_FORMAT_NAMES[formats[f]], seconds[0] * 1000.0, seconds[1] * 1000.0, jobSystem.ThreadCount(), pixels / seconds[1] / 1.0e6, psnr);
+    }
+
+    //Uploads: RGB plus glGenerateMipmap, then each baked set
+    GLuint textures[count];
+    long uncompressedBytes = 0;
+    glFinish();
+    BenchmarkClock::time_point start = BenchmarkClock::now();
+    for(int i = 0; i < count; i++)
+    {
+        textures[i] = CreateMeshTexture();
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, sources[i].pixels.data());
+        glGenerateMipmap(GL_TEXTURE_2D);
+        uncompressedBytes += perfStats.AddTexture(size, size, 3, true);
+    }
+    glFinish();
+    double uncompressedSeconds = SecondsSince(start);
+    glDeleteTextures(count, textures);
+    perfStats.ReleaseTexture(uncompressedBytes);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    BenchmarkLog("Uploading %d %dx%d RGB textures and making mipmaps: %.1f ms, %ld MB", count, size, size, uncompressedSeconds * 1000.0, uncompressedBytes >> 20);
+
+    for(int f = 0; f < 2; f++)
+    {
+        if(!BlockFormatSupported(formats[f]))
+        {
+            BenchmarkLog("No driver support for %s", BLOCK_FORMAT_NAMES[formats[f]]);
+            continue;
+        }
+        long bytes = 0;
+        glFinish();
+        start = BenchmarkClock::now();
+        for(int i = 0; i < count; i++)
+        {
+            long textureBytes;
+            textures[i] = UploadCompressedTexture(bakedSets[f][i], &textureBytes);
+            bytes += textureBytes;
+        }
+        glFinish();
+        double seconds = SecondsSince(start);
+        glDeleteTextures(count, textures);
+        perfStats.ReleaseTexture(bytes);
+        BenchmarkLog("Uploading them baked to %s with every level: %.1f ms, %.1f MB (%.0f%% less)", BLOCK_FORMAT_NAMES[formats[f]], seconds * 1000.0,
+                     bytes / 1048576.0, 100.0 - 100.0 * bytes / uncompressedBytes);
+    }
+}
+
+/* Where the i'th of the texture array benchmark's cubes goes, in a 64 x 64 grid in front of the camera */
+glm::mat4 BenchmarkTextureGridModel(int i)
+{
+    glm::mat4 model = glm::translate(glm::mat4(), glm::vec3((i % 64) * 0.25f - 8.0f, (i / 64) * 0.25f - 8.0f, -20.0f));
+    return glm::scale(model, glm::vec3(0.2f));
+}
+
+/*
+ * 4096 cubes, each with one of 256 different 64x64 textures, drawn through GraphicsObject like the scenes:
+ *  - a TriangleMesh per texture, each with its own GL_TEXTURE_2D that's bound for every draw,
+ *  - the same meshes textured from the layers of one texture array, so a draw only sets its layer,
+ *  - one InstancedMesh with a layer per instance, so the whole lot is one draw.
+ */
+void BenchmarkTextureArrays()
+{
+    const int cubes = 4096;
+    const int textures = 256;
+    const int frames = 20;
+    GLfloat white[3] = {1.0f, 1.0f, 1.0f};
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+    std::vector<struct Vertex> cube(CUBE_VERTICES, CUBE_VERTICES + CUBE_VERTEX_COUNT);
+
+    TextureArrays arrays;
+    std::vector<TriangleMesh*> separateMeshes, layerMeshes;
+    std::vector<GLuint> separateTextures;
+    std::vector<TextureSlot> slots;
+    long separateBytes = 0;
+    for(int t = 0; t < textures; t++)
+    {
+        RGBAImage image = BenchmarkTextureImage(64, t);
+        GLuint texture = CreateMeshTexture();
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        separateBytes += perfStats.AddTexture(image.width, image.height, 3, true);
+        separateTextures.push_back(texture);
+        separateMeshes.push_back(new TriangleMesh(cube, texture, white));
+
+        slots.push_back(arrays.Add(image));
+        layerMeshes.push_back(new TriangleMesh(CUBE_VERTICES, CUBE_VERTEX_COUNT, slots.back(), white));
+    }
+    if(arrays.ArrayCount() != 1)
+        BenchmarkLog("Texture arrays: the textures needed %d arrays, so the instanced draw can't be run", arrays.ArrayCount());
+
+    std::vector<GraphicsObject> separateObjects, layerObjects;
+    std::vector<MeshInstance> instances;
+    for(int i = 0; i < cubes; i++)
+    {
+        glm::mat4 model = BenchmarkTextureGridModel(i);
+        separateObjects.push_back(GraphicsObject(separateMeshes[i % textures], glm::vec3(model[3]), glm::quat(), 0.2f));
+        layerObjects.push_back(GraphicsObject(layerMeshes[i % textures], glm::vec3(model[3]), glm::quat(), 0.2f));
+        MeshInstance instance = {model, slots[i % textures].layer};
+        instances.push_back(instance);
+    }
+    InstancedMesh instancedMesh(CUBE_VERTICES, CUBE_VERTEX_COUNT, slots[0].array, instances, white);
+    GraphicsObject instancedObject(&instancedMesh, glm::vec3(0.0f), glm::quat());
+
+    //Bound textures for the first way, even where there are bindless handles
+    bool wasBindless = bindlessTextures.enabled;
+    bindlessTextures.enabled = false;
+    ShaderManager manager;
+    ShaderPermutations permutations("Shaders/Object.vert", NULL, "Shaders/Object.frag", manager);
+    const char* names[3] = {"a texture each", "texture array layers", "one instanced draw"};
+    const int methods = arrays.ArrayCount() == 1 ? 3 : 2;
+    for(int method = 0; method < methods; method++)
+    {
+        //Once untimed, to compile the permutation and let the driver settle
+        for(int pass = 0; pass < 2; pass++)
+        {
+            int drawsBefore = perfStats.drawCalls, changesBefore = perfStats.stateChanges;
+            double submitSeconds = 0.0, totalSeconds = 0.0;
+            int passFrames = (pass == 0) ? 1 : frames;
+            glFinish();
+            for(int f = 0; f < passFrames; f++)
+            {
+                BenchmarkClock::time_point start = BenchmarkClock::now();
+                if(method == 2)
+                {
+                    instancedObject.Draw(permutations, SHADER_TEXTURED, view, projection);
+                }
+                else
+                {
+                    std::vector<GraphicsObject>& objects = (method == 0) ? separateObjects : layerObjects;
+                    for(int i = 0; i < cubes; i++)
+                        objects[i].Draw(permutations, SHADER_TEXTURED, view, projection);
+                }
+                uniformBuffers.EndFrame();
+                submitSeconds += SecondsSince(start);
+                glFinish();
+                totalSeconds += SecondsSince(start);
+            }
+            if(pass == 1)
+                BenchmarkLog("%d cubes, %s: %.2f ms to submit, %.2f ms in all, %d draws and %d state changes a frame", cubes, names[method],
+                             submitSeconds * 1000.0 / frames, totalSeconds * 1000.0 / frames,
+                             (perfStats.drawCalls - drawsBefore) / frames, (perfStats.stateChanges - changesBefore) / frames);
+        }
+    }
+    BenchmarkLog("%d textures: %ld KB as separate textures, %ld KB in %d texture array", textures,
+                 separateBytes / 1024, arrays.GetBytes() / 1024, arrays.ArrayCount());
+    bindlessTextures.enabled = wasBindless;
+
+    manager.Release();
+    instancedMesh.Release();
+    for(int t = 0; t < textures; t++)
+    {
+        separateMeshes[t]->Release();
+        layerMeshes[t]->Release();
+        delete separateMeshes[t];
+        delete layerMeshes[t];
+        bindlessTextures.Release(separateTextures[t]);
+    }
+    glDeleteTextures(textures, separateTextures.data());
+    perfStats.ReleaseTexture(separateBytes);
+    arrays.Release();
+    textureArrays.Bind(0);
+}
+
+/*
+ * Draw submission for 4096 cubes with 256 different textures, each bound before its draw and then named by
+ * its bindless handle in ObjectUniforms. Same meshes, objects and shaders otherwise.
+ */
+void BenchmarkBindlessTextures()
+{
+    const int cubes = 4096;
+    const int textures = 256;
+    const int frames = 20;
+    GLfloat white[3] = {1.0f, 1.0f, 1.0f};
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+
+    if(!GLEW_ARB_bindless_texture)
+    {
+        BenchmarkLog("Bindless textures: the driver doesn't have GL_ARB_bindless_texture, so every texture is bound");
+        return;
+    }
+
+    //The meshes take their handles as they're made
+    std::vector<struct Vertex> cube(CUBE_VERTICES, CUBE_VERTICES + CUBE_VERTEX_COUNT);
+    std::vector<GLuint> textureIds;
+    std::vector<TriangleMesh*> meshes;
+    for(int t = 0; t < textures; t++)
+    {
+        RGBAImage image = BenchmarkTextureImage(64, t);
+        GLuint texture = CreateMeshTexture();
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        textureIds.push_back(texture);
+        meshes.push_back(new TriangleMesh(cube, texture, white));
+    }
+    std::vector<GraphicsObject> objects;
+    for(int i = 0; i < cubes; i++)
+        objects.push_back(GraphicsObject(meshes[i % textures], glm::vec3(BenchmarkTextureGridModel(i)[3]), glm::quat(), 0.2f));
+
+    ShaderManager manager;
+    ShaderPermutations permutations("Shaders/Object.vert", NULL, "Shaders/Object.frag", manager);
+    bool wasBindless = bindlessTextures.enabled;
+    for(int bindless = 0; bindless < 2; bindless++)
+    {
+        bindlessTextures.enabled = (bindless == 1);
+        //Once untimed, to compile the permutation and let the driver settle
+        for(int pass = 0; pass < 2; pass++)
+        {
+            int changesBefore = perfStats.stateChanges;
+            double submitSeconds = 0.0, totalSeconds = 0.0;
+            int passFrames = (pass == 0) ? 1 : frames;
+            glFinish();
+            for(int f = 0; f < passFrames; f++)
+            {
+                BenchmarkClock::time_point start = BenchmarkClock::now();
+                for(int i = 0; i < cubes; i++)
+                    objects[i].Draw(permutations, SHADER_TEXTURED, view, projection);
+                uniformBuffers.EndFrame();
+                submitSeconds += SecondsSince(start);
+                glFinish();
+                totalSeconds += SecondsSince(start);
+            }
+            if(pass == 1)
+                BenchmarkLog("%d cubes, %s: %.2f ms to submit, %.2f ms in all, %d state changes a frame", cubes,
+                             bindless ? "bindless handles" : "bound textures", submitSeconds * 1000.0 / frames,
+                             totalSeconds * 1000.0 / frames, (perfStats.stateChanges - changesBefore) / frames);
+        }
+    }
+    bindlessTextures.enabled = wasBindless;
+
+    manager.Release();
+    for(int t = 0; t < textures; t++)
+    {
+        meshes[t]->Release();
+        delete meshes[t];
+        bindlessTextures.Release(textureIds[t]);
+    }
+    glDeleteTextures(textures, textureIds.data());
+}
+
+/* Drop a file from the OS's cache so the next read comes from the disk. Only Linux lets a program do that */
+bool EvictFileCache(const std::string& path)
+{
+#ifdef __linux__
+    int file = open(path.c_str(), O_RDONLY);
+    if(file < 0)
+        return false;
+    bool evicted = posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(file);
+    return evicted;
+#else
+    return false;
+#endif
+}
+
+/* Read a byte from every cache line, so a mapped asset has really been read in */
+unsigned BenchmarkTouch(const Asset& asset)
+{
+    unsigned sum = 0;
+    for(size_t i = 0; i < asset.size; i += 64)
+        sum += asset.data[i];
+    return sum;
+}
+
+/*
+ * Reading every startup asset from assets.pack against reading the loose files it was made from.
+ * Cold has every file dropped from the OS cache first (where that's possible), warm has them all cached.
+ * The pack is mapped afresh each time either way, as it would be at startup. Then the cost of a lookup by itself.
+ */
+void BenchmarkAssetPack()
+{
+    if(!assetPack.IsOpen())
+    {
+        BenchmarkLog("Asset pack: no %s, run AssetPacker models Images Shaders first", ASSET_PACK_PATH);
+        return;
+    }
+
+    std::string packPath = assetPack.GetPath();
+    std::vector<std::string> names;
+    long assetBytes = 0;
+    int compressed = 0;
+    for(int e = 0; e < assetPack.EntryCount(); e++)
+    {
+        names.push_back(assetPack.GetName(e));
+        assetBytes += assetPack.GetEntry(e).size;
+        if(assetPack.GetEntry(e).flags & ASSET_LZ4)
+            compressed++;
+    }
+    BenchmarkLog("%s: %d assets (%d LZ4), %.1f KB of assets in a %.1f KB file", packPath.c_str(), (int)names.size(), compressed,
+                 assetBytes / 1024.0, assetPack.GetBytes() / 1024.0);
+
+    const int rounds = 20;
+    bool wasUsingPack = useAssetPack;
+    bool evicted = true;
+    unsigned checksum = 0;
+    for(int packed = 0; packed < 2; packed++)
+    {
+        useAssetPack = (packed == 1);
+        double seconds[2] = {0.0, 0.0};
+        for(int warm = 0; warm < 2; warm++)
+        {
+            for(int r = 0; r < rounds; r++)
+            {
+                //The pack has to be unmapped for the OS to let its pages go
+                assetPack.Close();
+                if(!warm)
+                {
+                    evicted = EvictFileCache(packPath) && evicted;
+                    for(size_t n = 0; n < names.size(); n++)
+                        evicted = EvictFileCache(names[n]) && evicted;
+                }
+
+                BenchmarkClock::time_point start = BenchmarkClock::now();
+                if(packed)
+                    assetPack.Open(packPath);
+                for(size_t n = 0; n < names.size(); n++)
+                {
+                    Asset asset;
+                    if(LoadAsset(names[n], asset))
+                        checksum += BenchmarkTouch(asset);
+                }
+                seconds[warm] += SecondsSince(start) / rounds;
+            }
+        }
+        BenchmarkLog("%s: %.2f ms cold, %.2f ms warm", packed ? "Asset pack" : "Loose files", seconds[0] * 1000.0, seconds[1] * 1000.0);
+    }
+    useAssetPack = wasUsingPack;
+    if(!assetPack.IsOpen())
+        assetPack.Open(packPath);
+    if(!evicted)
+        BenchmarkLog("Couldn't drop the files from the OS cache here, so cold is really warm too");
+
+    //Lookups alone, without reading anything
+    const int lookups = 100000;
+    int found = 0;
+    BenchmarkClock::time_point start = BenchmarkClock::now();
+    for(int l = 0; l < lookups; l++)
+        if(assetPack.Find(names[l % names.size()]) != NULL)
+            found++;
+    BenchmarkLog("%d lookups: %.0f ns each (%d found, checksum %u)", lookups, SecondsSince(start) * 1e9 / lookups, found, checksum);
+}
+
+/*
+ * A stress scene for texture streaming: 256 cubes in a 16x16 grid, each with its own 1024x1024 texture
+ * (made from 16 different images), far more than fits in the budget at full size. The camera flies low over
+ * the grid and every second of frames the resident memory and upload bandwidth are logged.
+ */
+void BenchmarkTextureStreaming()
+{
+    const int textures = 256, images = 16, size = 1024;
+    const int frames = 600, reportEvery = 60;
+    const float spacing = 2.5f;
+    GLfloat white[3] = {1.0f, 1.0f, 1.0f};
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+
+    //The sources stay in memory for the textures to stream from, as they would on disk
+    std::vector<std::vector<RGBAImage> > chains(images);
+    for(int i = 0; i < images; i++)
+        chains[i] = BuildMipChain(BenchmarkTextureImage(size, i));
+
+    //A streamer of its own, so the demo's streamed textures are left alone and don't count
+    TextureStreamer demoTextures;
+    std::swap(textureStreamer, demoTextures);
+    textureStreamer.budgetBytes = demoTextures.budgetBytes;
+    textureStreamer.uploadBytesPerFrame = demoTextures.uploadBytesPerFrame;
+    long uploadedBefore = textureStreamer.uploadedBytes, copiedBefore = textureStreamer.copiedBytes;
+    int reallocationsBefore = textureStreamer.reallocations;
+    std::vector<TriangleMesh*> meshes;
+    std::vector<GraphicsObject> objects;
+    for(int t = 0; t < textures; t++)
+    {
+        meshes.push_back(new TriangleMesh(CUBE_VERTICES, CUBE_VERTEX_COUNT, textureStreamer.Add(&chains[t % images]), white));
+        glm::vec3 position((t % 16 - 7.5f) * spacing, 0.0f, (t / 16 - 7.5f) * spacing);
+        objects.push_back(GraphicsObject(meshes[t], position, glm::quat(), 2.0f));
+    }
+    BenchmarkLog("Texture streaming: %d textures, %.0f MB at full size, %.0f MB budget, %.1f MB to start with", textures,
+                 textureStreamer.GetFullBytes() / 1048576.0, textureStreamer.budgetBytes / 1048576.0, textureStreamer.residentBytes / 1048576.0);
+
+    ShaderManager manager;
+    ShaderPermutations permutations("Shaders/Object.vert", NULL, "Shaders/Object.frag", manager);
+    long peakBytes = 0, periodBytes = 0;
+    double periodSeconds = 0.0, updateSeconds = 0.0, totalSeconds = 0.0;
+    for(int f = 0; f < frames; f++)
+    {
+        //Along the grid and back, weaving from side to side, a few units above the cubes and looking down ahead
+        float along = (f < frames / 2) ? (float)f / (frames / 2) : 2.0f - (float)f / (frames / 2);
+        float direction = (f < frames / 2) ? 1.0f : -1.0f;
+        glm::vec3 eye(12.0f * sinf(f * 0.02f), 3.0f, (along - 0.5f) * 16.0f * spacing);
+        glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(0.0f, -0.6f, direction), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        BenchmarkClock::time_point start = BenchmarkClock::now();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        for(size_t i = 0; i < objects.size(); i++)
+            objects[i].Draw(permutations, SHADER_TEXTURED, view, projection);
+        uniformBuffers.EndFrame();
+        BenchmarkClock::time_point updateStart = BenchmarkClock::now();
+        textureStreamer.Update();
+        updateSeconds += SecondsSince(updateStart);
+        glFinish();
+        gpuResources.EndFrame();
+        double seconds = SecondsSince(start);
+
+        totalSeconds += seconds;
+        periodSeconds += seconds;
+        periodBytes += textureStreamer.uploadedThisFrame;
+        peakBytes = std::max(peakBytes, textureStreamer.residentBytes);
+        if((f + 1) % reportEvery == 0)
+        {
+            int full = 0;
+            for(int t = 0; t < textures; t++)
+                if(textureStreamer.GetResidentLevel(t) == 0)
+                    full++;
+            BenchmarkLog("Frame %d: %.1f MB resident, %d at full size, %.1f MB uploaded (%.0f MB/s)", f + 1, textureStreamer.residentBytes / 1048576.0,
+                         full, periodBytes / 1048576.0, periodBytes / 1048576.0 / std::max(periodSeconds, 1e-6));
+            periodBytes = 0;
+            periodSeconds = 0.0;
+        }
+    }
+    BenchmarkLog("%d frames in %.2f s: %.1f MB peak, %.1f MB uploaded, %.1f MB copied, %d reallocations, %.2f ms a frame in Update",
+                 frames, totalSeconds, peakBytes / 1048576.0, (textureStreamer.uploadedBytes - uploadedBefore) / 1048576.0,
+                 (textureStreamer.copiedBytes - copiedBefore) / 1048576.0, textureStreamer.reallocations - reallocationsBefore,
+                 updateSeconds * 1000.0 / frames);
+
+    manager.Release();
+    for(int t = 0; t < textures; t++)
+    {
+        meshes[t]->Release();
+        delete meshes[t];
+    }
+    textureStreamer.Release();
+    std::swap(textureStreamer, demoTextures);
+}
+
+/*
+ * Forward against deferred shading on a dense block of lit spheres, 24 x 24 across and 8 deep, drawn back to front
+ * so that forward shading lights every layer before the next one covers it. GPU time for each with 1, 64 and 1024
+ * point lights (on top of the main light), deferred split into the G-buffer pass and the lighting.
+ */
+void BenchmarkDeferredShading()
+{
+    const int across = 24, deep = 8, frames = 10;
+    const int lightCounts[3] = {1, 64, 1024};
+    GLfloat white[3] = {1.0f, 1.0f, 1.0f};
+    glm::vec3 eye(0.0f, 0.0f, 22.0f);
+    glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    std::vector<GraphicsObject> spheres;
+    Mesh* sphere = meshCache.GetSphere(20, 20, "_", white);
+    for(int z = deep - 1; z >= 0; z--)
+        for(int y = 0; y < across; y++)
+            for(int x = 0; x < across; x++)
+                spheres.push_back(GraphicsObject(sphere, glm::vec3(x - (across - 1) / 2.0f, y - (across - 1) / 2.0f, -z), glm::quat(), 0.45f));
+
+    ShaderManager manager;
+    ShaderPermutations permutations("Shaders/Object.vert", NULL, "Shaders/Object.frag", manager);
+    permutations.Prepare(SHADER_LIT | SHADER_POINT_LIGHTS);
+    permutations.Prepare(SHADER_LIT | SHADER_GBUFFER);
+
+    //1024 lights need a 32 KB uniform block, which not every driver has room for
+    GLint maxBlockBytes = 0;
+    glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxBlockBytes);
+
+    GLuint queries[2];
+    glGenQueries(2, queries);
+    PointLights lights;
+    uniformBuffers.SetFrame(eye);
+    bool wasLod = lodEnabled;
+    lodEnabled = false;
+    BenchmarkLog("Deferred shading: %d spheres, %dx%d, %.1f MB of G-buffer", (int)spheres.size(), viewport[2], viewport[3],
+                 12.0 * viewport[2] * viewport[3] / 1048576.0);
+    for(int c = 0; c < 3; c++)
+    {
+        lights.Scatter(lightCounts[c], glm::vec3(-12.0f, -12.0f, -8.0f), glm::vec3(12.0f, 12.0f, 1.0f), 2.5f, 7);
+        lights.Upload();
+        bool forwardFits = PointLights::GetUniformBlockBytes() <= maxBlockBytes;
+
+        //Forward, once untimed to settle, then timed
+        double forward = 0.0;
+        for(int f = 0; forwardFits && f <= frames; f++)
+        {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glBeginQuery(GL_TIME_ELAPSED, queries[0]);
+            for(size_t i = 0; i < spheres.size(); i++)
+                spheres[i].Draw(permutations, SHADER_LIT | SHADER_POINT_LIGHTS, view, projection);
+            glEndQuery(GL_TIME_ELAPSED);
+            uniformBuffers.EndFrame();
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &nanoseconds);
+            if(f > 0)
+                forward += nanoseconds / 1.0e6 / frames;
+        }
+
+        double geometry = 0.0, lighting = 0.0;
+        for(int f = 0; f <= frames; f++)
+        {
+            glBeginQuery(GL_TIME_ELAPSED, queries[0]);
+            deferredRenderer.BeginGeometry(viewport[2], viewport[3]);
+            for(size_t i = 0; i < spheres.size(); i++)
+                spheres[i].Draw(permutations, SHADER_LIT | SHADER_GBUFFER, view, projection);
+            glEndQuery(GL_TIME_ELAPSED);
+            glBeginQuery(GL_TIME_ELAPSED, queries[1]);
+            deferredRenderer.Light(view, projection, lights);
+            glEndQuery(GL_TIME_ELAPSED);
+            uniformBuffers.EndFrame();
+            GLuint64 nanoseconds[2] = {0, 0};
+            glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &nanoseconds[0]);
+            glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &nanoseconds[1]);
+            if(f > 0)
+            {
+                geometry += nanoseconds[0] / 1.0e6 / frames;
+                lighting += nanoseconds[1] / 1.0e6 / frames;
+            }
+        }
+
+        if(forwardFits)
+            BenchmarkLog("%d lights: forward %.3f ms, deferred %.3f ms (G-buffer %.3f, lighting %.3f) on the GPU", lightCounts[c], forward,
+                         geometry + lighting, geometry, lighting);
+        else
+            BenchmarkLog("%d lights: forward skipped (%d byte uniform blocks), deferred %.3f ms (G-buffer %.3f, lighting %.3f) on the GPU",
+                         lightCounts[c], maxBlockBytes, geometry + lighting, geometry, lighting);
+    }
+    lodEnabled = wasLod;
+    glDeleteQueries(2, queries);
+
+    manager.Release();
+    lights.Release();
+    //The scenes' own lights go back on the binding next time they're drawn
+    deferredRenderer.Release();
+}
+
+/*
+ * Clustered forward lighting with 1024 and 10000 point lights, on the same block of spheres as the deferred benchmark,
+ * drawn back to front the same way. CPU time to assign the lights to clusters on one thread and on the job system,
+ * then GPU time for clustered forward against deferred, and against plain forward where it can hold every light
+ * (which is 1024 at most).
+ */
+void BenchmarkClusteredLighting()
+{
+    if(!GLEW_ARB_shader_storage_buffer_object)
+    {
+        BenchmarkLog("Clustered lighting: skipped, no shader storage buffers");
+        return;
+    }
+
+    const int across = 24, deep = 8, frames = 10;
+    const int lightCounts[2] = {1024, 10000};
+    GLfloat white[3] = {1.0f, 1.0f, 1.0f};
+    glm::vec3 eye(0.0f, 0.0f, 22.0f);
+    glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    std::vector<GraphicsObject> spheres;
+    Mesh* sphere = meshCache.GetSphere(20, 20, "_", white);
+    for(int z = deep - 1; z >= 0; z--)
+        for(int y = 0; y < across; y++)
+            for(int x = 0; x < across; x++)
+                spheres.push_back(GraphicsObject(sphere, glm::vec3(x - (across - 1) / 2.0f, y - (across - 1) / 2.0f, -z), glm::quat(), 0.45f));
+
+    ShaderManager manager;
+    ShaderPermutations permutations("Shaders/Object.vert", NULL, "Shaders/Object.frag", manager);
+    permutations.Prepare(SHADER_LIT | SHADER_CLUSTERED);
+    permutations.Prepare(SHADER_LIT | SHADER_POINT_LIGHTS);
+    permutations.Prepare(SHADER_LIT | SHADER_GBUFFER);
+
+    GLint maxBlockBytes = 0;
+    glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxBlockBytes);
+
+    GLuint queries[2];
+    glGenQueries(2, queries);
+    PointLights lights;
+    LightClusters clusters;
+    uniformBuffers.SetFrame(eye);
+    bool wasLod = lodEnabled;
+    lodEnabled = false;
+    BenchmarkLog("Clustered lighting: %d spheres, %dx%d, %dx%dx%d clusters", (int)spheres.size(), viewport[2], viewport[3],
+                 CLUSTER_TILES_X, CLUSTER_TILES_Y, CLUSTER_SLICES);
+    for(int c = 0; c < 2; c++)
+    {
+        lights.Scatter(lightCounts[c], glm::vec3(-12.0f, -12.0f, -8.0f), glm::vec3(12.0f, 12.0f, 1.0f), 2.5f, 7);
+        lights.Upload();
+
+        //Assignment on the CPU, one thread then the job system, once untimed each to settle
+        double assign[2] = {0.0, 0.0}, upload = 0.0;
+        for(int threaded = 0; threaded < 2; threaded++)
+        {
+            for(int f = 0; f <= frames; f++)
+            {
+                clusters.Build(lights, view, projection, 0.1f, 100.0f, viewport[2], viewport[3], threaded ? &jobSystem : NULL);
+                if(f > 0)
+                {
+                    assign[threaded] += clusters.buildSeconds * 1000.0 / frames;
+                    upload += clusters.uploadSeconds * 1000.0 / frames / 2;
+                }
+            }
+        }
+        BenchmarkLog("%d lights: assignment %.3f ms on 1 thread, %.3f ms on %d, upload %.3f ms; %d indices, up to %d a cluster",
+                     lightCounts[c], assign[0], assign[1], jobSystem.ThreadCount(), upload, clusters.indexCount, clusters.maxPerCluster);
+
+        //Then shading, each way once untimed to settle
+        double shading[3] = {0.0, 0.0, 0.0};    //Clustered, deferred, forward
+        bool forwardFits = lightCounts[c] <= MAX_UNIFORM_POINT_LIGHTS && PointLights::GetUniformBlockBytes() <= maxBlockBytes;
+        for(int way = 0; way < 3; way++)
+        {
+            if(way == 2 && !forwardFits)
+                continue;
+            for(int f = 0; f <= frames; f++)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                glBeginQuery(GL_TIME_ELAPSED, queries[0]);
+                if(way == 1)
+                {
+                    deferredRenderer.BeginGeometry(viewport[2], viewport[3]);
+                    for(size_t i = 0; i < spheres.size(); i++)
+                        spheres[i].Draw(permutations, SHADER_LIT | SHADER_GBUFFER, view, projection);
+                    deferredRenderer.Light(view, projection, lights);
+                }
+                else
+                {
+                    unsigned features = SHADER_LIT | (way == 0 ? SHADER_CLUSTERED : SHADER_POINT_LIGHTS);
+                    for(size_t i = 0; i < spheres.size(); i++)
+                        spheres[i].Draw(permutations, features, view, projection);
+                }
+                glEndQuery(GL_TIME_ELAPSED);
+                uniformBuffers.EndFrame();
+                GLuint64 nanoseconds = 0;
+                glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &nanoseconds);
+                if(f > 0)
+                    shading[way] += nanoseconds / 1.0e6 / frames;
+            }
+        }
+
+        if(forwardFits)
+            BenchmarkLog("%d lights: clustered %.3f ms, deferred %.3f ms, forward %.3f ms on the GPU", lightCounts[c], shading[0], shading[1], shading[2]);
+        else
+            BenchmarkLog("%d lights: clustered %.3f ms, deferred %.3f ms on the GPU (too many for forward)", lightCounts[c], shading[0], shading[1]);
+    }
+    lodEnabled = wasLod;
+    glDeleteQueries(2, queries);
+
+    manager.Release();
+    clusters.Release();
+    lights.Release();
+    deferredRenderer.Release();
+}
+
+/* Video memory the driver says is free, in KB, or -1 if it won't say (only NVIDIA's extension is asked) */
+GLint BenchmarkFreeVideoMemory()
+{
+    if(!GLEW_NVX_gpu_memory_info)
+        return -1;
+    GLint available = 0;
+    glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+    return available;
+}
+
+/*
+ * Makes and gets rid of 100k meshes, a thousand a frame, each drawn once before it's released, with a hundred small
+ * textures made and destroyed alongside them each frame. Once everything's flushed the live objects, their memory
+ * and the slots gpuResources has made should be back where they started, and so should free video memory.
+ */
+void BenchmarkResourceChurn()
+{
+    const int frames = 100, meshesPerFrame = 1000, texturesPerFrame = 100, textureSize = 64;
+    const int reportEvery = 20;
+    GLfloat white[3] = {1.0f, 1.0f, 1.0f};
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 40.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+    std::vector<GLubyte> pixels(textureSize * textureSize * 4, 128);
+
+    ShaderManager manager;
+    ShaderPermutations permutations("Shaders/Object.vert", NULL, "Shaders/Object.frag", manager);
+    permutations.Prepare(SHADER_LIT);
+
+    //Whatever's already been released goes first, so it doesn't look like it was this
+    gpuResources.Flush();
+    int countsBefore[GPU_RESOURCE_TYPES];
+    long bytesBefore[GPU_RESOURCE_TYPES];
+    for(int t = 0; t < GPU_RESOURCE_TYPES; t++)
+    {
+        countsBefore[t] = gpuResources.liveCount[t];
+        bytesBefore[t] = gpuResources.liveBytes[t];
+    }
+    long deletedBefore = gpuResources.deletedCount;
+    GLint freeBefore = BenchmarkFreeVideoMemory();
+    int slotsAfterFirst = 0;
+
+    std::vector<struct Vertex> cube(CUBE_VERTICES, CUBE_VERTICES + CUBE_VERTEX_COUNT);
+    double createSeconds = 0.0, releaseSeconds = 0.0, endFrameSeconds = 0.0, totalSeconds = 0.0;
+    for(int f = 0; f < frames; f++)
+    {
+        BenchmarkClock::time_point start = BenchmarkClock::now();
+        std::vector<TriangleMesh*> meshes(meshesPerFrame);
+        for(int m = 0; m < meshesPerFrame; m++)
+            meshes[m] = new TriangleMesh(cube, (GLuint)0, white);
+        GPUHandle textures[texturesPerFrame];
+        for(int t = 0; t < texturesPerFrame; t++)
+        {
+            textures[t] = gpuResources.Create(GPU_TEXTURE);
+            glBindTexture(GL_TEXTURE_2D, gpuResources.Get(textures[t]));
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, textureSize, textureSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            gpuResources.SetBytes(textures[t], (long)pixels.size());
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        createSeconds += SecondsSince(start);
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        for(int m = 0; m < meshesPerFrame; m++)
+        {
+            glm::vec3 position((m % 40 - 19.5f), (m / 40 - 12.0f), 0.0f);
+            GraphicsObject(meshes[m], position, glm::quat(), 0.4f).Draw(permutations, SHADER_LIT, view, projection);
+        }
+        uniformBuffers.EndFrame();
+
+        //Straight after drawing with them, which would stall if they were deleted there and then
+        BenchmarkClock::time_point releaseStart = BenchmarkClock::now();
+        for(int m = 0; m < meshesPerFrame; m++)
+        {
+            meshes[m]->Release();
+            delete meshes[m];
+        }
+        for(int t = 0; t < texturesPerFrame; t++)
+            gpuResources.Destroy(textures[t]);
+        releaseSeconds += SecondsSince(releaseStart);
+
+        BenchmarkClock::time_point endFrameStart = BenchmarkClock::now();
+        gpuResources.EndFrame();
+        endFrameSeconds += SecondsSince(endFrameStart);
+        totalSeconds += SecondsSince(start);
+        if(f == 0)
+            slotsAfterFirst = gpuResources.SlotCount();
+
+        if((f + 1) % reportEvery == 0)
+        {
+            long live = 0;
+            for(int t = 0; t < GPU_RESOURCE_TYPES; t++)
+                live += gpuResources.liveBytes[t];
+            GLint freeNow = BenchmarkFreeVideoMemory();
+            BenchmarkLog("Frame %d: %d meshes so far, %.2f MB live, %d objects (%.2f MB) waiting, %d slots, %s", f + 1,
+                         (f + 1) * meshesPerFrame, live / 1048576.0, gpuResources.pendingCount, gpuResources.pendingBytes / 1048576.0,
+                         gpuResources.SlotCount(), freeNow < 0 ? "no VRAM query" : (std::to_string(freeNow / 1024) + " MB VRAM free").c_str());
+        }
+    }
+    gpuResources.Flush();
+
+    BenchmarkLog("%d meshes and %d textures in %.2f s: %.3f ms a frame making them, %.3f ms releasing, %.3f ms in EndFrame",
+                 frames * meshesPerFrame, frames * texturesPerFrame, totalSeconds, createSeconds * 1000.0 / frames,
+                 releaseSeconds * 1000.0 / frames, endFrameSeconds * 1000.0 / frames);
+
+    //Slots are free again as soon as they're destroyed, so every frame after the first should fit in the same ones
+    bool flat = gpuResources.pendingCount == 0 && gpuResources.SlotCount() <= slotsAfterFirst;
+    for(int t = 0; t < GPU_RESOURCE_TYPES; t++)
+    {
+        if(gpuResources.liveCount[t] != countsBefore[t] || gpuResources.liveBytes[t] != bytesBefore[t])
+        {
+            BenchmarkLog("%s: %d live (%ld bytes) after, %d (%ld bytes) before", GPU_RESOURCE_NAMES[t], gpuResources.liveCount[t],
+                         gpuResources.liveBytes[t], countsBefore[t], bytesBefore[t]);
+            flat = false;
+        }
+    }
+    GLint freeAfter = BenchmarkFreeVideoMemory();
+    if(freeBefore >= 0)
+        BenchmarkLog("VRAM free: %d MB before, %d MB after", freeBefore / 1024, freeAfter / 1024);
+    BenchmarkLog("%ld objects deleted, %d slots: %s", gpuResources.deletedCount - deletedBefore, gpuResources.SlotCount(),
+                 flat ? "memory flat" : "LEAKED");
+
+    manager.Release();
+    gpuResources.Flush();
+}
+
+/* Buttons and results, inside whichever ImGui window is currently open */
+void DrawBenchmarkPanel()
+{
+    if(!ImGui::CollapsingHeader("Benchmarks"))
+        return;
+
+    if(ImGui::Button("Job system"))
+    {
+        BenchmarkJobThroughput();
+        BenchmarkParallelForScaling();
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Sphere generation"))
+        BenchmarkSphereGeneration();
+    ImGui::SameLine();
+    if(ImGui::Button("Vertex kernels"))
+        BenchmarkVertexKernels();
+    if(ImGui::Button("Mesh cache"))
+        BenchmarkMeshCache();
+    ImGui::SameLine();
+    if(ImGui::Button("Icosphere vs UV sphere"))
+        BenchmarkIcosphere();
+    ImGui::SameLine();
+    if(ImGui::Button("Primitive tables"))
+        BenchmarkPrimitiveTables();
+    if(ImGui::Button("GPU spheres"))
+        BenchmarkProceduralSpheres();
+    ImGui::SameLine();
+    if(ImGui::Button("Debug lines"))
+        BenchmarkDebugLines();
+    if(ImGui::Button("Normal lines"))
+        BenchmarkNormalVisualiser();
+    ImGui::SameLine();
+    if(ImGui::Button("Uniform buffers"))
+        BenchmarkUniformUpload();
+    if(ImGui::Button("Shader cache"))
+        BenchmarkShaderCache();
+    ImGui::SameLine();
+    if(ImGui::Button("Shader compile"))
+        BenchmarkShaderCompile();
+    ImGui::SameLine();
+    if(ImGui::Button("Shader permutations"))
+        BenchmarkShaderPermutations();
+    if(ImGui::Button("Texture baking"))
+        BenchmarkTextureBaking();
+    ImGui::SameLine();
+    if(ImGui::Button("Texture arrays"))
+        BenchmarkTextureArrays();
+    ImGui::SameLine();
+    if(ImGui::Button("Bindless textures"))
+        BenchmarkBindlessTextures();
+    if(ImGui::Button("Asset pack"))
+        BenchmarkAssetPack();
+    ImGui::SameLine();
+    if(ImGui::Button("Texture streaming"))
+        BenchmarkTextureStreaming();
+    ImGui::SameLine();
+    int budgetMB = (int)(textureStreamer.budgetBytes / (1024 * 1024));
+    if(ImGui::SliderInt("Budget (MB)", &budgetMB, 16, 1024))
+        textureStreamer.budgetBytes = (long)budgetMB * 1024 * 1024;
+    if(ImGui::Button("Resource churn"))
+        BenchmarkResourceChurn();
+    ImGui::SameLine();
+    if(ImGui::Button("Deferred shading"))
+        BenchmarkDeferredShading();
+    ImGui::SameLine();
+    if(ImGui::Button("Clustered lights"))
+        BenchmarkClusteredLighting();
+
+    for(size_t i = 0; i < benchmarkLog.size(); i++)
+        ImGui::TextUnformatted(benchmarkLog[i].c_str());
+}
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,70 @@
+#ifndef BINDLESS_TEXTURES_H
+#define BINDLESS_TEXTURES_H
+
+#include <map>
+
+#include <GL/glew.h>
+
+/*
+ * 64-bit handles for textures (GL_ARB_bindless_texture), so a draw can name its texture in ObjectUniforms
+ * instead of binding it. Meshes with a handle draw with SHADER_BINDLESS and never touch a texture unit.
+ * Without the extension (or with enabled off) every handle is 0 and meshes bind their textures as before.
+ *
+ * Each texture gets one handle however many meshes share it (an OBJMesh and its LODs, say), made resident
+ * the first time it's asked for. A texture can't be changed once it has a handle, so ask after it's filled in.
+ */
+class BindlessTextures
+{
+public:
+    bool enabled;   //Turn off to draw with the bound textures, e.g. to compare
+
+    BindlessTextures() : enabled(true) {}
+
+    /* Whether handles are being used at all */
+    bool Available() const
+    {
+        return enabled && GLEW_ARB_bindless_texture;
+    }
+
+    /* The resident handle for a texture, or 0 if there's no texture or no bindless support */
+    GLuint64 Handle(GLuint texture)
+    {
+        if(texture == 0 || !GLEW_ARB_bindless_texture)
+            return 0;
+
+        std::map<GLuint, GLuint64>::iterator found = handles.find(texture);
+        if(found != handles.end())
+            return found->second;
+
+        GLuint64 handle = glGetTextureHandleARB(texture);
+        if(handle != 0)
+            glMakeTextureHandleResidentARB(handle);
+        handles[texture] = handle;
+        return handle;
+    }
+
+    /* Drop a texture's handle, which has to happen before the texture is deleted */
+    void Release(GLuint texture)
+    {
+        std::map<GLuint, GLuint64>::iterator found = handles.find(texture);
+        if(found == handles.end())
+            return;
+        if(found->second != 0)
+            glMakeTextureHandleNonResidentARB(found->second);
+        handles.erase(found);
+    }
+
+    /* Textures with a handle */
+    int Count() const
+    {
+        return (int)handles.size();
+    }
+
+private:
+    std::map<GLuint, GLuint64> handles;
+};
+
+/* Handles for every mesh texture */
+BindlessTextures bindlessTextures;
+
+#endif // BINDLESS_TEXTURES_H
@@ -0,0 +1,684 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+#include "JobSystem.h"
+
+/*
+ * Block compression for textures: BC1 (DXT1), BC3 (DXT5) and BC7, which the GPU reads directly at 4 or 8
+ * bits a pixel instead of 24 or 32. No GL in here, so the offline baker (Tools/TextureBaker.cpp) can use it too.
+ *
+ * The encoders are the simple, fast kind: endpoints from the extremes of each block along its principal axis,
+ * then one least-squares refit from the chosen indices. BC7 only uses mode 6 (one pair of RGBA endpoints and
+ * 16 levels between them), which suits smooth or noisy blocks and does well enough on sharp ones.
+ * There are decoders as well, to check what the encoders made.
+ */
+
+enum BlockFormat
+{
+    BLOCK_BC1,  //RGB, 8 bytes a block
+    BLOCK_BC3,  //RGBA, 16 bytes a block: BC1 colour plus 8-bit alpha
+    BLOCK_BC7   //RGBA, 16 bytes a block
+};
+
+const char* BLOCK_FORMAT_NAMES[] = {"BC1", "BC3", "BC7"};
+
+inline int BlockBytes(BlockFormat format)
+{
+    return format == BLOCK_BC1 ? 8 : 16;
+}
+
+/* Bytes for a whole image, which is padded out to whole 4x4 blocks */
+inline long CompressedSize(BlockFormat format, int width, int height)
+{
+    return (long)((width + 3) / 4) * ((height + 3) / 4) * BlockBytes(format);
+}
+
+/* 8-bit RGBA pixels, row by row from the top */
+struct RGBAImage
+{
+    int width;
+    int height;
+    std::vector<unsigned char> pixels;
+};
+
+/* Halve the image (rounding down, but never below 1) with a box filter, the way glGenerateMipmap usually does */
+RGBAImage HalveImage(const RGBAImage& image)
+{
+    RGBAImage half;
+    half.width = std::max(image.width / 2, 1);
+    half.height = std::max(image.height / 2, 1);
+    half.pixels.resize(half.width * half.height * 4);
+
+    for(int y = 0; y < half.height; y++)
+    {
+        int y0 = std::min(2 * y, image.height - 1), y1 = std::min(2 * y + 1, image.height - 1);
+        for(int x = 0; x < half.width; x++)
+        {
+            int x0 = std::min(2 * x, image.width - 1), x1 = std::min(2 * x + 1, image.width - 1);
+            for(int c = 0; c < 4; c++)
+            {
+                int sum = image.pixels[(y0 * image.width + x0) * 4 + c] + image.pixels[(y0 * image.width + x1) * 4 + c] +
+                          image.pixels[(y1 * image.width + x0) * 4 + c] + image.pixels[(y1 * image.width + x1) * 4 + c];
+                half.pixels[(y * half.width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+    return half;
+}
+
+/* The image and every level below it, down to 1x1 */
+std::vector<RGBAImage> BuildMipChain(const RGBAImage& image)
+{
+    std::vector<RGBAImage> levels(1, image);
+    while(levels.back().width > 1 || levels.back().height > 1)
+        levels.push_back(HalveImage(levels.back()));
+    return levels;
+}
+
+/* ---- Shared helpers ---- */
+
+/* Direction the block's colours (the first channels of them) vary most along, by power iteration */
+inline void PrincipalAxis(const float pixels[16][4], int channels, const float mean[4], float axis[4])
+{
+    float covariance[4][4] = {};
+    for(int p = 0; p < 16; p++)
+        for(int i = 0; i < channels; i++)
+            for(int j = 0; j < channels; j++)
+                covariance[i][j] += (pixels[p][i] - mean[i]) * (pixels[p][j] - mean[j]);
+
+    for(int i = 0; i < 4; i++)
+        axis[i] = (i < channels) ? 1.0f : 0.0f;
+    for(int iteration = 0; iteration < 8; iteration++)
+    {
+        float next[4] = {};
+        for(int i = 0; i < channels; i++)
+            for(int j = 0; j < channels; j++)
+                next[i] += covariance[i][j] * axis[j];
+        float length = 0.0f;
+        for(int i = 0; i < channels; i++)
+            length += next[i] * next[i];
+        if(length < 1e-12f)
+            break;
+        length = sqrtf(length);
+        for(int i = 0; i < channels; i++)
+            axis[i] = next[i] / length;
+    }
+}
+
+/* Endpoints at the two ends of the block along its principal axis */
+inline void RangeFit(const float pixels[16][4], int channels, float low[4], float high[4])
+{
+    float mean[4] = {};
+    for(int p = 0; p < 16; p++)
+        for(int c = 0; c < channels; c++)
+            mean[c] += pixels[p][c] / 16.0f;
+
+    float axis[4];
+    PrincipalAxis(pixels, channels, mean, axis);
+
+    float minimum = 0.0f, maximum = 0.0f;
+    for(int p = 0; p < 16; p++)
+    {
+        float t = 0.0f;
+        for(int c = 0; c < channels; c++)
+            t += (pixels[p][c] - mean[c]) * axis[c];
+        minimum = std::min(minimum, t);
+        maximum = std::max(maximum, t);
+    }
+    for(int c = 0; c < 4; c++)
+    {
+        low[c] = (c < channels) ? std::max(0.0f, std::min(255.0f, mean[c] + minimum * axis[c])) : 255.0f;
+        high[c] = (c < channels) ? std::max(0.0f, std::min(255.0f, mean[c] + maximum * axis[c])) : 255.0f;
+    }
+}
+
+/*
+ * Least-squares endpoints for a set of indices, where index i sits weights[i] of the way from low to high.
+ * Returns false if every pixel had the same weight, when there's nothing to solve.
+ */
+inline bool RefitEndpoints(const float pixels[16][4], int channels, const int indices[16], const float* weights, float low[4], float high[4])
+{
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[4] = {}, bx[4] = {};
+    for(int p = 0; p < 16; p++)
+    {
+        float b = weights[indices[p]];
+        float a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for(int c = 0; c < channels; c++)
+        {
+            ax[c] += a * pixels[p][c];
+            bx[c] += b * pixels[p][c];
+        }
+    }
+    float determinant = aa * bb - ab * ab;
+    if(fabsf(determinant) < 1e-6f)
+        return false;
+    for(int c = 0; c < channels; c++)
+    {
+        low[c] = std::max(0.0f, std::min(255.0f, (ax[c] * bb - bx[c] * ab) / determinant));
+        high[c] = std::max(0.0f, std::min(255.0f, (bx[c] * aa - ax[c] * ab) / determinant));
+    }
+    return true;
+}
+
+inline void LoadBlock(const unsigned char rgba[64], float pixels[16][4])
+{
+    for(int p = 0; p < 16; p++)
+        for(int c = 0; c < 4; c++)
+            pixels[p][c] = rgba[p * 4 + c];
+}
+
+/* ---- BC1 ---- */
+
+inline int Expand5(int v) { return (v << 3) | (v >> 2); }
+inline int Expand6(int v) { return (v << 2) | (v >> 4); }
+
+inline int PackColour565(const float colour[4])
+{
+    int r = (int)(colour[0] * 31.0f / 255.0f + 0.5f);
+    int g = (int)(colour[1] * 63.0f / 255.0f + 0.5f);
+    int b = (int)(colour[2] * 31.0f / 255.0f + 0.5f);
+    return (r << 11) | (g << 5) | b;
+}
+
+inline void UnpackColour565(int packed, int colour[3])
+{
+    colour[0] = Expand5((packed >> 11) & 31);
+    colour[1] = Expand6((packed >> 5) & 63);
+    colour[2] = Expand5(packed & 31);
+}
+
+/* The four colours of a 4-colour BC1 block */
+inline void BC1Palette(int colour0, int colour1, int palette[4][3])
+{
+    UnpackColour565(colour0, palette[0]);
+    UnpackColour565(colour1, palette[1]);
+    for(int c = 0; c < 3; c++)
+    {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+}
+
+/* Nearest palette entry for each pixel. Returns the squared error */
+inline int BC1Indices(const float pixels[16][4], int colour0, int colour1, int indices[16])
+{
+    int palette[4][3];
+    BC1Palette(colour0, colour1, palette);
+    int total = 0;
+    for(int p = 0; p < 16; p++)
+    {
+        int best = 0, bestError = 1 << 30;
+        for(int i = 0; i < 4; i++)
+        {
+            int error = 0;
+            for(int c = 0; c < 3; c++)
+            {
+                int d = (int)pixels[p][c] - palette[i][c];
+                error += d * d;
+            }
+            if(error < bestError)
+            {
+                best = i;
+                bestError = error;
+            }
+        }
+        indices[p] = best;
+        total += bestError;
+    }
+    return total;
+}
+
+/* Colour half of a BC1 or BC3 block. Always 4-colour mode (colour0 > colour1), as BC3 has no other */
+inline void EncodeBC1Colour(const float pixels[16][4], unsigned char out[8])
+{
+    static const float WEIGHTS[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+
+    float low[4], high[4];
+    RangeFit(pixels, 3, low, high);
+    int colour0 = PackColour565(high), colour1 = PackColour565(low);
+    int indices[16];
+    int error = BC1Indices(pixels, colour0, colour1, indices);
+
+    //One refit from the indices the range fit gave, kept if it's better
+    if(RefitEndpoints(pixels, 3, indices, WEIGHTS, high, low))
+    {
+        int refit0 = PackColour565(high), refit1 = PackColour565(low);
+        int refitIndices[16];
+        int refitError = BC1Indices(pixels, refit0, refit1, refitIndices);
+        if(refitError < error)
+        {
+            colour0 = refit0;
+            colour1 = refit1;
+            memcpy(indices, refitIndices, sizeof(indices));
+        }
+    }
+
+    //4-colour mode needs colour0 > colour1; swapping the ends swaps indices 0 <-> 1 and 2 <-> 3
+    if(colour0 < colour1)
+    {
+        std::swap(colour0, colour1);
+        for(int p = 0; p < 16; p++)
+            indices[p] ^= 1;
+    }
+    else if(colour0 == colour1)
+    {
+        for(int p = 0; p < 16; p++)
+            indices[p] = 0;
+    }
+
+    unsigned int bits = 0;
+    for(int p = 0; p < 16; p++)
+        bits |= (unsigned int)indices[p] << (2 * p);
+    out[0] = colour0 & 255;
+    out[1] = colour0 >> 8;
+    out[2] = colour1 & 255;
+    out[3] = colour1 >> 8;
+    for(int b = 0; b < 4; b++)
+        out[4 + b] = (bits >> (8 * b)) & 255;
+}
+
+void EncodeBC1Block(const unsigned char rgba[64], unsigned char out[8])
+{
+    float pixels[16][4];
+    LoadBlock(rgba, pixels);
+    EncodeBC1Colour(pixels, out);
+}
+
+void DecodeBC1Block(const unsigned char block[8], unsigned char rgba[64])
+{
+    int colour0 = block[0] | (block[1] << 8), colour1 = block[2] | (block[3] << 8);
+    int palette[4][3];
+    BC1Palette(colour0, colour1, palette);
+    if(colour0 <= colour1)
+    {
+        //3-colour mode, which the encoder doesn't make but other tools might
+        for(int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    unsigned int bits = block[4] | (block[5] << 8) | (block[6] << 16) | ((unsigned int)block[7] << 24);
+    for(int p = 0; p < 16; p++)
+    {
+        int index = (bits >> (2 * p)) & 3;
+        for(int c = 0; c < 3; c++)
+            rgba[p * 4 + c] = (unsigned char)palette[index][c];
+        rgba[p * 4 + 3] = (colour0 <= colour1 && index == 3) ? 0 : 255;
+    }
+}
+
+/* ---- BC3 ---- */
+
+inline void BC3AlphaPalette(int alpha0, int alpha1, int palette[8])
+{
+    palette[0] = alpha0;
+    palette[1] = alpha1;
+    if(alpha0 > alpha1)
+    {
+        for(int i = 2; i < 8; i++)
+            palette[i] = ((8 - i) * alpha0 + (i - 1) * alpha1) / 7;
+    }
+    else
+    {
+        for(int i = 2; i < 6; i++)
+            palette[i] = ((6 - i) * alpha0 + (i - 1) * alpha1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+void EncodeBC3Block(const unsigned char rgba[64], unsigned char out[16])
+{
+    float pixels[16][4];
+    LoadBlock(rgba, pixels);
+
+    //Alpha: the 8-level mode between the block's own extremes
+    int alpha0 = 0, alpha1 = 255;
+    for(int p = 0; p < 16; p++)
+    {
+        alpha0 = std::max(alpha0, (int)rgba[p * 4 + 3]);
+        alpha1 = std::min(alpha1, (int)rgba[p * 4 + 3]);
+    }
+    int palette[8];
+    BC3AlphaPalette(alpha0, alpha1, palette);
+    unsigned long long bits = 0;
+    for(int p = 0; p < 16 && alpha0 > alpha1; p++)
+    {
+        int best = 0, bestError = 1 << 30;
+        for(int i = 0; i < 8; i++)
+        {
+            int error = abs((int)rgba[p * 4 + 3] - palette[i]);
+            if(error < bestError)
+            {
+                best = i;
+                bestError = error;
+            }
+        }
+        bits |= (unsigned long long)best << (3 * p);
+    }
+    out[0] = (unsigned char)alpha0;
+    out[1] = (unsigned char)alpha1;
+    for(int b = 0; b < 6; b++)
+        out[2 + b] = (bits >> (8 * b)) & 255;
+
+    EncodeBC1Colour(pixels, out + 8);
+}
+
+void DecodeBC3Block(const unsigned char block[16], unsigned char rgba[64])
+{
+    DecodeBC1Block(block + 8, rgba);
+
+    int palette[8];
+    BC3AlphaPalette(block[0], block[1], palette);
+    unsigned long long bits = 0;
+    for(int b = 0; b < 6; b++)
+        bits |= (unsigned long long)block[2 + b] << (8 * b);
+    for(int p = 0; p < 16; p++)
+        rgba[p * 4 + 3] = (unsigned char)palette[(bits >> (3 * p)) & 7];
+}
+
+/* ---- BC7, mode 6 only ---- */
+
+const int BC7_WEIGHTS_4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+/* Writes bits into a block, least significant first */
+struct BitWriter
+{
+    unsigned char* data;
+    int position;
+
+    void Write(unsigned int value, int count)
+    {
+        for(int i = 0; i < count; i++, position++)
+            if(value & (1u << i))
+                data[position >> 3] |= (unsigned char)(1 << (position & 7));
+    }
+};
+
+struct BitReader
+{
+    const unsigned char* data;
+    int position;
+
+    unsigned int Read(int count)
+    {
+        unsigned int value = 0;
+        for(int i = 0; i < count; i++, position++)
+            if(data[position >> 3] & (1 << (position & 7)))
+                value |= 1u << i;
+        return value;
+    }
+};
+
+/* Quantised mode 6 endpoints: 7 bits a channel plus a shared p-bit for each end */
+struct BC7Endpoints
+{
+    int colour[2][4];   //0-127
+    int pBit[2];
+};
+
+inline void BC7Expand(const BC7Endpoints& ends, int expanded[2][4])
+{
+    for(int e = 0; e < 2; e++)
+        for(int c = 0; c < 4; c++)
+            expanded[e][c] = (ends.colour[e][c] << 1) | ends.pBit[e];
+}
+
+inline void BC7Palette(const BC7Endpoints& ends, int palette[16][4])
+{
+    int expanded[2][4];
+    BC7Expand(ends, expanded);
+    for(int i = 0; i < 16; i++)
+        for(int c = 0; c < 4; c++)
+            palette[i][c] = ((64 - BC7_WEIGHTS_4[i]) * expanded[0][c] + BC7_WEIGHTS_4[i] * expanded[1][c] + 32) >> 6;
+}
+
+/* Nearest palette entry for each pixel. Returns the squared error */
+inline int BC7Indices(const float pixels[16][4], const BC7Endpoints& ends, int indices[16])
+{
+    int palette[16][4];
+    BC7Palette(ends, palette);
+    int total = 0;
+    for(int p = 0; p < 16; p++)
+    {
+        int best = 0, bestError = 1 << 30;
+        for(int i = 0; i < 16; i++)
+        {
+            int error = 0;
+            for(int c = 0; c < 4; c++)
+            {
+                int d = (int)pixels[p][c] - palette[i][c];
+                error += d * d;
+            }
+            if(error < bestError)
+            {
+                best = i;
+                bestError = error;
+            }
+        }
+        indices[p] = best;
+        total += bestError;
+    }
+    return total;
+}
+
+/* Best of the four p-bit choices for a pair of 8-bit endpoints. Returns the error, and fills in ends and indices */
+inline int BC7QuantiseEndpoints(const float pixels[16][4], const float low[4], const float high[4], BC7Endpoints& ends, int indices[16])
+{
+    int bestError = 1 << 30;
+    for(int pBits = 0; pBits < 4; pBits++)
+    {
+        BC7Endpoints candidate;
+        candidate.pBit[0] = pBits & 1;
+        candidate.pBit[1] = pBits >> 1;
+        for(int c = 0; c < 4; c++)
+        {
+            candidate.colour[0][c] = std::max(0, std::min(127, (int)((low[c] - candidate.pBit[0]) / 2.0f + 0.5f)));
+            candidate.colour[1][c] = std::max(0, std::min(127, (int)((high[c] - candidate.pBit[1]) / 2.0f + 0.5f)));
+        }
+        int candidateIndices[16];
+        int error = BC7Indices(pixels, candidate, candidateIndices);
+        if(error < bestError)
+        {
+            bestError = error;
+            ends = candidate;
+            memcpy(indices, candidateIndices, sizeof(candidateIndices));
+        }
+    }
+    return bestError;
+}
+
+void EncodeBC7Block(const unsigned char rgba[64], unsigned char out[16])
+{
+    float weights[16];
+    for(int i = 0; i < 16; i++)
+        weights[i] = BC7_WEIGHTS_4[i] / 64.0f;
+
+    float pixels[16][4];
+    LoadBlock(rgba, pixels);
+
+    float low[4], high[4];
+    RangeFit(pixels, 4, low, high);
+    BC7Endpoints ends;
+    int indices[16];
+    int error = BC7QuantiseEndpoints(pixels, low, high, ends, indices);
+
+    if(RefitEndpoints(pixels, 4, indices, weights, low, high))
+    {
+        BC7Endpoints refitEnds;
+        int refitIndices[16];
+        if(BC7QuantiseEndpoints(pixels, low, high, refitEnds, refitIndices) < error)
+        {
+            ends = refitEnds;
+            memcpy(indices, refitIndices, sizeof(indices));
+        }
+    }
+
+    //The first pixel's index is stored without its top bit, so it has to be under 8: swap the ends if not
+    if(indices[0] >= 8)
+    {
+        for(int c = 0; c < 4; c++)
+            std::swap(ends.colour[0][c], ends.colour[1][c]);
+        std::swap(ends.pBit[0], ends.pBit[1]);
+        for(int p = 0; p < 16; p++)
+            indices[p] = 15 - indices[p];
+    }
+
+    memset(out, 0, 16);
+    BitWriter writer = {out, 0};
+    writer.Write(1 << 6, 7);    //Mode 6
+    for(int c = 0; c < 4; c++)
+    {
+        writer.Write(ends.colour[0][c], 7);
+        writer.Write(ends.colour[1][c], 7);
+    }
+    writer.Write(ends.pBit[0], 1);
+    writer.Write(ends.pBit[1], 1);
+    for(int p = 0; p < 16; p++)
+        writer.Write(indices[p], p == 0 ? 3 : 4);
+}
+
+/* Only mode 6 blocks, as made by EncodeBC7Block. Anything else comes out magenta */
+void DecodeBC7Block(const unsigned char block[16], unsigned char rgba[64])
+{
+    BitReader reader = {block, 0};
+    if(reader.Read(7) != (1 << 6))
+    {
+        for(int p = 0; p < 16; p++)
+        {
+            rgba[p * 4 + 0] = 255;
+            rgba[p * 4 + 1] = 0;
+            rgba[p * 4 + 2] = 255;
+            rgba[p * 4 + 3] = 255;
+        }
+        return;
+    }
+
+    BC7Endpoints ends;
+    for(int c = 0; c < 4; c++)
+    {
+        ends.colour[0][c] = reader.Read(7);
+        ends.colour[1][c] = reader.Read(7);
+    }
+    ends.pBit[0] = reader.Read(1);
+    ends.pBit[1] = reader.Read(1);
+
+    int palette[16][4];
+    BC7Palette(ends, palette);
+    for(int p = 0; p < 16; p++)
+    {
+        int index = reader.Read(p == 0 ? 3 : 4);
+        for(int c = 0; c < 4; c++)
+            rgba[p * 4 + c] = (unsigned char)palette[index][c];
+    }
+}
+
+/* ---- Whole images ---- */
+
+/* The 4x4 block at (blockX, blockY), with the edge pixels repeated where it hangs off the image */
+inline void ReadBlock(const RGBAImage& image, int blockX, int blockY, unsigned char rgba[64])
+{
+    for(int y = 0; y < 4; y++)
+    {
+        int sourceY = std::min(blockY * 4 + y, image.height - 1);
+        for(int x = 0; x < 4; x++)
+        {
+            int sourceX = std::min(blockX * 4 + x, image.width - 1);
+            memcpy(&rgba[(y * 4 + x) * 4], &image.pixels[(sourceY * image.width + sourceX) * 4], 4);
+        }
+    }
+}
+
+/* Compress a whole image, a row of blocks per job on jobs, or all on this thread if jobs is NULL */
+std::vector<unsigned char> CompressImage(const RGBAImage& image, BlockFormat format, JobSystem* jobs = &jobSystem)
+{
+    int blocksWide = (image.width + 3) / 4, blocksHigh = (image.height + 3) / 4;
+    int blockBytes = BlockBytes(format);
+    std::vector<unsigned char> compressed(CompressedSize(format, image.width, image.height));
+
+    auto compressRows = [&](int begin, int end)
+    {
+        unsigned char rgba[64];
+        for(int blockY = begin; blockY < end; blockY++)
+        {
+            for(int blockX = 0; blockX < blocksWide; blockX++)
+            {
+                ReadBlock(image, blockX, blockY, rgba);
+                unsigned char* out = &compressed[((long)blockY * blocksWide + blockX) * blockBytes];
+                if(format == BLOCK_BC1)
+                    EncodeBC1Block(rgba, out);
+                else if(format == BLOCK_BC3)
+                    EncodeBC3Block(rgba, out);
+                else
+                    EncodeBC7Block(rgba, out);
+            }
+        }
+    };
+
+    if(jobs != NULL)
+        jobs->ParallelFor(blocksHigh, 1, compressRows);
+    else
+        compressRows(0, blocksHigh);
+    return compressed;
+}
+
+/* Back to pixels, to see how close the compression got */
+RGBAImage DecompressImage(const std::vector<unsigned char>& compressed, BlockFormat format, int width, int height)
+{
+    RGBAImage image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(width * height * 4);
+
+    int blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+    unsigned char rgba[64];
+    for(int blockY = 0; blockY < blocksHigh; blockY++)
+    {
+        for(int blockX = 0; blockX < blocksWide; blockX++)
+        {
+            const unsigned char* block = &compressed[((long)blockY * blocksWide + blockX) * BlockBytes(format)];
+            if(format == BLOCK_BC1)
+                DecodeBC1Block(block, rgba);
+            else if(format == BLOCK_BC3)
+                DecodeBC3Block(block, rgba);
+            else
+                DecodeBC7Block(block, rgba);
+
+            for(int y = 0; y < 4 && blockY * 4 + y < height; y++)
+                for(int x = 0; x < 4 && blockX * 4 + x < width; x++)
+                    memcpy(&image.pixels[((blockY * 4 + y) * width + blockX * 4 + x) * 4], &rgba[(y * 4 + x) * 4], 4);
+        }
+    }
+    return image;
+}
+
+/* Peak signal to noise ratio in dB over the given channels (3 for RGB, 4 for RGBA). Higher is closer */
+double ImagePSNR(const RGBAImage& a, const RGBAImage& b, int channels)
+{
+    double squared = 0.0;
+    long count = 0;
+    for(long p = 0; p < (long)a.width * a.height; p++)
+    {
+        for(int c = 0; c < channels; c++)
+        {
+            double d = (double)a.pixels[p * 4 + c] - b.pixels[p * 4 + c];
+            squared += d * d;
+            count++;
+        }
+    }
+    if(squared == 0.0)
+        return 99.0;
+    return 10.0 * log10(255.0 * 255.0 / (squared / count));
+}
+
+#endif // BLOCK_COMPRESSION_H
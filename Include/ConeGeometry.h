@@ -2,70 +2,99 @@
 #define CONE_H
 
 #include "Introduction.h"
+#include "TrigTables.h"
+#include "VertexKernels.h"
+#include "JobSystem.h"
+#include "ConstexprMath.h"
 #include <math.h>
 #include <iostream>
 
+/* Roughly how many segments are worth handing to the job system as one chunk */
+const int CONE_SEGMENTS_PER_JOB = 4096;
+
 /* Produce vertex data for a cone with smooth shading on the curved face
+   The rim is worked out once by the SIMD ring kernel and then interleaved
 */
 const std::vector<Vertex> GetConePhong(int segments, double height, double radius)
 {
     /* Minimum of 3 segments and 3 rings */
     if(segments < 3) segments = 3;
 
-    std::vector<struct Vertex> vertices;
-
     double segmentAngle = 360.0f / segments;
+    RingTable around(TrigTable(segments, 0.0, segmentAngle));
 
-    int i;
-    //Curved surface
-    for(i = 0; i < segments; i++)
-    {
-        double theta = glm::radians(segmentAngle * i);
-        double theta2 = glm::radians(((i + 1) % segments) * segmentAngle);
-
-        double iX = radius * cos(theta);
-        double iY = -height / 2;
-        double iZ = radius * sin(theta);
-        glm::vec3 iNormal = glm::vec3(0, radius, 0) + glm::vec3(iX * height, 0, iZ * height);
-        iNormal = glm::normalize(iNormal);
-        struct Vertex iVert = {{iX, iY, iZ}, {iNormal.x, iNormal.y, iNormal.z}, {0.0f, 0.0f}};
-
-        struct Vertex top = {{0, height/2, 0}, {iNormal.x, iNormal.y, iNormal.z}, {0.0f, 0.0f}};
-
-        double i2X = radius * cos(theta2);
-        double i2Y = -height / 2;//Yes, redundant. Readability and future flexibility reasons
-        double i2Z = radius * sin(theta2);
-        glm::vec3 i2Normal = glm::vec3(0, radius, 0) + glm::vec3(i2X * height, 0, i2Z * height);
-        i2Normal = glm::normalize(i2Normal);
-        struct Vertex i2Vert = {{i2X, i2Y, i2Z}, {i2Normal.x, i2Normal.y, i2Normal.z}, {0.0f, 0.0f}};
-
-        vertices.push_back(iVert);
-        vertices.push_back(top);
-        vertices.push_back(i2Vert);
-    }
-    //Base
-    for(i = 0; i < segments; i++)
-    {
-        double theta = glm::radians(segmentAngle * i);
-        double theta2 = glm::radians(((i + 1) % segments) * segmentAngle);
+    //The curved surface normal leans up by the same amount all the way round
+    double normalLength = sqrt(radius * radius + radius * radius * height * height);
+    double normalOut = radius * height / normalLength;
+    double normalUp = radius / normalLength;
 
-        double iX = radius * cos(theta);
-        double iY = -height / 2;
-        double iZ = radius * sin(theta);
-        struct Vertex iVert = {{iX, iY, iZ}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f}};
+    RingPoints rim;
+    rim.Compute(around, (float)radius, (float)(-height / 2), (float)normalOut, (float)normalUp);
 
-        struct Vertex bottom = {{0, -height/2, 0}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f}};
+    //One triangle per segment on the curved surface, then one per segment on the base
+    std::vector<struct Vertex> vertices(6 * segments);
 
-        double i2X = radius * cos(theta2);
-        double i2Y = -height / 2;//Yes, redundant. Readability and future flexibility reasons
-        double i2Z = radius * sin(theta2);
-        struct Vertex i2Vert = {{i2X, i2Y, i2Z}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f}};
+    jobSystem.ParallelFor(segments, CONE_SEGMENTS_PER_JOB, [&](int firstSegment, int endSegment)
+    {
+        for(int i = firstSegment; i < endSegment; i++)
+        {
+            //Curved surface
+            struct Vertex iVert = rim.GetVertex(i);
+            struct Vertex top = {{0, height/2, 0}, {iVert.normal[0], iVert.normal[1], iVert.normal[2]}, {0.0f, 0.0f}};
+            struct Vertex i2Vert = rim.GetVertex(i + 1);
 
-        vertices.push_back(iVert);
-        vertices.push_back(bottom);
-        vertices.push_back(i2Vert);
-    }
+            struct Vertex* out = &vertices[3 * i];
+            out[0] = iVert;
+            out[1] = top;
+            out[2] = i2Vert;
+
+            //Base
+            struct Vertex iBase = {{iVert.position[0], iVert.position[1], iVert.position[2]}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f}};
+            struct Vertex bottom = {{0, -height/2, 0}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f}};
+            struct Vertex i2Base = {{i2Vert.position[0], i2Vert.position[1], i2Vert.position[2]}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f}};
+
+            out = &vertices[3 * (segments + i)];
+            out[0] = iBase;
+            out[1] = bottom;
+            out[2] = i2Base;
+        }
+    });
 
     return vertices;
 }
+
+/* Vertices GetConePhong makes: one triangle per segment on the curved face and one on the base */
+constexpr int ConeVertexCount(int segments)
+{
+    return 6 * segments;
+}
+
+/* GetConePhong with a radius of 1, in the same order, for the compiler to run. See BuildSpherePhong */
+constexpr void BuildConePhong(int segments, double height, struct Vertex* out)
+{
+    double normalLength = ConstexprSqrt(1.0 + height * height);
+    double normalOut = height / normalLength;
+    double normalUp = 1.0 / normalLength;
+
+    for(int i = 0; i < segments; i++)
+    {
+        double phi = i * 2.0 * CONSTEXPR_PI / segments;
+        double phi2 = ((i + 1) % segments) * 2.0 * CONSTEXPR_PI / segments;
+        double x = ConstexprCos(phi), z = ConstexprSin(phi);
+        double x2 = ConstexprCos(phi2), z2 = ConstexprSin(phi2);
+
+        //Curved surface
+        struct Vertex* face = &out[3 * i];
+        face[0] = {{x, -height / 2, z}, {normalOut * x, normalUp, normalOut * z}, {0.0f, 0.0f}};
+        face[1] = {{0.0, height / 2, 0.0}, {normalOut * x, normalUp, normalOut * z}, {0.0f, 0.0f}};
+        face[2] = {{x2, -height / 2, z2}, {normalOut * x2, normalUp, normalOut * z2}, {0.0f, 0.0f}};
+
+        //Base
+        struct Vertex* base = &out[3 * (segments + i)];
+        base[0] = {{x, -height / 2, z}, {0.0, -1.0, 0.0}, {0.0f, 0.0f}};
+        base[1] = {{0.0, -height / 2, 0.0}, {0.0, -1.0, 0.0}, {0.0f, 0.0f}};
+        base[2] = {{x2, -height / 2, z2}, {0.0, -1.0, 0.0}, {0.0f, 0.0f}};
+    }
+}
+
 #endif // CONE_H
@@ -0,0 +1,102 @@
+#ifndef CONSTEXPR_MATH_H
+#define CONSTEXPR_MATH_H
+
+/*
+ * Maths functions that can run at compile time, for building geometry tables as constexpr data.
+ * <cmath> isn't constexpr until C++26, so these are plain series and Newton's method.
+ * They are good to a few ulps over the ranges the generators use, but slower than the library
+ * versions, so only use them where the result is wanted at compile time.
+ */
+
+constexpr double CONSTEXPR_PI = 3.14159265358979323846;
+
+constexpr double ConstexprAbs(double x)
+{
+    return x < 0.0 ? -x : x;
+}
+
+constexpr double ConstexprSqrt(double x)
+{
+    if(x <= 0.0)
+        return 0.0;
+
+    //Newton's method from above only ever decreases, so stop as soon as it doesn't
+    double guess = x > 1.0 ? x : 1.0;
+    for(int i = 0; i < 2000; i++)
+    {
+        double next = 0.5 * (guess + x / guess);
+        if(next >= guess)
+            break;
+        guess = next;
+    }
+    return guess;
+}
+
+/* Taylor series, once x is brought into [-pi/2, pi/2] */
+constexpr double ConstexprSin(double x)
+{
+    //Into [-pi, pi]
+    double turns = x / (2.0 * CONSTEXPR_PI);
+    long long whole = (long long)(turns < 0.0 ? turns - 0.5 : turns + 0.5);
+    x -= whole * 2.0 * CONSTEXPR_PI;
+
+    //sin(x) = sin(pi - x)
+    if(x > CONSTEXPR_PI / 2.0)
+        x = CONSTEXPR_PI - x;
+    else if(x < -CONSTEXPR_PI / 2.0)
+        x = -CONSTEXPR_PI - x;
+
+    double term = x;
+    double sum = x;
+    for(int n = 1; n < 30; n++)
+    {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double ConstexprCos(double x)
+{
+    return ConstexprSin(x + CONSTEXPR_PI / 2.0);
+}
+
+constexpr double ConstexprAtan(double x)
+{
+    //Use the symmetries to get |x| under tan(pi/8), where the series converges quickly
+    if(x < 0.0)
+        return -ConstexprAtan(-x);
+    if(x > 1.0)
+        return CONSTEXPR_PI / 2.0 - ConstexprAtan(1.0 / x);
+    if(x > 0.41421356237309503)
+        return CONSTEXPR_PI / 4.0 + ConstexprAtan((x - 1.0) / (x + 1.0));
+
+    double power = x;
+    double sum = x;
+    for(int n = 1; n < 40; n++)
+    {
+        power *= -x * x;
+        sum += power / (2 * n + 1);
+    }
+    return sum;
+}
+
+constexpr double ConstexprAtan2(double y, double x)
+{
+    if(x > 0.0)
+        return ConstexprAtan(y / x);
+    if(x < 0.0)
+        return ConstexprAtan(y / x) + (y >= 0.0 ? CONSTEXPR_PI : -CONSTEXPR_PI);
+    if(y > 0.0)
+        return CONSTEXPR_PI / 2.0;
+    if(y < 0.0)
+        return -CONSTEXPR_PI / 2.0;
+    return 0.0;
+}
+
+constexpr double ConstexprAsin(double x)
+{
+    return ConstexprAtan2(x, ConstexprSqrt(1.0 - x * x));
+}
+
+#endif // CONSTEXPR_MATH_H
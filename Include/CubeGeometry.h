@@ -3,56 +3,87 @@
 
 #include "Introduction.h"
 
+/*
+ * A cube with sides of length 1, centred on the origin. It's fixed data, so the compiler lays it
+ * out in read-only memory and nothing is built at startup. Size it with GraphicsObject::scale.
+ */
+constexpr struct Vertex CUBE_VERTICES[] =
+{
+    {{-0.5, -0.5, -0.5},   {0.0f, 0.0f, -1.0f},    {0.0f, 0.0f}},
+    {{ 0.5, -0.5, -0.5},   {0.0f, 0.0f, -1.0f},    {1.0f, 0.0f}},
+    {{ 0.5,  0.5, -0.5},   {0.0f, 0.0f, -1.0f},    {1.0f, 1.0f}},
+    {{ 0.5,  0.5, -0.5},   {0.0f, 0.0f, -1.0f},    {1.0f, 1.0f}},
+    {{-0.5,  0.5, -0.5},   {0.0f, 0.0f, -1.0f},    {0.0f, 1.0f}},
+    {{-0.5, -0.5, -0.5},   {0.0f, 0.0f, -1.0f},    {0.0f, 0.0f}}, //Front
+
+    {{-0.5, -0.5,  0.5},   {0.0f, 0.0f, 1.0f},    {0.0f, 0.0f}},
+    {{ 0.5, -0.5,  0.5},   {0.0f, 0.0f, 1.0f},    {1.0f, 0.0f}},
+    {{ 0.5,  0.5,  0.5},   {0.0f, 0.0f, 1.0f},    {1.0f, 1.0f}},
+    {{ 0.5,  0.5,  0.5},   {0.0f, 0.0f, 1.0f},    {1.0f, 1.0f}},
+    {{-0.5,  0.5,  0.5},   {0.0f, 0.0f, 1.0f},    {0.0f, 1.0f}},
+    {{-0.5, -0.5,  0.5},   {0.0f, 0.0f, 1.0f},    {0.0f, 0.0f}}, //Back
+
+    {{-0.5,  0.5,  0.5},   {-1.0f, 0.0f, 0.0f},    {1.0f, 0.0f}},
+    {{-0.5,  0.5, -0.5},   {-1.0f, 0.0f, 0.0f},    {1.0f, 1.0f}},
+    {{-0.5, -0.5, -0.5},   {-1.0f, 0.0f, 0.0f},    {0.0f, 1.0f}},
+    {{-0.5, -0.5, -0.5},   {-1.0f, 0.0f, 0.0f},    {0.0f, 1.0f}},
+    {{-0.5, -0.5,  0.5},   {-1.0f, 0.0f, 0.0f},    {0.0f, 0.0f}},
+    {{-0.5,  0.5,  0.5},   {-1.0f, 0.0f, 0.0f},    {1.0f, 0.0f}}, //Left
+
+    {{ 0.5,  0.5,  0.5},   {1.0f, 0.0f, 0.0f},    {1.0f, 0.0f}},
+    {{ 0.5,  0.5, -0.5},   {1.0f, 0.0f, 0.0f},    {1.0f, 1.0f}},
+    {{ 0.5, -0.5, -0.5},   {1.0f, 0.0f, 0.0f},    {0.0f, 1.0f}},
+    {{ 0.5, -0.5, -0.5},   {1.0f, 0.0f, 0.0f},    {0.0f, 1.0f}},
+    {{ 0.5, -0.5,  0.5},   {1.0f, 0.0f, 0.0f},    {0.0f, 0.0f}},
+    {{ 0.5,  0.5,  0.5},   {1.0f, 0.0f, 0.0f},    {1.0f, 0.0f}}, //Right
+
+    {{-0.5, -0.5, -0.5},   {0.0f, -1.0f, 0.0f},    {0.0f, 1.0f}},
+    {{ 0.5, -0.5, -0.5},   {0.0f, -1.0f, 0.0f},    {1.0f, 1.0f}},
+    {{ 0.5, -0.5,  0.5},   {0.0f, -1.0f, 0.0f},    {1.0f, 0.0f}},
+    {{ 0.5, -0.5,  0.5},   {0.0f, -1.0f, 0.0f},    {1.0f, 0.0f}},
+    {{-0.5, -0.5,  0.5},   {0.0f, -1.0f, 0.0f},    {0.0f, 0.0f}},
+    {{-0.5, -0.5, -0.5},   {0.0f, -1.0f, 0.0f},    {0.0f, 1.0f}}, //Bottom
+
+    {{-0.5,  0.5, -0.5},   {0.0f, 1.0f, 0.0f},    {0.0f, 1.0f}},
+    {{ 0.5,  0.5, -0.5},   {0.0f, 1.0f, 0.0f},    {1.0f, 1.0f}},
+    {{ 0.5,  0.5,  0.5},   {0.0f, 1.0f, 0.0f},    {1.0f, 0.0f}},
+    {{ 0.5,  0.5,  0.5},   {0.0f, 1.0f, 0.0f},    {1.0f, 0.0f}},
+    {{-0.5,  0.5,  0.5},   {0.0f, 1.0f, 0.0f},    {0.0f, 0.0f}},
+    {{-0.5,  0.5, -0.5},   {0.0f, 1.0f, 0.0f},    {0.0f, 1.0f}} //Top
+};
+
+const int CUBE_VERTEX_COUNT = sizeof(CUBE_VERTICES) / sizeof(CUBE_VERTICES[0]);
+
+/* Every normal should be a unit axis pointing out of the face its vertex is on */
+constexpr bool CubeNormalsPointOut()
+{
+    for(int v = 0; v < CUBE_VERTEX_COUNT; v++)
+    {
+        double length = 0.0;
+        double outwards = 0.0;
+        for(int k = 0; k < 3; k++)
+        {
+            length += CUBE_VERTICES[v].normal[k] * CUBE_VERTICES[v].normal[k];
+            outwards += CUBE_VERTICES[v].normal[k] * CUBE_VERTICES[v].position[k];
+        }
+        if(length != 1.0 || outwards != 0.5)
+            return false;
+    }
+    return true;
+}
+
+static_assert(CUBE_VERTEX_COUNT == 36, "A cube is six faces of two triangles");
+static_assert(CubeNormalsPointOut(), "Cube normals must point out of their faces");
+
+/* A copy of the cube at a given size, for anything that wants its own vertices */
 const std::vector<struct Vertex> GetCubeGeometry(double sideLength)
 {
-    double halfSide = sideLength / 2;
-    //Vertices forming a 2D square made up of two triangles
-	const std::vector<struct Vertex> vertices =
-	{
-		{{-halfSide, -halfSide, -halfSide},     {0.0f, 0.0f, -1.0f},    {0.0f, 0.0f}},
-		{{halfSide, -halfSide, -halfSide},      {0.0f, 0.0f, -1.0f},    {1.0f, 0.0f}},
-		{{halfSide,  halfSide, -halfSide},      {0.0f, 0.0f, -1.0f},    {1.0f, 1.0f}},
-		{{halfSide,  halfSide, -halfSide},      {0.0f, 0.0f, -1.0f},    {1.0f, 1.0f}},
-		{{-halfSide,  halfSide, -halfSide},     {0.0f, 0.0f, -1.0f},    {0.0f, 1.0f}},
-		{{-halfSide, -halfSide, -halfSide},     {0.0f, 0.0f, -1.0f},    {0.0f, 0.0f}}, //Front
-
-		{{-halfSide, -halfSide,  halfSide},     {0.0f, 0.0f, 1.0f},     {0.0f, 0.0f}},
-		{{halfSide, -halfSide,  halfSide},      {0.0f, 0.0f, 1.0f},     {1.0f, 0.0f}},
-		{{halfSide,  halfSide,  halfSide},      {0.0f, 0.0f, 1.0f},     {1.0f, 1.0f}},
-		{{halfSide,  halfSide,  halfSide},      {0.0f, 0.0f, 1.0f},     {1.0f, 1.0f}},
-		{{-halfSide,  halfSide,  halfSide},     {0.0f, 0.0f, 1.0f},     {0.0f, 1.0f}},
-		{{-halfSide, -halfSide,  halfSide},     {0.0f, 0.0f, 1.0f},     {0.0f, 0.0f}}, //Back
-
-		{{-halfSide,  halfSide,  halfSide},     {-1.0f, 0.0f, 0.0f},    {1.0f, 0.0f}},
-		{{-halfSide,  halfSide, -halfSide},     {-1.0f, 0.0f, 0.0f},    {1.0f, 1.0f}},
-		{{-halfSide, -halfSide, -halfSide},     {-1.0f, 0.0f, 0.0f},    {0.0f, 1.0f}},
-		{{-halfSide, -halfSide, -halfSide},     {-1.0f, 0.0f, 0.0f},    {0.0f, 1.0f}},
-		{{-halfSide, -halfSide,  halfSide},     {-1.0f, 0.0f, 0.0f},    {0.0f, 0.0f}},
-		{{-halfSide,  halfSide,  halfSide},     {-1.0f, 0.0f, 0.0f},    {1.0f, 0.0f}}, //Left
-
-		{{halfSide,  halfSide,  halfSide},      {1.0f, 0.0f, 0.0f},     {1.0f, 0.0f}},
-		{{halfSide,  halfSide, -halfSide},      {1.0f, 0.0f, 0.0f},     {1.0f, 1.0f}},
-		{{halfSide, -halfSide, -halfSide},      {1.0f, 0.0f, 0.0f},     {0.0f, 1.0f}},
-		{{halfSide, -halfSide, -halfSide},      {1.0f, 0.0f, 0.0f},     {0.0f, 1.0f}},
-		{{halfSide, -halfSide,  halfSide},      {1.0f, 0.0f, 0.0f},     {0.0f, 0.0f}},
-		{{halfSide,  halfSide,  halfSide},      {1.0f, 0.0f, 0.0f},     {1.0f, 0.0f}}, //Right
-
-		{{-halfSide, -halfSide, -halfSide},     {0.0f -1.0f, 0.0f},     {0.0f, 1.0f}},
-		{{halfSide, -halfSide, -halfSide},      {0.0f -1.0f, 0.0f},     {1.0f, 1.0f}},
-		{{halfSide, -halfSide,  halfSide},      {0.0f -1.0f, 0.0f},     {1.0f, 0.0f}},
-		{{halfSide, -halfSide,  halfSide},      {0.0f -1.0f, 0.0f},     {1.0f, 0.0f}},
-		{{-halfSide, -halfSide,  halfSide},     {0.0f -1.0f, 0.0f},     {0.0f, 0.0f}},
-		{{-halfSide, -halfSide, -halfSide},     {0.0f -1.0f, 0.0f},     {0.0f, 1.0f}}, //Bottom
-
-		{{-halfSide,  halfSide, -halfSide},     {0.0f, 1.0f, 0.0f},     {0.0f, 1.0f}},
-		{{halfSide,  halfSide, -halfSide},      {0.0f, 1.0f, 0.0f},     {1.0f, 1.0f}},
-		{{halfSide,  halfSide,  halfSide},      {0.0f, 1.0f, 0.0f},     {1.0f, 0.0f}},
-		{{halfSide,  halfSide,  halfSide},      {0.0f, 1.0f, 0.0f},     {1.0f, 0.0f}},
-		{{-halfSide,  halfSide,  halfSide},     {0.0f, 1.0f, 0.0f},     {0.0f, 0.0f}},
-		{{-halfSide,  halfSide, -halfSide},     {0.0f, 1.0f, 0.0f},     {0.0f, 1.0f}}  //Top
-	};
-
-	return vertices;
+    std::vector<struct Vertex> vertices(CUBE_VERTICES, CUBE_VERTICES + CUBE_VERTEX_COUNT);
+    for(size_t v = 0; v < vertices.size(); v++)
+        for(int k = 0; k < 3; k++)
+            vertices[v].position[k] *= sideLength;
+
+    return vertices;
 }
 
 #endif // CUBE_H
@@ -0,0 +1,296 @@
+#ifndef DEBUG_DRAW_H
+#define DEBUG_DRAW_H
+
+#include <vector>
+
+#include "Introduction.h"
+#include "PerformanceStats.h"
+#include "GPUResources.h"
+#include "GraphicsObject.h"
+
+/*
+ * Immediate mode debug lines. Anything can add lines at any point in the frame and they are all
+ * drawn with one glDrawArrays when the frame calls Flush, then forgotten.
+ *
+ * The lines go straight into a buffer that stays mapped (GL 4.4 / ARB_buffer_storage), split into a
+ * region per frame in flight. A fence after each frame's draw says when its region can be written again,
+ * so the CPU never waits on the GPU unless it gets DEBUG_DRAW_REGIONS frames ahead.
+ * Without buffer storage the lines are gathered in memory and copied into the region with glBufferSubData.
+ *
+ * Vertices are just a float position and a byte colour, 16 bytes against the 56 of a struct Vertex.
+ * Lines past the capacity are dropped (and counted) rather than flushed early, as a flush needs the camera.
+ */
+
+/* Frames of lines the buffer holds at once */
+const int DEBUG_DRAW_REGIONS = 3;
+
+/* Lines per frame for the shared debugDraw */
+const int DEBUG_DRAW_MAX_LINES = 65536;
+
+struct DebugVertex
+{
+    GLfloat position[3];
+    GLubyte colour[4];
+};
+
+class DebugDraw
+{
+public:
+    int droppedLines;       //Lines that didn't fit since the last Flush
+    int lastDroppedLines;   //Lines that didn't fit in the last frame flushed, for showing in the menu
+    long totalDroppedLines; //Since the start
+    bool persistent;        //Whether the buffer is persistently mapped, once it has been made
+
+    DebugDraw(int maxLines) : droppedLines(0), lastDroppedLines(0), totalDroppedLines(0), persistent(false), capacity(2 * maxLines), used(0), region(0),
+                              shader(NULL), mapped(NULL), writeBase(NULL)
+    {
+        for(int r = 0; r < DEBUG_DRAW_REGIONS; r++)
+            fences[r] = 0;
+    }
+
+    void AddLine(glm::vec3 start, glm::vec3 end, GLfloat colour[3])
+    {
+        DebugVertex* out = Reserve(2);
+        if(out == NULL)
+            return;
+
+        GLubyte packed[4];
+        PackColour(colour, packed);
+        WriteVertex(out[0], start, packed);
+        WriteVertex(out[1], end, packed);
+    }
+
+    /* The twelve edges of an axis-aligned box */
+    void AddAABB(glm::vec3 minimum, glm::vec3 maximum, GLfloat colour[3])
+    {
+        glm::vec3 corners[8];
+        for(int c = 0; c < 8; c++)
+            corners[c] = glm::vec3((c & 1) ? maximum.x : minimum.x, (c & 2) ? maximum.y : minimum.y, (c & 4) ? maximum.z : minimum.z);
+        AddBox(corners, colour);
+    }
+
+    /* The edges of the volume a view-projection matrix can see, e.g. another camera's */
+    void AddFrustum(glm::mat4 viewProjection, GLfloat colour[3])
+    {
+        glm::mat4 inverse = glm::inverse(viewProjection);
+        glm::vec3 corners[8];
+        for(int c = 0; c < 8; c++)
+        {
+            glm::vec4 corner = inverse * glm::vec4((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f, 1.0f);
+            corners[c] = glm::vec3(corner) / corner.w;
+        }
+        AddBox(corners, colour);
+    }
+
+    /* A line of the given length (in world units) out along every vertex normal of a mesh drawn with this model matrix */
+    void AddNormals(const std::vector<struct Vertex>& vertices, glm::mat4 model, float length, GLfloat colour[3])
+    {
+        DebugVertex* out = Reserve(2 * (int)vertices.size());
+        if(out == NULL)
+            return;
+
+        GLubyte packed[4];
+        PackColour(colour, packed);
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+        for(size_t v = 0; v < vertices.size(); v++)
+        {
+            const struct Vertex& vertex = vertices[v];
+            glm::vec3 position = glm::vec3(model * glm::vec4(vertex.position[0], vertex.position[1], vertex.position[2], 1.0f));
+            glm::vec3 normal = glm::normalize(normalMatrix * glm::vec3(vertex.normal[0], vertex.normal[1], vertex.normal[2]));
+            WriteVertex(*out++, position, packed);
+            WriteVertex(*out++, position + length * normal, packed);
+        }
+    }
+
+    /* The same for an object, at the level of detail it would be drawn with. The vertices are read back from the
+       mesh's buffer, which stalls, so NormalVisualiser is the one to use every frame */
+    void AddNormals(GraphicsObject& object, glm::mat4 view, glm::mat4 projection, float length, GLfloat colour[3])
+    {
+        glm::mat4 model = object.GetModelMatrix();
+        object.SelectMesh(model, view, projection)->ReadVertices(readBack);
+        AddNormals(readBack, model, length, colour);
+    }
+
+    /* Draw everything added since the last Flush, and move on to the next region */
+    void Flush(glm::mat4 view, glm::mat4 projection)
+    {
+        if(used > 0)
+        {
+            GLint first = region * capacity;
+
+            glBindBuffer(GL_ARRAY_BUFFER, gpuResources.Get(this->vertexBuffer));
+            if(!persistent)
+            {
+                glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(DebugVertex), used * sizeof(DebugVertex), writeBase);
+                perfStats.AddBufferUpload(used * sizeof(DebugVertex), false);
+            }
+
+            shader->Use();
+            glm::mat4 viewProjection = projection * view;
+            glUniformMatrix4fv(glGetUniformLocation(shader->getShaderProgram(), "viewProjection"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+
+            glBindVertexArray(gpuResources.Get(this->vertexArray));
+            glDrawArrays(GL_LINES, first, used);
+            glBindVertexArray(0);
+
+            //Program, matrix and VAO
+            perfStats.AddStateChanges(3);
+            perfStats.AddDraw(GL_LINES, used);
+
+            fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            region = (region + 1) % DEBUG_DRAW_REGIONS;
+            used = 0;
+
+            //The GPU has usually finished with this region long ago, so this rarely waits
+            if(fences[region] != 0)
+            {
+                glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+                glDeleteSync(fences[region]);
+                fences[region] = 0;
+            }
+            if(persistent)
+                writeBase = mapped + region * capacity;
+        }
+        lastDroppedLines = droppedLines;
+        totalDroppedLines += droppedLines;
+        droppedLines = 0;
+    }
+
+    /* Delete the GL objects. Like the meshes, not done in a destructor as the shared one outlives the context */
+    void Release()
+    {
+        if(vertexBuffer.IsNull())
+            return;
+
+        for(int r = 0; r < DEBUG_DRAW_REGIONS; r++)
+        {
+            if(fences[r] != 0)
+                glDeleteSync(fences[r]);
+            fences[r] = 0;
+        }
+        //Unmapped now, but only deleted once the GPU's drawn the last lines out of it
+        glBindBuffer(GL_ARRAY_BUFFER, gpuResources.Get(this->vertexBuffer));
+        if(persistent)
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        gpuResources.Destroy(this->vertexArray);
+        gpuResources.Destroy(this->vertexBuffer);
+        shader->Release();
+        delete shader;
+        perfStats.ReleaseBuffer(BufferBytes());
+
+        shader = NULL;
+        writeBase = NULL;
+        used = 0;
+    }
+
+private:
+    int capacity;   //Vertices in each region
+    int used;       //Vertices written into the current region
+    int region;
+    GPUHandle vertexArray, vertexBuffer;
+    GLsync fences[DEBUG_DRAW_REGIONS];
+    Shader* shader;
+    DebugVertex* mapped;                //Start of the whole buffer, when it's persistently mapped
+    DebugVertex* writeBase;             //Where the current region's vertices go
+    std::vector<DebugVertex> gathered;  //Used instead of the mapping without buffer storage
+    std::vector<struct Vertex> readBack;    //AddNormals' copy of an object's vertices
+
+    long BufferBytes() const
+    {
+        return (long)DEBUG_DRAW_REGIONS * capacity * sizeof(DebugVertex);
+    }
+
+    /* Make the buffer, VAO and shader the first time a line is added */
+    void Create()
+    {
+        shader = new Shader("Shaders/DebugLines.vert", "Shaders/DebugLines.frag");
+
+        this->vertexArray = gpuResources.Create(GPU_VERTEX_ARRAY);
+        this->vertexBuffer = gpuResources.Create(GPU_BUFFER);
+        glBindVertexArray(gpuResources.Get(this->vertexArray));
+        glBindBuffer(GL_ARRAY_BUFFER, gpuResources.Get(this->vertexBuffer));
+
+        persistent = GLEW_ARB_buffer_storage;
+        if(persistent)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_ARRAY_BUFFER, BufferBytes(), NULL, flags);
+            mapped = (DebugVertex*)glMapBufferRange(GL_ARRAY_BUFFER, 0, BufferBytes(), flags);
+            writeBase = mapped + region * capacity;
+        }
+        else
+        {
+            glBufferData(GL_ARRAY_BUFFER, BufferBytes(), NULL, GL_STREAM_DRAW);
+            gathered.resize(capacity);
+            mapped = NULL;
+            writeBase = &gathered[0];
+        }
+        gpuResources.SetBytes(this->vertexBuffer, BufferBytes());
+        perfStats.bufferMemory += BufferBytes();
+
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (const GLvoid*) offsetof (DebugVertex, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DebugVertex), (const GLvoid*) offsetof (DebugVertex, colour));
+        glEnableVertexAttribArray(1);
+
+        glBindVertexArray(0);
+    }
+
+    /* Room for count more vertices in this frame's region, or NULL if they don't fit */
+    DebugVertex* Reserve(int count)
+    {
+        if(writeBase == NULL)
+            Create();
+
+        if(used + count > capacity)
+        {
+            droppedLines += count / 2;
+            return NULL;
+        }
+        DebugVertex* out = writeBase + used;
+        used += count;
+        return out;
+    }
+
+    /* Corners numbered by bits: 1 = +x, 2 = +y, 4 = +z */
+    void AddBox(const glm::vec3 corners[8], GLfloat colour[3])
+    {
+        DebugVertex* out = Reserve(24);
+        if(out == NULL)
+            return;
+
+        GLubyte packed[4];
+        PackColour(colour, packed);
+        for(int c = 0; c < 8; c++)
+        {
+            for(int axis = 1; axis < 8; axis <<= 1)
+            {
+                if(c & axis)
+                    continue;
+                WriteVertex(*out++, corners[c], packed);
+                WriteVertex(*out++, corners[c | axis], packed);
+            }
+        }
+    }
+
+    static void PackColour(GLfloat colour[3], GLubyte packed[4])
+    {
+        for(int k = 0; k < 3; k++)
+            packed[k] = (GLubyte)(glm::clamp(colour[k], 0.0f, 1.0f) * 255.0f + 0.5f);
+        packed[3] = 255;
+    }
+
+    static void WriteVertex(DebugVertex& out, glm::vec3 position, const GLubyte colour[4])
+    {
+        out.position[0] = position.x;
+        out.position[1] = position.y;
+        out.position[2] = position.z;
+        for(int k = 0; k < 4; k++)
+            out.colour[k] = colour[k];
+    }
+};
+
+/* Lines from anywhere in the program, drawn at the end of each frame */
+DebugDraw debugDraw(DEBUG_DRAW_MAX_LINES);
+
+#endif // DEBUG_DRAW_H
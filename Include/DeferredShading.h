@@ -0,0 +1,189 @@
+#ifndef DEFERRED_SHADING_H
+#define DEFERRED_SHADING_H
+
+#include <iostream>
+
+#include "Introduction.h"
+#include "PerformanceStats.h"
+#include "GPUResources.h"
+#include "PointLights.h"
+
+/*
+ * Deferred shading, as an alternative to lighting every fragment as it's drawn.
+ *
+ * Between BeginGeometry and Light the scene is drawn as normal but with SHADER_GBUFFER, which writes each
+ * fragment's surface colour and normal to the G-buffer instead of lighting it. Light then lights each pixel
+ * that ended up on screen once: the main light with one triangle over the screen, then each point light with
+ * a quad over just the pixels its sphere can reach, added on with blending. So the lighting costs the same
+ * however many triangles and however much overdraw there was, and a light costs the pixels it covers.
+ *
+ * The G-buffer is 12 bytes a pixel:
+ *  - colour:  GL_RGBA8, the surface colour (alpha isn't used)
+ *  - normal:  GL_RG16, octahedral encoded (see packNormal in Object.frag)
+ *  - depth:   GL_DEPTH24_STENCIL8, which the position is worked back out from with the inverse view-projection.
+ *             It's the same format as the window's, so it can be blitted across for anything drawn afterwards
+ *
+ * There's no blending in the G-buffer, so it's only for opaque lit objects.
+ */
+
+class DeferredRenderer
+{
+public:
+    DeferredRenderer() : width(0), height(0), mainLight(NULL), pointLight(NULL) {}
+
+    /* Make the G-buffer (or remake it at a new size), bind it and clear it, ready for the SHADER_GBUFFER draws */
+    void BeginGeometry(int viewportWidth, int viewportHeight)
+    {
+        if(viewportWidth != width || viewportHeight != height)
+            Create(viewportWidth, viewportHeight);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, gpuResources.Get(framebuffer));
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        perfStats.AddStateChanges(1);
+    }
+
+    /* Light the G-buffer into the window's framebuffer, and copy its depth across so more can be drawn on top */
+    void Light(glm::mat4 view, glm::mat4 projection, PointLights& lights)
+    {
+        glm::mat4 viewProjection = projection * view;
+        glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDisable(GL_DEPTH_TEST);
+        glDepthMask(GL_FALSE);
+        for(int t = 0; t < 3; t++)
+        {
+            glActiveTexture(GL_TEXTURE0 + t);
+            glBindTexture(GL_TEXTURE_2D, gpuResources.Get(textures[t]));
+        }
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(gpuResources.Get(vertexArray));
+
+        //Main light and ambient, which also clears wherever nothing was drawn
+        mainLight->Use();
+        glUniformMatrix4fv(glGetUniformLocation(mainLight->getShaderProgram(), "inverseViewProjection"), 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        perfStats.AddDraw(GL_TRIANGLES, 3);
+
+        //Then every point light added on, read as instance attributes straight from the light buffer
+        if(lights.Count() > 0)
+        {
+            lights.Upload();
+            glBindBuffer(GL_ARRAY_BUFFER, lights.GetBuffer());
+            glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(PointLight), (const GLvoid*)(POINT_LIGHTS_OFFSET + offsetof(PointLight, positionRadius)));
+            glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(PointLight), (const GLvoid*)(POINT_LIGHTS_OFFSET + offsetof(PointLight, colour)));
+            glEnableVertexAttribArray(0);
+            glEnableVertexAttribArray(1);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            pointLight->Use();
+            glUniformMatrix4fv(glGetUniformLocation(pointLight->getShaderProgram(), "viewProjection"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+            glUniformMatrix4fv(glGetUniformLocation(pointLight->getShaderProgram(), "inverseViewProjection"), 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_ONE, GL_ONE);
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, lights.Count());
+            glDisable(GL_BLEND);
+            glDisableVertexAttribArray(0);
+            glDisableVertexAttribArray(1);
+            perfStats.AddDraw(GL_TRIANGLE_STRIP, 4 * lights.Count());
+        }
+        glBindVertexArray(0);
+
+        //The scene's depth, for debug lines and the like
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, gpuResources.Get(framebuffer));
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glDepthMask(GL_TRUE);
+        glEnable(GL_DEPTH_TEST);
+
+        //Framebuffer, three textures, VAO, two programs and their matrices, attribute pointers, blending and depth
+        perfStats.AddStateChanges(14);
+    }
+
+    /* Bytes of G-buffer, 12 a pixel */
+    long GetBytes() const
+    {
+        return 12L * width * height;
+    }
+
+    void Release()
+    {
+        if(framebuffer.IsNull())
+            return;
+
+        gpuResources.Destroy(framebuffer);
+        for(int t = 0; t < 3; t++)
+            gpuResources.Destroy(textures[t]);
+        gpuResources.Destroy(vertexArray);
+        perfStats.ReleaseTexture(GetBytes());
+        mainLight->Release();
+        pointLight->Release();
+        delete mainLight;
+        delete pointLight;
+        mainLight = pointLight = NULL;
+        width = height = 0;
+    }
+
+private:
+    int width, height;
+    GPUHandle framebuffer;
+    GPUHandle textures[3];  //Colour, normal, depth, on texture units 0 to 2 when lighting
+    GPUHandle vertexArray;  //For the light quads' attributes, which are only enabled for them. The main light has none
+    Shader* mainLight;
+    Shader* pointLight;
+
+    void Create(int newWidth, int newHeight)
+    {
+        Release();
+        width = newWidth;
+        height = newHeight;
+
+        const GLenum formats[3] = {GL_RGBA8, GL_RG16, GL_DEPTH24_STENCIL8};
+        const GLenum uploadFormats[3] = {GL_RGBA, GL_RG, GL_DEPTH_STENCIL};
+        const GLenum types[3] = {GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT_24_8};
+        const GLenum attachments[3] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_DEPTH_STENCIL_ATTACHMENT};
+
+        framebuffer = gpuResources.Create(GPU_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, gpuResources.Get(framebuffer));
+        for(int t = 0; t < 3; t++)
+        {
+            textures[t] = gpuResources.Create(GPU_TEXTURE);
+            glBindTexture(GL_TEXTURE_2D, gpuResources.Get(textures[t]));
+            glTexImage2D(GL_TEXTURE_2D, 0, formats[t], width, height, 0, uploadFormats[t], types[t], NULL);
+            //Only ever read with texelFetch, but a texture without mipmaps isn't complete unless it's told so
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, attachments[t], GL_TEXTURE_2D, gpuResources.Get(textures[t]), 0);
+            gpuResources.SetBytes(textures[t], 4L * width * height);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        perfStats.textureMemory += GetBytes();
+
+        const GLenum drawBuffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glDrawBuffers(2, drawBuffers);
+        if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "G-buffer framebuffer isn't complete" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        vertexArray = gpuResources.Create(GPU_VERTEX_ARRAY);
+        glBindVertexArray(gpuResources.Get(vertexArray));
+        glVertexAttribDivisor(0, 1);
+        glVertexAttribDivisor(1, 1);
+        glBindVertexArray(0);
+
+        mainLight = new Shader("Shaders/DeferredLight.vert", NULL, "Shaders/DeferredLight.frag", "#define MAIN_LIGHT\n", true);
+        pointLight = new Shader("Shaders/DeferredLight.vert", NULL, "Shaders/DeferredLight.frag", "", true);
+        const char* samplers[3] = {"gAlbedo", "gNormal", "gDepth"};
+        for(int t = 0; t < 3; t++)
+        {
+            mainLight->BindSampler(samplers[t], t);
+            pointLight->BindSampler(samplers[t], t);
+        }
+    }
+};
+
+/* The G-buffer and lighting passes for the main loop's deferred path */
+DeferredRenderer deferredRenderer;
+
+#endif // DEFERRED_SHADING_H
@@ -0,0 +1,149 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "Simulation.h"
+
+/* What the GL thread tells the simulation about the frame it should produce */
+struct FrameInput
+{
+    AnimatedScene* scene;   //May be NULL when the selected scene isn't animated
+    double frameTime;
+    double timeScale;
+};
+
+/* Everything the GL thread needs to submit one frame of an animated scene */
+struct FrameSnapshot
+{
+    std::vector<DrawItem> drawList;
+    int simulationSteps;
+
+    FrameSnapshot() : simulationSteps(0) {}
+};
+
+/* Step the scene and record where everything should be drawn. Must not touch the GL or ImGui */
+void ProduceFrame(FrameSnapshot& snapshot, const FrameInput& input)
+{
+    snapshot.drawList.clear();
+    snapshot.simulationSteps = 0;
+    if(input.scene == NULL)
+        return;
+
+    snapshot.simulationSteps = input.scene->Advance(input.frameTime, input.timeScale);
+    input.scene->BuildDrawList(snapshot.drawList);
+}
+
+/*
+ * Two-stage update/render pipeline.
+ * With pipelining on, a worker thread produces frame N+1 into one snapshot while the GL
+ * thread submits frame N from the other, so simulation overlaps with driver time at the
+ * cost of one frame of latency. With it off, the snapshot is produced inline.
+ */
+class FramePipeline
+{
+public:
+    bool pipelined;
+
+    FramePipeline() : pipelined(true), front(0), workPending(false), workInFlight(false), stopping(false)
+    {
+        worker = std::thread(&FramePipeline::WorkerLoop, this);
+    }
+
+    ~FramePipeline()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+    }
+
+    /* Called once per frame on the GL thread. Returns the snapshot to submit this frame */
+    FrameSnapshot& BeginFrame(const FrameInput& input)
+    {
+        if(!pipelined)
+        {
+            WaitForWorker();
+            ProduceFrame(snapshots[front], input);
+            return snapshots[front];
+        }
+
+        //Frame N was produced by the worker during the last frame, unless we've only just switched over.
+        //In that case it's produced here with this frame's time, so the worker gets a step of no time to
+        //start the pipeline off rather than the same time again
+        FrameInput next = input;
+        if(workInFlight)
+        {
+            WaitForWorker();
+        }
+        else
+        {
+            ProduceFrame(snapshots[1 - front], input);
+            next.frameTime = 0.0;
+        }
+
+        front = 1 - front;
+
+        //Start on frame N+1 while the caller submits frame N
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pendingInput = next;
+            workPending = true;
+            workInFlight = true;
+        }
+        wake.notify_all();
+
+        return snapshots[front];
+    }
+
+    /* Block until the worker has finished with the back snapshot and the scene it was stepping */
+    void WaitForWorker()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]{ return !workInFlight; });
+    }
+
+private:
+    FrameSnapshot snapshots[2];
+    int front;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    FrameInput pendingInput;
+    bool workPending;
+    bool workInFlight;
+    bool stopping;
+
+    void WorkerLoop()
+    {
+        while(true)
+        {
+            FrameInput input;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]{ return workPending || stopping; });
+                if(stopping)
+                    return;
+                input = pendingInput;
+                workPending = false;
+            }
+
+            //The GL thread only ever reads snapshots[front], so the back one is ours
+            ProduceFrame(snapshots[1 - front], input);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                workInFlight = false;
+            }
+            done.notify_all();
+        }
+    }
+};
+
+#endif // FRAME_PIPELINE_H
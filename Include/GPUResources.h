@@ -0,0 +1,286 @@
+#ifndef GPU_RESOURCES_H
+#define GPU_RESOURCES_H
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <iostream>
+
+#include <GL/glew.h>
+
+#include "ImGUI/imgui.h"
+
+/*
+ * Owns the GL objects the meshes, shaders, streamed textures and G-buffer make, behind generational handles.
+ *
+ * A handle is a slot and the generation of the object in it. Destroying an object moves the slot on a generation,
+ * so a handle kept by mistake (e.g. in a copy of a Shader) finds nothing instead of whatever's made in the slot
+ * next, and destroying it twice does nothing.
+ *
+ * Destroyed objects aren't deleted straight away, as the GPU may still be drawing with them and some drivers stall
+ * deleting something in use. Each frame's deletions wait behind a fence made in EndFrame and are only done once
+ * it's signalled (without GL_ARB_sync, once GPU_DELETE_DELAY_FRAMES frames have gone by). Nothing ever waits:
+ * anything not finished yet is looked at again next frame.
+ */
+
+enum GPUResourceType
+{
+    GPU_BUFFER,
+    GPU_VERTEX_ARRAY,
+    GPU_TEXTURE,
+    GPU_PROGRAM,
+    GPU_FRAMEBUFFER,
+    GPU_RESOURCE_TYPES
+};
+
+const char* const GPU_RESOURCE_NAMES[GPU_RESOURCE_TYPES] = {"Buffers", "Vertex arrays", "Textures", "Programs", "Framebuffers"};
+
+/* Frames deletions are held for when there are no fences, which is further ahead than drivers let the CPU get */
+const int GPU_DELETE_DELAY_FRAMES = 3;
+
+/* One GL object. A generation of 0 is no object */
+struct GPUHandle
+{
+    uint32_t index;
+    uint32_t generation;
+
+    GPUHandle() : index(0), generation(0) {}
+
+    bool IsNull() const
+    {
+        return generation == 0;
+    }
+};
+
+class GPUResources
+{
+public:
+    /* Objects alive and their bytes, by GPUResourceType. Bytes are whatever the owner said with SetBytes */
+    int liveCount[GPU_RESOURCE_TYPES];
+    long liveBytes[GPU_RESOURCE_TYPES];
+    /* Destroyed but waiting for the GPU */
+    int pendingCount;
+    long pendingBytes;
+    long deletedCount;  //Since the start
+
+    GPUResources() : pendingCount(0), pendingBytes(0), deletedCount(0), frame(0)
+    {
+        for(int t = 0; t < GPU_RESOURCE_TYPES; t++)
+        {
+            liveCount[t] = 0;
+            liveBytes[t] = 0;
+        }
+    }
+
+    /* Make a new object of a type */
+    GPUHandle Create(GPUResourceType type)
+    {
+        GLuint name = 0;
+        switch(type)
+        {
+            case GPU_BUFFER: glGenBuffers(1, &name); break;
+            case GPU_VERTEX_ARRAY: glGenVertexArrays(1, &name); break;
+            case GPU_TEXTURE: glGenTextures(1, &name); break;
+            case GPU_PROGRAM: name = glCreateProgram(); break;
+            case GPU_FRAMEBUFFER: glGenFramebuffers(1, &name); break;
+            default: break;
+        }
+        return Adopt(type, name);
+    }
+
+    /* Take ownership of an object made somewhere else, e.g. by LoadTextureFile. A name of 0 gives a null handle */
+    GPUHandle Adopt(GPUResourceType type, GLuint name, long bytes = 0)
+    {
+        GPUHandle handle;
+        if(name == 0)
+            return handle;
+
+        if(freeSlots.empty())
+        {
+            Slot slot = {0, 1, type, 0};
+            freeSlots.push_back((uint32_t)slots.size());
+            slots.push_back(slot);
+        }
+        handle.index = freeSlots.back();
+        freeSlots.pop_back();
+
+        Slot& slot = slots[handle.index];
+        slot.name = name;
+        slot.type = type;
+        slot.bytes = bytes;
+        handle.generation = slot.generation;
+        liveCount[type]++;
+        liveBytes[type] += bytes;
+        return handle;
+    }
+
+    /* The GL name, or 0 if the handle's null or its object has been destroyed */
+    GLuint Get(GPUHandle handle) const
+    {
+        if(handle.generation == 0 || handle.index >= slots.size() || slots[handle.index].generation != handle.generation)
+            return 0;
+        return slots[handle.index].name;
+    }
+
+    bool IsAlive(GPUHandle handle) const
+    {
+        return Get(handle) != 0;
+    }
+
+    /* Say how much memory an object has, once it's been given its storage */
+    void SetBytes(GPUHandle handle, long bytes)
+    {
+        if(!IsAlive(handle))
+            return;
+        Slot& slot = slots[handle.index];
+        liveBytes[slot.type] += bytes - slot.bytes;
+        slot.bytes = bytes;
+    }
+
+    /* Finish with an object. It's deleted once the GPU is done with this frame, and the handle is made null */
+    void Destroy(GPUHandle& handle)
+    {
+        if(IsAlive(handle))
+        {
+            Slot& slot = slots[handle.index];
+            Deletion deletion = {slot.type, slot.name, slot.bytes};
+            thisFrame.push_back(deletion);
+            liveCount[slot.type]--;
+            liveBytes[slot.type] -= slot.bytes;
+            pendingCount++;
+            pendingBytes += slot.bytes;
+
+            //On to the next generation, skipping 0 if it ever wraps round
+            slot.generation = (slot.generation == UINT32_MAX) ? 1 : slot.generation + 1;
+            slot.name = 0;
+            slot.bytes = 0;
+            freeSlots.push_back(handle.index);
+        }
+        handle = GPUHandle();
+    }
+
+    /* Once a frame, after its last draw: fence this frame's deletions and do any that the GPU has finished with */
+    void EndFrame()
+    {
+        frame++;
+        if(!thisFrame.empty())
+        {
+            batches.push_back(PendingBatch());
+            PendingBatch& batch = batches.back();
+            batch.deletions.swap(thisFrame);
+            batch.fence = GLEW_ARB_sync ? glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) : 0;
+            batch.frame = frame;
+        }
+
+        //Batches finish in order, so stop at the first that hasn't
+        while(!batches.empty())
+        {
+            PendingBatch& oldest = batches.front();
+            bool done;
+            if(oldest.fence != 0)
+            {
+                GLenum status = glClientWaitSync(oldest.fence, 0, 0);
+                done = (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED);
+            }
+            else
+            {
+                done = frame - oldest.frame >= GPU_DELETE_DELAY_FRAMES;
+            }
+            if(!done)
+                break;
+            Delete(oldest);
+            batches.pop_front();
+        }
+    }
+
+    /* Wait for the GPU and delete everything that's been destroyed, e.g. before measuring memory or quitting */
+    void Flush()
+    {
+        glFinish();
+        EndFrame();
+        while(!batches.empty())
+        {
+            Delete(batches.front());
+            batches.pop_front();
+        }
+    }
+
+    /* Slots made so far, in use or free. Stays put once creation and destruction are balanced */
+    int SlotCount() const
+    {
+        return (int)slots.size();
+    }
+
+    /* Counts and memory by type, inside whichever ImGui window is currently open */
+    void DrawPanel()
+    {
+        if(!ImGui::CollapsingHeader("GPU resources"))
+            return;
+
+        for(int t = 0; t < GPU_RESOURCE_TYPES; t++)
+            ImGui::Text("%s: %d, %.2f MB", GPU_RESOURCE_NAMES[t], liveCount[t], liveBytes[t] / (1024.0f * 1024.0f));
+        ImGui::Text("Waiting to be deleted: %d, %.2f MB", pendingCount, pendingBytes / (1024.0f * 1024.0f));
+    }
+
+private:
+    struct Slot
+    {
+        GLuint name;
+        uint32_t generation;
+        GPUResourceType type;
+        long bytes;
+    };
+
+    struct Deletion
+    {
+        GPUResourceType type;
+        GLuint name;
+        long bytes;
+    };
+
+    /* One frame's deletions and the fence after its last draw */
+    struct PendingBatch
+    {
+        std::vector<Deletion> deletions;
+        GLsync fence;
+        int frame;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::vector<Deletion> thisFrame;
+    std::deque<PendingBatch> batches;
+    int frame;
+
+    /* Delete a batch's objects, as few calls as possible for each type */
+    void Delete(PendingBatch& batch)
+    {
+        if(batch.fence != 0)
+            glDeleteSync(batch.fence);
+
+        std::vector<GLuint> names[GPU_RESOURCE_TYPES];
+        for(size_t d = 0; d < batch.deletions.size(); d++)
+        {
+            names[batch.deletions[d].type].push_back(batch.deletions[d].name);
+            pendingBytes -= batch.deletions[d].bytes;
+        }
+        if(!names[GPU_BUFFER].empty())
+            glDeleteBuffers((GLsizei)names[GPU_BUFFER].size(), names[GPU_BUFFER].data());
+        if(!names[GPU_VERTEX_ARRAY].empty())
+            glDeleteVertexArrays((GLsizei)names[GPU_VERTEX_ARRAY].size(), names[GPU_VERTEX_ARRAY].data());
+        if(!names[GPU_TEXTURE].empty())
+            glDeleteTextures((GLsizei)names[GPU_TEXTURE].size(), names[GPU_TEXTURE].data());
+        for(size_t p = 0; p < names[GPU_PROGRAM].size(); p++)
+            glDeleteProgram(names[GPU_PROGRAM][p]);
+        if(!names[GPU_FRAMEBUFFER].empty())
+            glDeleteFramebuffers((GLsizei)names[GPU_FRAMEBUFFER].size(), names[GPU_FRAMEBUFFER].data());
+
+        pendingCount -= (int)batch.deletions.size();
+        deletedCount += (long)batch.deletions.size();
+    }
+};
+
+/* Every GL object the demo makes and gets rid of while it's running */
+GPUResources gpuResources;
+
+#endif // GPU_RESOURCES_H
@@ -2,6 +2,17 @@
 #define GRAPHICS_OBJECT_H
 
 #include "Introduction.h"
+#include "UniformBuffers.h"
+#include "ShaderPermutations.h"
+#include "TextureStreaming.h"
+
+/*
+ * Level of detail selection. An object draws the cheapest level of its mesh whose
+ * error, projected onto the screen, is no more than lodPixelError pixels.
+ */
+bool lodEnabled = true;
+float lodPixelError = 2.0f;
+float lodViewportHeight = 800.0f;
 
 class GraphicsObject
 {
@@ -9,40 +20,101 @@ public:
     Mesh* mesh;
     glm::vec3 worldPosition;
     glm::quat rotation;
+    float scale; //Uniform scale, so that one unit-sized mesh can be shared by objects of any size
 
-    GraphicsObject(Mesh* myMesh, glm::vec3 initialPosition, glm::quat initialRotation)
+    GraphicsObject(Mesh* myMesh, glm::vec3 initialPosition, glm::quat initialRotation, float initialScale = 1.0f)
     {
         mesh = myMesh;
         worldPosition = initialPosition;
         rotation = initialRotation;
+        scale = initialScale;
     }
 
     void Draw(Shader shader, glm::mat4 view, glm::mat4 projection)
+    {
+        Draw(shader, GetModelMatrix(), view, projection);
+    }
+
+    glm::mat4 GetModelMatrix() const
     {
         glm::mat4 model;
         model = glm::translate(model, this->worldPosition);
         model = glm::rotate(model, glm::angle(rotation), glm::axis(rotation));
+        model = glm::scale(model, glm::vec3(this->scale));
+        return model;
+    }
 
-        glm::mat4 MVP = projection * view * model;
+    /* Alternative version of Draw takes the transform of the object directly (scale and all) */
+    void Draw(Shader shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+    {
+        SetUp(model, view, projection)->Draw(shader);
+    }
 
-        GLint mvpLocation = glGetUniformLocation(shader.getShaderProgram(), "MVPmatrix");
-        glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, glm::value_ptr(MVP));
+    /* Draw with the cheapest permutation that has the features wanted and the mesh can use */
+    void Draw(ShaderPermutations& shaders, unsigned features, glm::mat4 view, glm::mat4 projection)
+    {
+        Draw(shaders, features, GetModelMatrix(), view, projection);
+    }
 
-        mesh->Draw(shader);
+    void Draw(ShaderPermutations& shaders, unsigned features, glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+    {
+        Mesh* drawMesh = SetUp(model, view, projection);
+        drawMesh->Draw(shaders.Use(drawMesh->GetShaderFeatures(features)));
     }
 
-    /* Alternative version of Draw takes the transform of the object directly */
-    void Draw(Shader shader, glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+    /* Draw each vertex of the mesh (at the LOD that Draw would use) as a point, e.g. for NormalLines, in the given colour */
+    void DrawVertices(Shader shader, glm::mat4 view, glm::mat4 projection, GLfloat colour[3])
+    {
+        glm::mat4 model = GetModelMatrix();
+        SetUp(model, view, projection, colour)->DrawVertices(shader);
+    }
+
+    /* Fill in this draw's ObjectUniforms (in the mesh's own colour unless told otherwise), and pick the level of the mesh to draw */
+    Mesh* SetUp(glm::mat4 model, glm::mat4 view, glm::mat4 projection, const GLfloat* colour = NULL)
     {
+        Mesh* drawMesh = SelectMesh(model, view, projection);
+
+        //Streamed textures get as detailed as the biggest thing drawn with them this frame
+        int streamed = drawMesh->GetStreamedTexture();
+        if(streamed >= 0)
+            textureStreamer.Request(streamed, GetPixelsPerUnit(model, view, projection));
+
         glm::mat4 MVP = projection * view * model;
+        glm::vec4 baseColour = (colour != NULL) ? glm::vec4(colour[0], colour[1], colour[2], 1.0f) : drawMesh->GetColour();
+        uniformBuffers.SetObject(MVP, model, baseColour, drawMesh->GetTextureLayer(), drawMesh->GetTextureHandle());
+        perfStats.AddStateChanges(1);
 
-        GLint mvpLocation = glGetUniformLocation(shader.getShaderProgram(), "MVPmatrix");
-        glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, glm::value_ptr(MVP));
+        return drawMesh;
+    }
 
-        GLint modelLocation = glGetUniformLocation(shader.getShaderProgram(), "modelMatrix");
-        glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(model));
+    /* The level of the mesh Draw would use with these matrices */
+    Mesh* SelectMesh(glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+    {
+        if(lodEnabled && !mesh->lods.empty())
+            return mesh->SelectLOD(GetAllowedError(model, view, projection));
+        return mesh;
+    }
 
-        mesh->Draw(shader);
+    /* How big an error in the mesh, in model units, would cover lodPixelError pixels where the object is */
+    float GetAllowedError(glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+    {
+        return lodPixelError / GetPixelsPerUnit(model, view, projection);
+    }
+
+    /*
+     * How many pixels one unit of the mesh covers on screen where the object is.
+     * One pixel at distance d spans 2d / (projection[1][1] * viewport height) world units, and the
+     * model matrix's scale converts that back into the mesh's own units.
+     */
+    float GetPixelsPerUnit(glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+    {
+        glm::vec4 centre = view * model * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        float distance = glm::length(glm::vec3(centre));
+
+        float modelScale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        float pixelSize = 2.0f * distance / (projection[1][1] * lodViewportHeight);
+
+        return modelScale / pixelSize;
     }
 
     void setPostion(glm::vec3 newPos)
@@ -54,6 +126,11 @@ public:
     {
         rotation = newRot;
     }
+
+    void setScale(float newScale)
+    {
+        scale = newScale;
+    }
 };
 
 #endif // GRAPHICS_OBJECT_H
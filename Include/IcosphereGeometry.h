@@ -0,0 +1,358 @@
+#ifndef ICOSPHERE_H
+#define ICOSPHERE_H
+
+#include <math.h>
+#include <vector>
+
+#include "Introduction.h"
+#include "ConstexprMath.h"
+
+/*
+ * Spheres made by subdividing an icosahedron. Every triangle is close to the same size, so for
+ * a given error they need far fewer triangles than a UV sphere, which bunches them up at the poles.
+ * The vertices are shared through an index buffer.
+ *
+ * UVs are a latitude/longitude mapping. Triangles that cross the u = 0/1 seam get copies of their
+ * vertices with u + 1, and each triangle touching a pole gets its own copy of the pole with u in the
+ * middle of the other two corners, so the texture doesn't smear across the seam or twist at the poles.
+ *
+ * The same generator runs at compile time for small levels (see IcosphereTable) and at runtime for the rest.
+ */
+
+/* Highest subdivision level built into the binary as constexpr data */
+const int ICOSPHERE_CONSTEXPR_MAX_LEVEL = 3;
+
+/* Vertices and triangles before the seam and pole copies */
+constexpr int IcosphereBaseVertices(int level)
+{
+    return 10 * (1 << (2 * level)) + 2;
+}
+
+constexpr int IcosphereTriangles(int level)
+{
+    return 20 * (1 << (2 * level));
+}
+
+/* Room the generator needs: at worst every vertex gets a seam copy, plus ten pole copies */
+constexpr int IcosphereMaxVertices(int level)
+{
+    return 2 * IcosphereBaseVertices(level) + 10;
+}
+
+/* Icosphere vertices have at most six neighbours */
+const int ICOSPHERE_MAX_VALENCE = 6;
+
+constexpr struct Vertex IcosphereVertex(double x, double y, double z)
+{
+    struct Vertex v = {{x, y, z}, {x, y, z}, {0.0f, 0.0f}};
+    return v;
+}
+
+/* Index of the vertex half way along edge a-b, pushed out onto the sphere. Made on first use */
+constexpr int IcosphereMidpoint(int a, int b, struct Vertex* vertices, int& vertexCount, int* edgeOther, int* edgeMiddle)
+{
+    for(int k = 0; k < ICOSPHERE_MAX_VALENCE; k++)
+        if(edgeOther[a * ICOSPHERE_MAX_VALENCE + k] == b)
+            return edgeMiddle[a * ICOSPHERE_MAX_VALENCE + k];
+
+    double x = vertices[a].position[0] + vertices[b].position[0];
+    double y = vertices[a].position[1] + vertices[b].position[1];
+    double z = vertices[a].position[2] + vertices[b].position[2];
+    double length = ConstexprSqrt(x * x + y * y + z * z);
+    int middle = vertexCount++;
+    vertices[middle] = IcosphereVertex(x / length, y / length, z / length);
+
+    //Remember it from both ends
+    int ends[2] = {a, b};
+    int others[2] = {b, a};
+    for(int e = 0; e < 2; e++)
+    {
+        for(int k = 0; k < ICOSPHERE_MAX_VALENCE; k++)
+        {
+            if(edgeOther[ends[e] * ICOSPHERE_MAX_VALENCE + k] < 0)
+            {
+                edgeOther[ends[e] * ICOSPHERE_MAX_VALENCE + k] = others[e];
+                edgeMiddle[ends[e] * ICOSPHERE_MAX_VALENCE + k] = middle;
+                break;
+            }
+        }
+    }
+    return middle;
+}
+
+/*
+ * Build a unit icosphere into the supplied arrays and return the number of vertices used.
+ * vertices needs IcosphereMaxVertices(level) entries, indices 3 * IcosphereTriangles(level),
+ * and edgeOther/edgeMiddle ICOSPHERE_MAX_VALENCE * IcosphereBaseVertices(level) each.
+ */
+constexpr int BuildIcosphere(int level, struct Vertex* vertices, GLuint* indices, int* edgeOther, int* edgeMiddle)
+{
+    //Icosahedron with a vertex at each pole and two rings of five at +-atan(1/2) latitude
+    double ringY = 1.0 / ConstexprSqrt(5.0);
+    double ringRadius = 2.0 / ConstexprSqrt(5.0);
+    int vertexCount = 0;
+    vertices[vertexCount++] = IcosphereVertex(0.0, 1.0, 0.0);
+    for(int i = 0; i < 5; i++)
+    {
+        double phi = i * 2.0 * CONSTEXPR_PI / 5.0;
+        vertices[vertexCount++] = IcosphereVertex(ringRadius * ConstexprCos(phi), ringY, ringRadius * ConstexprSin(phi));
+    }
+    for(int i = 0; i < 5; i++)
+    {
+        double phi = (i + 0.5) * 2.0 * CONSTEXPR_PI / 5.0;
+        vertices[vertexCount++] = IcosphereVertex(ringRadius * ConstexprCos(phi), -ringY, ringRadius * ConstexprSin(phi));
+    }
+    vertices[vertexCount++] = IcosphereVertex(0.0, -1.0, 0.0);
+    const int top = 0;
+    const int bottom = 11;
+
+    int triangleCount = 0;
+    for(int i = 0; i < 5; i++)
+    {
+        int upper = 1 + i, upperNext = 1 + (i + 1) % 5;
+        int lower = 6 + i, lowerNext = 6 + (i + 1) % 5;
+        GLuint faces[4][3] = {{(GLuint)top, (GLuint)upperNext, (GLuint)upper},
+                              {(GLuint)upper, (GLuint)upperNext, (GLuint)lower},
+                              {(GLuint)lower, (GLuint)upperNext, (GLuint)lowerNext},
+                              {(GLuint)bottom, (GLuint)lower, (GLuint)lowerNext}};
+        for(int f = 0; f < 4; f++)
+        {
+            for(int k = 0; k < 3; k++)
+                indices[3 * triangleCount + k] = faces[f][k];
+            triangleCount++;
+        }
+    }
+
+    //Split every triangle into four, working backwards so the children never overwrite a parent still to do
+    for(int l = 0; l < level; l++)
+    {
+        for(int e = 0; e < vertexCount * ICOSPHERE_MAX_VALENCE; e++)
+            edgeOther[e] = -1;
+
+        for(int t = triangleCount - 1; t >= 0; t--)
+        {
+            int a = indices[3 * t], b = indices[3 * t + 1], c = indices[3 * t + 2];
+            int ab = IcosphereMidpoint(a, b, vertices, vertexCount, edgeOther, edgeMiddle);
+            int bc = IcosphereMidpoint(b, c, vertices, vertexCount, edgeOther, edgeMiddle);
+            int ca = IcosphereMidpoint(c, a, vertices, vertexCount, edgeOther, edgeMiddle);
+
+            GLuint children[4][3] = {{(GLuint)a, (GLuint)ab, (GLuint)ca},
+                                     {(GLuint)ab, (GLuint)b, (GLuint)bc},
+                                     {(GLuint)ca, (GLuint)bc, (GLuint)c},
+                                     {(GLuint)ab, (GLuint)bc, (GLuint)ca}};
+            for(int child = 0; child < 4; child++)
+                for(int k = 0; k < 3; k++)
+                    indices[3 * (4 * t + child) + k] = children[child][k];
+        }
+        triangleCount *= 4;
+    }
+
+    //Latitude/longitude UVs, with longitude 0 along +x like GetSpherePhong
+    for(int v = 0; v < vertexCount; v++)
+    {
+        double u = ConstexprAtan2(vertices[v].position[2], vertices[v].position[0]) / (2.0 * CONSTEXPR_PI);
+        vertices[v].textureCoords[0] = (GLfloat)(u < 0.0 ? u + 1.0 : u);
+        vertices[v].textureCoords[1] = (GLfloat)(0.5 + ConstexprAsin(vertices[v].position[1]) / CONSTEXPR_PI);
+    }
+
+    //Seam: a triangle spanning more than half the u range really wraps round, so move its low corners to u + 1
+    int* seamCopy = edgeOther;
+    for(int v = 0; v < vertexCount; v++)
+        seamCopy[v] = -1;
+    for(int t = 0; t < triangleCount; t++)
+    {
+        double lowest = 1.0, highest = 0.0;
+        for(int k = 0; k < 3; k++)
+        {
+            int v = indices[3 * t + k];
+            if(v == top || v == bottom)
+                continue;
+            double u = vertices[v].textureCoords[0];
+            lowest = u < lowest ? u : lowest;
+            highest = u > highest ? u : highest;
+        }
+        if(highest - lowest <= 0.5)
+            continue;
+
+        for(int k = 0; k < 3; k++)
+        {
+            int v = indices[3 * t + k];
+            if(v == top || v == bottom || vertices[v].textureCoords[0] >= 0.5f)
+                continue;
+            if(seamCopy[v] < 0)
+            {
+                seamCopy[v] = vertexCount;
+                vertices[vertexCount] = vertices[v];
+                vertices[vertexCount].textureCoords[0] += 1.0f;
+                vertexCount++;
+            }
+            indices[3 * t + k] = seamCopy[v];
+        }
+    }
+
+    //Poles: one copy per triangle, half way between the other two corners
+    for(int t = 0; t < triangleCount; t++)
+    {
+        for(int k = 0; k < 3; k++)
+        {
+            int v = indices[3 * t + k];
+            if(v != top && v != bottom)
+                continue;
+
+            int other1 = indices[3 * t + (k + 1) % 3];
+            int other2 = indices[3 * t + (k + 2) % 3];
+            vertices[vertexCount] = vertices[v];
+            vertices[vertexCount].textureCoords[0] = 0.5f * (vertices[other1].textureCoords[0] + vertices[other2].textureCoords[0]);
+            indices[3 * t + k] = vertexCount++;
+        }
+    }
+
+    return vertexCount;
+}
+
+/* Scratch space for building a given level at compile time */
+template<int Level>
+struct IcosphereScratch
+{
+    struct Vertex vertices[IcosphereMaxVertices(Level)];
+    GLuint indices[3 * IcosphereTriangles(Level)];
+    int edgeOther[ICOSPHERE_MAX_VALENCE * IcosphereBaseVertices(Level)];
+    int edgeMiddle[ICOSPHERE_MAX_VALENCE * IcosphereBaseVertices(Level)];
+};
+
+template<int Level>
+constexpr int IcosphereVertexCount()
+{
+    IcosphereScratch<Level> scratch = {};
+    return BuildIcosphere(Level, scratch.vertices, scratch.indices, scratch.edgeOther, scratch.edgeMiddle);
+}
+
+/* A unit icosphere worked out by the compiler, sized exactly */
+template<int Level>
+struct IcosphereTable
+{
+    static constexpr int VERTEX_COUNT = IcosphereVertexCount<Level>();
+    static constexpr int INDEX_COUNT = 3 * IcosphereTriangles(Level);
+
+    struct Vertex vertices[VERTEX_COUNT];
+    GLuint indices[INDEX_COUNT];
+};
+
+template<int Level>
+constexpr IcosphereTable<Level> MakeIcosphereTable()
+{
+    IcosphereScratch<Level> scratch = {};
+    BuildIcosphere(Level, scratch.vertices, scratch.indices, scratch.edgeOther, scratch.edgeMiddle);
+
+    IcosphereTable<Level> table = {};
+    for(int v = 0; v < IcosphereTable<Level>::VERTEX_COUNT; v++)
+        table.vertices[v] = scratch.vertices[v];
+    for(int i = 0; i < IcosphereTable<Level>::INDEX_COUNT; i++)
+        table.indices[i] = scratch.indices[i];
+    return table;
+}
+
+constexpr IcosphereTable<0> ICOSPHERE_LEVEL_0 = MakeIcosphereTable<0>();
+constexpr IcosphereTable<1> ICOSPHERE_LEVEL_1 = MakeIcosphereTable<1>();
+constexpr IcosphereTable<2> ICOSPHERE_LEVEL_2 = MakeIcosphereTable<2>();
+constexpr IcosphereTable<3> ICOSPHERE_LEVEL_3 = MakeIcosphereTable<3>();
+
+/* Vertices and triangle indices for a mesh that shares its vertices */
+struct IndexedGeometry
+{
+    std::vector<struct Vertex> vertices;
+    std::vector<GLuint> indices;
+};
+
+/* Copy a compile-time table into an IndexedGeometry */
+template<int Level>
+IndexedGeometry GetIcosphereTable(const IcosphereTable<Level>& table, double radius)
+{
+    IndexedGeometry geometry;
+    geometry.vertices.assign(table.vertices, table.vertices + IcosphereTable<Level>::VERTEX_COUNT);
+    geometry.indices.assign(table.indices, table.indices + IcosphereTable<Level>::INDEX_COUNT);
+    for(size_t v = 0; v < geometry.vertices.size(); v++)
+        for(int k = 0; k < 3; k++)
+            geometry.vertices[v].position[k] *= radius;
+    return geometry;
+}
+
+/* An icosphere at any level. Levels up to ICOSPHERE_CONSTEXPR_MAX_LEVEL come straight from the tables */
+IndexedGeometry GetIcosphere(int subdivisions, double radius)
+{
+    if(subdivisions < 0) subdivisions = 0;
+
+    switch(subdivisions)
+    {
+    case 0: return GetIcosphereTable(ICOSPHERE_LEVEL_0, radius);
+    case 1: return GetIcosphereTable(ICOSPHERE_LEVEL_1, radius);
+    case 2: return GetIcosphereTable(ICOSPHERE_LEVEL_2, radius);
+    case 3: return GetIcosphereTable(ICOSPHERE_LEVEL_3, radius);
+    }
+
+    IndexedGeometry geometry;
+    geometry.vertices.resize(IcosphereMaxVertices(subdivisions));
+    geometry.indices.resize(3 * IcosphereTriangles(subdivisions));
+    std::vector<int> edgeOther(ICOSPHERE_MAX_VALENCE * IcosphereBaseVertices(subdivisions));
+    std::vector<int> edgeMiddle(edgeOther.size());
+
+    int vertexCount = BuildIcosphere(subdivisions, &geometry.vertices[0], &geometry.indices[0], &edgeOther[0], &edgeMiddle[0]);
+    geometry.vertices.resize(vertexCount);
+    for(size_t v = 0; v < geometry.vertices.size(); v++)
+        for(int k = 0; k < 3; k++)
+            geometry.vertices[v].position[k] *= radius;
+    return geometry;
+}
+
+/* Nearest point to the origin on triangle abc (Ericson, Real-Time Collision Detection 5.1.5) */
+glm::dvec3 ClosestPointToOrigin(glm::dvec3 a, glm::dvec3 b, glm::dvec3 c)
+{
+    glm::dvec3 p(0.0);
+    glm::dvec3 ab = b - a, ac = c - a, ap = p - a;
+    double d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if(d1 <= 0.0 && d2 <= 0.0) return a;
+
+    glm::dvec3 bp = p - b;
+    double d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if(d3 >= 0.0 && d4 <= d3) return b;
+
+    double vc = d1 * d4 - d3 * d2;
+    if(vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) return a + ab * (d1 / (d1 - d3));
+
+    glm::dvec3 cp = p - c;
+    double d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if(d6 >= 0.0 && d5 <= d6) return c;
+
+    double vb = d5 * d2 - d1 * d6;
+    if(vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) return a + ac * (d2 / (d2 - d6));
+
+    double va = d3 * d6 - d5 * d4;
+    if(va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    double denominator = 1.0 / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+/*
+ * Furthest any part of a sphere mesh is from the true sphere. The vertices are all on it, so this is
+ * how far inside the flat triangles dip. No indices means a plain triangle list.
+ */
+double MaxSphereError(const std::vector<struct Vertex>& vertices, const std::vector<GLuint>& indices, double radius)
+{
+    size_t cornerCount = indices.empty() ? vertices.size() : indices.size();
+    double largest = 0.0;
+    for(size_t t = 0; t + 2 < cornerCount; t += 3)
+    {
+        glm::dvec3 corners[3];
+        for(int k = 0; k < 3; k++)
+        {
+            const struct Vertex& v = vertices[indices.empty() ? t + k : indices[t + k]];
+            corners[k] = glm::dvec3(v.position[0], v.position[1], v.position[2]);
+        }
+        double error = radius - glm::length(ClosestPointToOrigin(corners[0], corners[1], corners[2]));
+        largest = error > largest ? error : largest;
+    }
+    return largest;
+}
+
+#endif // ICOSPHERE_H
@@ -0,0 +1,142 @@
+#ifndef INSTANCED_MESH_H
+#define INSTANCED_MESH_H
+
+#include <vector>
+
+#include "Mesh.h"
+#include "TextureArrays.h"
+#include "GPUResources.h"
+
+/*
+ * One set of vertices drawn many times in a single instanced draw (with SHADER_INSTANCED), each instance with
+ * its own model matrix and its own layer of a texture array. The object drawing it still supplies a model
+ * matrix of its own, which applies on top of every instance's.
+ * All of the instances have to share the one array, so their textures need to be the same size and format.
+ */
+
+/* Where an instance goes, inside the object, and which layer of the mesh's texture array it's textured with */
+struct MeshInstance
+{
+    glm::mat4 model;
+    GLint textureLayer;
+};
+
+class InstancedMesh: public Mesh
+{
+public:
+    /* Constructor. textureArray can be 0 for untextured instances */
+    InstancedMesh(const struct Vertex* vertices, int count, GLuint textureArray, const std::vector<MeshInstance>& instances, GLfloat colour[3])
+    {
+        r = colour[0];
+        g = colour[1];
+        b = colour[2];
+        vertexCount = count;
+        instanceCount = 0;
+        this->textureArray = textureArray;
+
+        this->vertexArray = gpuResources.Create(GPU_VERTEX_ARRAY);
+        this->vertexBuffer = gpuResources.Create(GPU_BUFFER);
+        this->instanceBuffer = gpuResources.Create(GPU_BUFFER);
+
+        glBindVertexArray(gpuResources.Get(this->vertexArray));
+        glBindBuffer(GL_ARRAY_BUFFER, gpuResources.Get(this->vertexBuffer));
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(struct Vertex), vertices, GL_STATIC_DRAW);
+        gpuResources.SetBytes(this->vertexBuffer, vertexCount * sizeof(struct Vertex));
+        perfStats.AddBufferUpload(vertexCount * sizeof(struct Vertex), true);
+
+        //Same attributes as a TriangleMesh
+        glVertexAttribPointer(0, 3, GL_DOUBLE, GL_FALSE, sizeof(struct Vertex), (const GLvoid*) offsetof (struct Vertex, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(struct Vertex), (const GLvoid*) offsetof (struct Vertex, textureCoords));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 3, GL_DOUBLE, GL_FALSE, sizeof(struct Vertex), (const GLvoid*) offsetof (struct Vertex, normal));
+        glEnableVertexAttribArray(2);
+
+        //Then the instance's matrix, a column per attribute, and its layer
+        glBindBuffer(GL_ARRAY_BUFFER, gpuResources.Get(this->instanceBuffer));
+        for(int column = 0; column < 4; column++)
+        {
+            glVertexAttribPointer(5 + column, 4, GL_FLOAT, GL_FALSE, sizeof(MeshInstance), (const GLvoid*)(offsetof(MeshInstance, model) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(5 + column, 1);
+            glEnableVertexAttribArray(5 + column);
+        }
+        glVertexAttribIPointer(9, 1, GL_INT, sizeof(MeshInstance), (const GLvoid*) offsetof (MeshInstance, textureLayer));
+        glVertexAttribDivisor(9, 1);
+        glEnableVertexAttribArray(9);
+
+        glBindVertexArray(0);
+
+        SetInstances(instances);
+    }
+
+    /* Replace every instance */
+    void SetInstances(const std::vector<MeshInstance>& instances)
+    {
+        perfStats.ReleaseBuffer(instanceCount * sizeof(MeshInstance));
+        instanceCount = (int)instances.size();
+
+        glBindBuffer(GL_ARRAY_BUFFER, gpuResources.Get(this->instanceBuffer));
+        glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(MeshInstance), instances.empty() ? NULL : &instances[0], GL_STATIC_DRAW);
+        gpuResources.SetBytes(this->instanceBuffer, instanceCount * sizeof(MeshInstance));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        perfStats.AddBufferUpload(instanceCount * sizeof(MeshInstance), true);
+    }
+
+    void Draw(Shader shader)
+    {
+        if(textureArray != 0)
+            textureArrays.Bind(textureArray);
+
+        glBindVertexArray(gpuResources.Get(this->vertexArray));
+        glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, instanceCount);
+        glBindVertexArray(0);
+
+        perfStats.AddStateChanges(1);
+        perfStats.AddDraw(GL_TRIANGLES, vertexCount * instanceCount);
+    }
+
+    glm::vec4 GetColour() const
+    {
+        return glm::vec4(r, g, b, 1.0f);
+    }
+
+    unsigned GetShaderFeatures(unsigned wanted) const
+    {
+        unsigned features = (wanted & ~SHADER_MESH_FEATURES) | SHADER_INSTANCED;
+        if(textureArray == 0)
+            return features & ~SHADER_TEXTURED;
+        return features | ((features & SHADER_TEXTURED) ? SHADER_TEXTURE_ARRAY : 0);
+    }
+
+    void Release()
+    {
+        if(vertexArray.IsNull())
+            return;
+
+        gpuResources.Destroy(this->vertexArray);
+        gpuResources.Destroy(this->vertexBuffer);
+        gpuResources.Destroy(this->instanceBuffer);
+        perfStats.ReleaseBuffer(GetBufferBytes());
+        instanceCount = 0;
+    }
+
+    /* Bytes of vertex and instance data */
+    long GetBufferBytes() const
+    {
+        return vertexCount * sizeof(struct Vertex) + instanceCount * sizeof(MeshInstance);
+    }
+
+    int GetInstanceCount() const
+    {
+        return instanceCount;
+    }
+
+private:
+    GPUHandle vertexArray, vertexBuffer, instanceBuffer;
+    GLuint textureArray;
+    int vertexCount;
+    int instanceCount;
+    GLfloat r,g,b;
+};
+
+#endif // INSTANCED_MESH_H
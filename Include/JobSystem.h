@@ -0,0 +1,476 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <iostream>
+#include <stdlib.h>
+
+/* Work for one job: process items [begin, end) of whatever data points to */
+typedef void (*JobFunction)(void* data, int begin, int end);
+
+/*
+ * Counts unfinished jobs. Jobs added with a counter increment it and decrement it when done,
+ * so waiting on the counter waits for the whole batch. Jobs can also be made to depend on a
+ * counter, in which case they aren't started until it reaches zero.
+ */
+class JobCounter
+{
+public:
+    std::atomic<int> pending;
+
+    JobCounter() : pending(0), finishing(0) {}
+
+    /* Once this is true the counter is no longer touched by any job, and can be destroyed */
+    bool IsDone() const
+    {
+        return pending.load() == 0 && finishing.load() == 0;
+    }
+
+private:
+    friend class JobSystem;
+
+    /* Threads still inside Finish() for this counter */
+    std::atomic<int> finishing;
+
+    /* Jobs waiting for this counter to hit zero */
+    struct Continuation
+    {
+        JobFunction function;
+        void* data;
+        int begin, end;
+        JobCounter* counter;
+    };
+    std::mutex continuationMutex;
+    std::vector<Continuation> continuations;
+};
+
+struct Job
+{
+    JobFunction function;
+    void* data;
+    int begin, end;
+    JobCounter* counter;
+    std::atomic<int> inUse; //Pool slot is taken until the job has been picked up to run
+};
+
+/*
+ * Chase-Lev work-stealing deque of jobs (as in Le et al., "Correct and Efficient
+ * Work-Stealing for Weak Memory Models"). The owning thread pushes and pops at the bottom,
+ * any other thread steals from the top. Fixed capacity; Push fails when full.
+ */
+class JobDeque
+{
+public:
+    static const long CAPACITY = 4096;
+
+    JobDeque() : top(0), bottom(0)
+    {
+        for(long i = 0; i < CAPACITY; i++)
+            buffer[i].store(NULL, std::memory_order_relaxed);
+    }
+
+    /* Owner only */
+    bool Push(Job* job)
+    {
+        long b = bottom.load(std::memory_order_relaxed);
+        long t = top.load(std::memory_order_acquire);
+        if(b - t >= CAPACITY)
+            return false;
+
+        buffer[b & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /* Owner only. Takes the most recently pushed job */
+    Job* Pop()
+    {
+        long b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long t = top.load(std::memory_order_relaxed);
+
+        if(t > b)
+        {
+            //Empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return NULL;
+        }
+
+        Job* job = buffer[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if(t == b)
+        {
+            //Last job, so race any thieves for it
+            if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                job = NULL;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    /* Any thread. Takes the oldest job */
+    Job* Steal()
+    {
+        long t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long b = bottom.load(std::memory_order_acquire);
+        if(t >= b)
+            return NULL;
+
+        Job* job = buffer[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return NULL; //Lost the race to another thief or the owner
+        return job;
+    }
+
+private:
+    std::atomic<long> top;
+    std::atomic<long> bottom;
+    std::atomic<Job*> buffer[CAPACITY];
+};
+
+/*
+ * Work-stealing job scheduler shared by everything that wants to go wide.
+ * Every thread that uses it (the workers, the thread that created it and up to
+ * MAX_EXTERNAL_THREADS others) gets its own deque and job pool. Idle workers steal
+ * from everyone else, and threads waiting on a counter run jobs rather than block.
+ */
+class JobSystem
+{
+public:
+    static const int MAX_EXTERNAL_THREADS = 4;
+
+    /* workerCount < 0 means one worker per hardware thread, not counting the caller */
+    JobSystem(int workerCount = -1) : running(true), registeredThreads(0), pendingJobs(0), sleepingWorkers(0)
+    {
+        static std::atomic<int> nextId(1);
+        id = nextId++;
+
+        if(workerCount < 0)
+        {
+            workerCount = (int)std::thread::hardware_concurrency() - 1;
+            if(workerCount < 0)
+                workerCount = 0;
+        }
+
+        queueCount = workerCount + 1 + MAX_EXTERNAL_THREADS;
+        queues = new ThreadQueue[queueCount];
+
+        //The creating thread is always slot 0
+        ThreadSlot();
+
+        for(int i = 0; i < workerCount; i++)
+            workers.push_back(std::thread(&JobSystem::WorkerLoop, this));
+    }
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            running = false;
+        }
+        wake.notify_all();
+        for(size_t i = 0; i < workers.size(); i++)
+            workers[i].join();
+        delete[] queues;
+    }
+
+    /* Number of threads that can run jobs at once, including the caller */
+    int ThreadCount() const
+    {
+        return (int)workers.size() + 1;
+    }
+
+    /* Queue function(data, begin, end). Increments counter now and decrements it once the job has run */
+    void Run(JobFunction function, void* data, int begin, int end, JobCounter* counter)
+    {
+        if(counter != NULL)
+            counter->pending++;
+        Submit(function, data, begin, end, counter);
+    }
+
+    /* As Run, but the job won't start until dependency has reached zero */
+    void RunAfter(JobCounter* dependency, JobFunction function, void* data, int begin, int end, JobCounter* counter)
+    {
+        if(counter != NULL)
+            counter->pending++;
+
+        {
+            std::lock_guard<std::mutex> lock(dependency->continuationMutex);
+            if(dependency->pending.load() > 0)
+            {
+                JobCounter::Continuation continuation = {function, data, begin, end, counter};
+                dependency->continuations.push_back(continuation);
+                return;
+            }
+        }
+        Submit(function, data, begin, end, counter);
+    }
+
+    /* Run jobs on this thread until the counter reaches zero */
+    void Wait(JobCounter* counter)
+    {
+        int slot = ThreadSlot();
+        while(!counter->IsDone())
+        {
+            Job* job = FindJob(slot);
+            if(job != NULL)
+                Execute(job);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    /*
+     * Split [0, count) into chunks of grainSize items (0 picks one for you), run them across
+     * all threads and return once every chunk is done.
+     */
+    void ParallelFor(int count, int grainSize, JobFunction function, void* data)
+    {
+        if(count <= 0)
+            return;
+        if(grainSize <= 0)
+        {
+            //A few chunks per thread, so that stealing can even out uneven work
+            grainSize = count / (ThreadCount() * 4);
+            if(grainSize < 1)
+                grainSize = 1;
+        }
+
+        if(count <= grainSize)
+        {
+            function(data, 0, count);
+            return;
+        }
+
+        JobCounter counter;
+        for(int begin = 0; begin < count; begin += grainSize)
+        {
+            int end = begin + grainSize < count ? begin + grainSize : count;
+            Run(function, data, begin, end, &counter);
+        }
+        Wait(&counter);
+    }
+
+    /* ParallelFor taking anything callable as f(begin, end), such as a lambda */
+    template<typename Function>
+    void ParallelFor(int count, int grainSize, const Function& function)
+    {
+        ParallelFor(count, grainSize, &CallRange<Function>, (void*)&function);
+    }
+
+private:
+    struct ThreadQueue
+    {
+        JobDeque deque;
+        Job pool[JobDeque::CAPACITY];
+        long nextPoolSlot;
+
+        ThreadQueue() : nextPoolSlot(0)
+        {
+            for(long i = 0; i < JobDeque::CAPACITY; i++)
+                pool[i].inUse.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    int id;
+    std::atomic<bool> running;
+    std::vector<std::thread> workers;
+    ThreadQueue* queues;
+    int queueCount;
+    std::atomic<int> registeredThreads;
+    std::mutex slotMutex;
+    std::vector<std::thread::id> slotThreads;   //Which thread has each registered slot
+
+    //Sleeping when there's nothing to do
+    std::atomic<int> pendingJobs;
+    std::atomic<int> sleepingWorkers;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+
+    template<typename Function>
+    static void CallRange(void* data, int begin, int end)
+    {
+        (*(const Function*)data)(begin, end);
+    }
+
+    /* Which deque belongs to the calling thread, registering it on first use */
+    int ThreadSlot()
+    {
+        //A few job systems may be alive at once (the benchmarks make their own), so remember one slot for each
+        static thread_local int cachedIds[8] = {0};
+        static thread_local int cachedSlots[8];
+
+        for(int i = 0; i < 8; i++)
+            if(cachedIds[i] == id)
+                return cachedSlots[i];
+
+        //Not cached, which could just be because more than 8 systems have been used since. The system itself
+        //knows which threads it has given slots to, so a thread only ever takes one
+        int slot = -1;
+        {
+            std::lock_guard<std::mutex> lock(slotMutex);
+            std::thread::id self = std::this_thread::get_id();
+            for(size_t i = 0; i < slotThreads.size() && slot < 0; i++)
+                if(slotThreads[i] == self)
+                    slot = (int)i;
+
+            if(slot < 0)
+            {
+                slot = (int)slotThreads.size();
+                if(slot >= queueCount)
+                {
+                    std::cout << "Too many threads using the job system" << std::endl;
+                    abort();
+                }
+                slotThreads.push_back(self);
+                registeredThreads++;
+            }
+        }
+
+        //Replace the oldest entry, round robin
+        static thread_local int nextCacheEntry = 0;
+        cachedIds[nextCacheEntry] = id;
+        cachedSlots[nextCacheEntry] = slot;
+        nextCacheEntry = (nextCacheEntry + 1) % 8;
+        return slot;
+    }
+
+    void Submit(JobFunction function, void* data, int begin, int end, JobCounter* counter)
+    {
+        ThreadQueue& queue = queues[ThreadSlot()];
+
+        //Find a free pool slot. Slots are freed when their job starts, so normally the next one is free
+        Job* job = NULL;
+        for(long tries = 0; tries < JobDeque::CAPACITY && job == NULL; tries++)
+        {
+            Job* candidate = &queue.pool[queue.nextPoolSlot];
+            queue.nextPoolSlot = (queue.nextPoolSlot + 1) & (JobDeque::CAPACITY - 1);
+            if(candidate->inUse.load(std::memory_order_acquire) == 0)
+                job = candidate;
+        }
+
+        if(job == NULL)
+        {
+            //Everything is still queued up, so just do this one now
+            function(data, begin, end);
+            Finish(counter);
+            return;
+        }
+
+        job->function = function;
+        job->data = data;
+        job->begin = begin;
+        job->end = end;
+        job->counter = counter;
+        job->inUse.store(1, std::memory_order_relaxed);
+
+        if(!queue.deque.Push(job))
+        {
+            job->inUse.store(0, std::memory_order_relaxed);
+            function(data, begin, end);
+            Finish(counter);
+            return;
+        }
+
+        pendingJobs++;
+        if(sleepingWorkers.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            wake.notify_one();
+        }
+    }
+
+    /* Own deque first, then try to steal from everyone else */
+    Job* FindJob(int slot)
+    {
+        Job* job = queues[slot].deque.Pop();
+        if(job == NULL)
+        {
+            int registered = registeredThreads.load();
+            if(registered > queueCount)
+                registered = queueCount;
+            for(int i = 1; i < registered && job == NULL; i++)
+                job = queues[(slot + i) % registered].deque.Steal();
+        }
+
+        if(job != NULL)
+            pendingJobs--;
+        return job;
+    }
+
+    void Execute(Job* job)
+    {
+        //Copy the job out so its pool slot can be reused straight away
+        JobFunction function = job->function;
+        void* data = job->data;
+        int begin = job->begin;
+        int end = job->end;
+        JobCounter* counter = job->counter;
+        job->inUse.store(0, std::memory_order_release);
+
+        function(data, begin, end);
+        Finish(counter);
+    }
+
+    /* Mark a job done, starting anything that was waiting for its counter */
+    void Finish(JobCounter* counter)
+    {
+        if(counter == NULL)
+            return;
+
+        //Whoever waits on the counter may free it as soon as pending hits zero, unless we say we're still here
+        counter->finishing++;
+        if(counter->pending.fetch_sub(1) == 1)
+        {
+            std::vector<JobCounter::Continuation> ready;
+            {
+                std::lock_guard<std::mutex> lock(counter->continuationMutex);
+                ready.swap(counter->continuations);
+            }
+            for(size_t i = 0; i < ready.size(); i++)
+                Submit(ready[i].function, ready[i].data, ready[i].begin, ready[i].end, ready[i].counter);
+        }
+        counter->finishing--;
+    }
+
+    void WorkerLoop()
+    {
+        int slot = ThreadSlot();
+        int idleSpins = 0;
+
+        while(running.load())
+        {
+            Job* job = FindJob(slot);
+            if(job != NULL)
+            {
+                Execute(job);
+                idleSpins = 0;
+                continue;
+            }
+
+            //Spin briefly before sleeping, since more work usually turns up soon
+            if(++idleSpins < 64)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepingWorkers++;
+            wake.wait(lock, [this]{ return pendingJobs.load() > 0 || !running.load(); });
+            sleepingWorkers--;
+            idleSpins = 0;
+        }
+    }
+};
+
+/* The job system everything shares */
+JobSystem jobSystem;
+
+#endif // JOB_SYSTEM_H
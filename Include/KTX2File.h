@@ -0,0 +1,216 @@
+#ifndef KTX2_FILE_H
+#define KTX2_FILE_H
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "BlockCompression.h"
+#include "AssetPack.h"
+
+/*
+ * Just enough of KTX2 (the Khronos texture container) for baked textures: one 2D image, a full mip chain,
+ * a BC1, BC3 or BC7 format and no supercompression. Anything else is turned away by ReadKTX2, and the
+ * texture loader falls back to the PNG.
+ * Level data is stored smallest first, as the format asks, and the data format descriptor is the basic one
+ * other tools (toktx, ktxinfo) expect for these formats.
+ */
+
+const unsigned char KTX2_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+/* VkFormat values for the formats BlockFormat has, in the same order */
+const unsigned int KTX2_VK_FORMATS[] = {131 /* BC1_RGB_UNORM */, 137 /* BC3_UNORM */, 145 /* BC7_UNORM */};
+
+struct KTX2Texture
+{
+    BlockFormat format;
+    int width;
+    int height;
+    std::vector<std::vector<unsigned char> > levels;   //Level 0 (full size) first
+
+    long GetBytes() const
+    {
+        long bytes = 0;
+        for(size_t l = 0; l < levels.size(); l++)
+            bytes += (long)levels[l].size();
+        return bytes;
+    }
+};
+
+/* Where the baker puts the baked version of an image: the same path with a .ktx2 extension */
+std::string BakedTexturePath(const std::string& imagePath)
+{
+    size_t dot = imagePath.find_last_of('.');
+    size_t slash = imagePath.find_last_of("/\\");
+    if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return imagePath + ".ktx2";
+    return imagePath.substr(0, dot) + ".ktx2";
+}
+
+namespace KTX2
+{
+    inline void Put32(std::vector<unsigned char>& out, unsigned int value)
+    {
+        for(int b = 0; b < 4; b++)
+            out.push_back((value >> (8 * b)) & 255);
+    }
+
+    inline void Put64(std::vector<unsigned char>& out, unsigned long long value)
+    {
+        for(int b = 0; b < 8; b++)
+            out.push_back((value >> (8 * b)) & 255);
+    }
+
+    inline unsigned int Get32(const unsigned char* data)
+    {
+        return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int)data[3] << 24);
+    }
+
+    inline unsigned long long Get64(const unsigned char* data)
+    {
+        return Get32(data) | ((unsigned long long)Get32(data + 4) << 32);
+    }
+
+    /* Basic data format descriptor, with its total size in front */
+    inline std::vector<unsigned char> Descriptor(BlockFormat format)
+    {
+        //Colour model, then a (channel id, bit offset) for each sample. Every sample is 64 bits except BC7's
+        const unsigned int BC1A = 128, BC3 = 130, BC7 = 135;
+        const unsigned int COLOUR = 0, ALPHA = 15;
+        unsigned int model = format == BLOCK_BC1 ? BC1A : (format == BLOCK_BC3 ? BC3 : BC7);
+        int samples = format == BLOCK_BC3 ? 2 : 1;
+
+        std::vector<unsigned char> out;
+        unsigned int blockSize = 24 + 16 * samples;
+        Put32(out, 4 + blockSize);
+        Put32(out, 0);                                  //Khronos vendor, basic descriptor type
+        Put32(out, 2 | (blockSize << 16));              //Version 2
+        Put32(out, model | (1 << 8) | (1 << 16));       //BT.709 primaries, linear transfer, no flags
+        Put32(out, 3 | (3 << 8));                       //4x4x1x1 texel blocks, stored less one
+        Put32(out, BlockBytes(format));                 //Bytes in plane 0
+        Put32(out, 0);
+        for(int s = 0; s < samples; s++)
+        {
+            unsigned int channel = (format == BLOCK_BC3 && s == 0) ? ALPHA : COLOUR;
+            unsigned int bits = format == BLOCK_BC7 ? 128 : 64;
+            Put32(out, (s * 64) | ((bits - 1) << 16) | (channel << 24));
+            Put32(out, 0);                              //Sample position
+            Put32(out, 0);                              //Lower
+            Put32(out, 0xFFFFFFFF);                     //Upper
+        }
+        return out;
+    }
+}
+
+/* Write a texture out. False (with a message) if the file couldn't be written */
+bool WriteKTX2(const std::string& path, const KTX2Texture& texture)
+{
+    using namespace KTX2;
+    unsigned int levelCount = (unsigned int)texture.levels.size();
+    std::vector<unsigned char> descriptor = Descriptor(texture.format);
+
+    std::vector<unsigned char> out(KTX2_IDENTIFIER, KTX2_IDENTIFIER + 12);
+    Put32(out, KTX2_VK_FORMATS[texture.format]);
+    Put32(out, 1);                  //typeSize, which is 1 for block compressed formats
+    Put32(out, texture.width);
+    Put32(out, texture.height);
+    Put32(out, 0);                  //pixelDepth, 0 for a 2D texture
+    Put32(out, 0);                  //layerCount, 0 for not an array
+    Put32(out, 1);                  //faceCount
+    Put32(out, levelCount);
+    Put32(out, 0);                  //No supercompression
+
+    //Index: descriptor straight after the level index, no key/value data, no supercompression data
+    unsigned int descriptorOffset = 80 + 24 * levelCount;
+    Put32(out, descriptorOffset);
+    Put32(out, (unsigned int)descriptor.size());
+    Put32(out, 0);
+    Put32(out, 0);
+    Put64(out, 0);
+    Put64(out, 0);
+
+    //Level data goes smallest first, each starting on a whole block
+    std::vector<unsigned long long> offsets(levelCount);
+    unsigned long long position = descriptorOffset + descriptor.size();
+    unsigned int alignment = BlockBytes(texture.format);
+    for(int l = (int)levelCount - 1; l >= 0; l--)
+    {
+        position = (position + alignment - 1) / alignment * alignment;
+        offsets[l] = position;
+        position += texture.levels[l].size();
+    }
+    for(unsigned int l = 0; l < levelCount; l++)
+    {
+        Put64(out, offsets[l]);
+        Put64(out, texture.levels[l].size());
+        Put64(out, texture.levels[l].size());   //Same again, as nothing is supercompressed
+    }
+    out.insert(out.end(), descriptor.begin(), descriptor.end());
+    for(int l = (int)levelCount - 1; l >= 0; l--)
+    {
+        out.resize(offsets[l], 0);
+        out.insert(out.end(), texture.levels[l].begin(), texture.levels[l].end());
+    }
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if(file == NULL)
+    {
+        std::cout << "Couldn't write " << path << std::endl;
+        return false;
+    }
+    bool written = fwrite(out.data(), 1, out.size(), file) == out.size();
+    fclose(file);
+    return written;
+}
+
+/* Read a texture written by WriteKTX2 (or anything else in the same formats), from the asset pack or the loose file.
+   False if there isn't one */
+bool ReadKTX2(const std::string& path, KTX2Texture& texture)
+{
+    using namespace KTX2;
+    Asset asset;
+    if(!LoadAsset(path, asset))
+        return false;
+    const unsigned char* data = asset.data;
+    unsigned long long size = asset.size;
+    if(size < 80 || memcmp(data, KTX2_IDENTIFIER, 12) != 0)
+    {
+        std::cout << path << " isn't a KTX2 file" << std::endl;
+        return false;
+    }
+
+    unsigned int vkFormat = Get32(&data[12]);
+    int format = -1;
+    for(int f = 0; f < 3; f++)
+        if(KTX2_VK_FORMATS[f] == vkFormat)
+            format = f;
+    unsigned int levelCount = std::max(Get32(&data[40]), 1u);
+    if(format < 0 || Get32(&data[28]) != 0 || Get32(&data[32]) != 0 || Get32(&data[36]) != 1 || Get32(&data[44]) != 0 ||
+       80 + 24 * (unsigned long long)levelCount > size)
+    {
+        std::cout << path << " isn't a plain 2D BC1, BC3 or BC7 texture" << std::endl;
+        return false;
+    }
+
+    texture.format = (BlockFormat)format;
+    texture.width = Get32(&data[20]);
+    texture.height = Get32(&data[24]);
+    texture.levels.assign(levelCount, std::vector<unsigned char>());
+    for(unsigned int l = 0; l < levelCount; l++)
+    {
+        unsigned long long offset = Get64(&data[80 + 24 * l]);
+        unsigned long long length = Get64(&data[80 + 24 * l + 8]);
+        int width = std::max(texture.width >> l, 1), height = std::max(texture.height >> l, 1);
+        if(offset + length > size || length != (unsigned long long)CompressedSize(texture.format, width, height))
+        {
+            std::cout << path << " has a bad level " << l << std::endl;
+            return false;
+        }
+        texture.levels[l].assign(data + offset, data + offset + length);
+    }
+    return true;
+}
+
+#endif // KTX2_FILE_H
@@ -0,0 +1,165 @@
+#ifndef LZ4_BLOCK_H
+#define LZ4_BLOCK_H
+
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+/*
+ * Compression in the LZ4 block format, for entries in an asset pack (see AssetPack.h).
+ * Each sequence is a token (4 bits of literal length, 4 bits of match length - 4), any length bytes that didn't fit,
+ * the literals, then a 2 byte offset back to the match and its length bytes. The last sequence is only literals.
+ * Anything that reads LZ4 blocks can read these, but this compressor is just a greedy one with a single hash table:
+ * nowhere near as clever as the real thing, which is fine for packing a few files offline.
+ */
+
+const int LZ4_MIN_MATCH = 4;
+const int LZ4_LAST_LITERALS = 5;    //The format wants the last 5 bytes as literals...
+const int LZ4_MATCH_LIMIT = 12;     //...and no match starting in the last 12
+const int LZ4_MAX_OFFSET = 65535;
+const int LZ4_HASH_BITS = 12;
+
+/* Most bytes compressing size bytes can take, when none of it compresses */
+inline int LZ4CompressBound(int size)
+{
+    return size + size / 255 + 16;
+}
+
+inline unsigned LZ4Read32(const unsigned char* p)
+{
+    unsigned value;
+    memcpy(&value, p, 4);
+    return value;
+}
+
+inline unsigned LZ4Hash(unsigned sequence)
+{
+    return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+/* The rest of a length that didn't fit in its 4 bits: 255s, then whatever's left */
+inline unsigned char* LZ4WriteLength(unsigned char* out, int length)
+{
+    for(; length >= 255; length -= 255)
+        *out++ = 255;
+    *out++ = (unsigned char)length;
+    return out;
+}
+
+/* Compress size bytes. dst needs room for LZ4CompressBound(size). Returns the compressed size */
+int LZ4Compress(const unsigned char* src, int size, unsigned char* dst)
+{
+    unsigned char* out = dst;
+    int anchor = 0;     //Start of the literals not written yet
+
+    if(size > LZ4_MATCH_LIMIT)
+    {
+        std::vector<int> table(1 << LZ4_HASH_BITS, -1);
+        int pos = 0;
+        while(pos <= size - LZ4_MATCH_LIMIT)
+        {
+            unsigned sequence = LZ4Read32(src + pos);
+            unsigned hash = LZ4Hash(sequence);
+            int candidate = table[hash];
+            table[hash] = pos;
+            if(candidate < 0 || pos - candidate > LZ4_MAX_OFFSET || LZ4Read32(src + candidate) != sequence)
+            {
+                //Step further the longer it's been since a match, so incompressible data goes by quickly
+                pos += 1 + ((pos - anchor) >> 6);
+                continue;
+            }
+
+            int length = LZ4_MIN_MATCH;
+            while(pos + length < size - LZ4_LAST_LITERALS && src[candidate + length] == src[pos + length])
+                length++;
+
+            int literals = pos - anchor;
+            int matchLength = length - LZ4_MIN_MATCH;
+            unsigned char* token = out++;
+            *token = (unsigned char)((std::min(literals, 15) << 4) | std::min(matchLength, 15));
+            if(literals >= 15)
+                out = LZ4WriteLength(out, literals - 15);
+            memcpy(out, src + anchor, literals);
+            out += literals;
+
+            int offset = pos - candidate;
+            *out++ = (unsigned char)(offset & 0xFF);
+            *out++ = (unsigned char)(offset >> 8);
+            if(matchLength >= 15)
+                out = LZ4WriteLength(out, matchLength - 15);
+
+            pos += length;
+            anchor = pos;
+        }
+    }
+
+    //Whatever's left goes in a last sequence of only literals
+    int literals = size - anchor;
+    *out++ = (unsigned char)(std::min(literals, 15) << 4);
+    if(literals >= 15)
+        out = LZ4WriteLength(out, literals - 15);
+    memcpy(out, src + anchor, literals);
+    out += literals;
+    return (int)(out - dst);
+}
+
+/* Read a length's extra bytes into length. False if they run off the end */
+inline bool LZ4ReadLength(const unsigned char*& in, const unsigned char* end, int& length)
+{
+    unsigned char byte;
+    do
+    {
+        if(in >= end || length > (1 << 30))
+            return false;
+        byte = *in++;
+        length += byte;
+    } while(byte == 255);
+    return true;
+}
+
+/* Decompress a block into exactly dstSize bytes. False if it's corrupt or doesn't come out that size */
+bool LZ4Decompress(const unsigned char* src, int srcSize, unsigned char* dst, int dstSize)
+{
+    const unsigned char* in = src;
+    const unsigned char* inEnd = src + srcSize;
+    unsigned char* out = dst;
+    unsigned char* outEnd = dst + dstSize;
+
+    while(in < inEnd)
+    {
+        int token = *in++;
+        int literals = token >> 4;
+        if(literals == 15 && !LZ4ReadLength(in, inEnd, literals))
+            return false;
+        if(literals > inEnd - in || literals > outEnd - out)
+            return false;
+        memcpy(out, in, literals);
+        in += literals;
+        out += literals;
+        if(in == inEnd)
+            break;
+
+        if(inEnd - in < 2)
+            return false;
+        int offset = in[0] | (in[1] << 8);
+        in += 2;
+        int length = token & 15;
+        if(length == 15 && !LZ4ReadLength(in, inEnd, length))
+            return false;
+        length += LZ4_MIN_MATCH;
+        if(offset == 0 || offset > out - dst || length > outEnd - out)
+            return false;
+
+        //A match can overlap what it's making (e.g. offset 1 repeats a byte), and then it has to go a byte at a time
+        const unsigned char* match = out - offset;
+        if(offset >= length)
+            memcpy(out, match, length);
+        else
+            for(int i = 0; i < length; i++)
+                out[i] = match[i];
+        out += length;
+    }
+    return out == outEnd;
+}
+
+#endif // LZ4_BLOCK_H
@@ -0,0 +1,301 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+
+#include "Introduction.h"
+#include "PerformanceStats.h"
+#include "GPUResources.h"
+#include "JobSystem.h"
+#include "PointLights.h"
+
+/*
+ * Clustered forward lighting: the view volume is cut into froxels, CLUSTER_TILES_X by CLUSTER_TILES_Y tiles across
+ * the screen and CLUSTER_SLICES slices deep, and each cluster gets a list of the point lights that reach into it.
+ * A SHADER_CLUSTERED fragment works out which cluster it's in and only adds up those lights, so thousands of small
+ * lights cost about what the few near each fragment do, rather than every light for every fragment.
+ *
+ * The slices get deeper the further away they are (evenly spaced in log(depth)), so the clusters stay about as deep
+ * as they are wide instead of the near ones being long thin slivers.
+ *
+ * The lists are built on the CPU every frame, in two passes on the job system:
+ *  - for each light, the range of slices and tiles its bounding sphere covers
+ *  - for each slice, every light that covers it added to each of its clusters the light covers
+ * Then they're joined up into one array of light indices, with an offset and count for each cluster. That goes in
+ * two shader storage buffers, ClusterGrid and ClusterLightIndices, next to LightStorage from PointLights.h.
+ */
+
+const int CLUSTER_TILES_X = 16;
+const int CLUSTER_TILES_Y = 16;
+const int CLUSTER_SLICES = 24;
+const int CLUSTER_COUNT = CLUSTER_TILES_X * CLUSTER_TILES_Y * CLUSTER_SLICES;
+
+/* std430 layout of the start of ClusterGrid, before the offset and count for each cluster */
+struct ClusterGridHeader
+{
+    glm::vec4 depthPlane;   //Dot with a world position (w = 1) for its depth in front of the camera
+    glm::vec4 tileDepth;    //Tile width and height in pixels, then the scale and bias from log(depth) to a slice
+    GLint dims[4];          //Tiles across, tiles up, slices
+};
+
+class LightClusters
+{
+public:
+    /* From the last Build */
+    double buildSeconds;    //Assigning lights to clusters
+    double uploadSeconds;   //Copying the lists to the GPU
+    int indexCount;         //Light indices over all the clusters
+    int maxPerCluster;
+
+    LightClusters() : buildSeconds(0.0), uploadSeconds(0.0), indexCount(0), maxPerCluster(0), indexCapacity(0)
+    {
+        clusters.resize(CLUSTER_COUNT * 2);
+        sliceIndices.resize(CLUSTER_SLICES);
+        sliceCounts.resize(CLUSTER_SLICES);
+    }
+
+    /* Assign the lights to clusters for a camera, upload the lists and bind them to CLUSTER_STORAGE_BINDING and
+       CLUSTER_INDEX_STORAGE_BINDING. Runs on jobs, or all on this thread if jobs is NULL */
+    void Build(const PointLights& lights, glm::mat4 view, glm::mat4 projection, float nearPlane, float farPlane,
+               int viewportWidth, int viewportHeight, JobSystem* jobs = &jobSystem)
+    {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+        float logDepthRange = logf(farPlane / nearPlane);
+        float sliceScale = CLUSTER_SLICES / logDepthRange;
+        float sliceBias = -CLUSTER_SLICES * logf(nearPlane) / logDepthRange;
+        int lightCount = lights.Count();
+        bounds.resize(lightCount);
+
+        //Pass 1: which slices and tiles each light covers
+        auto boundLights = [&](int begin, int end)
+        {
+            for(int l = begin; l < end; l++)
+            {
+                const PointLight& light = lights.lights[l];
+                float radius = light.positionRadius.w;
+                glm::vec3 centre = glm::vec3(view * glm::vec4(glm::vec3(light.positionRadius), 1.0f));
+                float depth = -centre.z;
+                LightBounds& bound = bounds[l];
+
+                //Nothing for lights wholly nearer than the near plane or beyond the far one
+                if(depth + radius < nearPlane || depth - radius > farPlane)
+                {
+                    bound.firstSlice = 1;
+                    bound.lastSlice = 0;
+                    continue;
+                }
+                bound.firstSlice = Slice(glm::max(depth - radius, nearPlane), sliceScale, sliceBias);
+                bound.lastSlice = Slice(glm::min(depth + radius, farPlane), sliceScale, sliceBias);
+
+                //Crossing the near plane, its corners can't be projected, so it gets the whole screen
+                bound.firstX = bound.firstY = 0;
+                bound.lastX = CLUSTER_TILES_X - 1;
+                bound.lastY = CLUSTER_TILES_Y - 1;
+                if(depth - radius < nearPlane)
+                    continue;
+
+                //Otherwise the screen rectangle of the corners of the box around it
+                float lowX = 1.0f, lowY = 1.0f, highX = -1.0f, highY = -1.0f;
+                for(int corner = 0; corner < 8; corner++)
+                {
+                    glm::vec3 offset((corner & 1) ? radius : -radius, (corner & 2) ? radius : -radius, (corner & 4) ? radius : -radius);
+                    glm::vec4 clip = projection * glm::vec4(centre + offset, 1.0f);
+                    lowX = glm::min(lowX, clip.x / clip.w);
+                    lowY = glm::min(lowY, clip.y / clip.w);
+                    highX = glm::max(highX, clip.x / clip.w);
+                    highY = glm::max(highY, clip.y / clip.w);
+                }
+                if(highX < -1.0f || highY < -1.0f || lowX > 1.0f || lowY > 1.0f)
+                {
+                    bound.firstSlice = 1;
+                    bound.lastSlice = 0;
+                    continue;
+                }
+                bound.firstX = Tile(lowX, CLUSTER_TILES_X);
+                bound.firstY = Tile(lowY, CLUSTER_TILES_Y);
+                bound.lastX = Tile(highX, CLUSTER_TILES_X);
+                bound.lastY = Tile(highY, CLUSTER_TILES_Y);
+            }
+        };
+
+        //Pass 2: each slice's lists, counted and then filled so each slice is one block of indices
+        auto fillSlices = [&](int begin, int end)
+        {
+            for(int s = begin; s < end; s++)
+            {
+                GLuint* sliceClusters = &clusters[s * CLUSTER_TILES_X * CLUSTER_TILES_Y * 2];
+                for(int c = 0; c < CLUSTER_TILES_X * CLUSTER_TILES_Y; c++)
+                    sliceClusters[c * 2 + 1] = 0;
+
+                for(int l = 0; l < lightCount; l++)
+                {
+                    const LightBounds& bound = bounds[l];
+                    if(s < bound.firstSlice || s > bound.lastSlice)
+                        continue;
+                    for(int y = bound.firstY; y <= bound.lastY; y++)
+                        for(int x = bound.firstX; x <= bound.lastX; x++)
+                            sliceClusters[(y * CLUSTER_TILES_X + x) * 2 + 1]++;
+                }
+
+                //Offsets within the slice for now, moved on by the slices before it once they're all done
+                GLuint total = 0;
+                for(int c = 0; c < CLUSTER_TILES_X * CLUSTER_TILES_Y; c++)
+                {
+                    sliceClusters[c * 2] = total;
+                    total += sliceClusters[c * 2 + 1];
+                }
+                sliceCounts[s] = (int)total;
+
+                std::vector<GLuint>& sliceList = sliceIndices[s];
+                sliceList.resize(total);
+                std::vector<GLuint> filled(CLUSTER_TILES_X * CLUSTER_TILES_Y, 0);
+                for(int l = 0; l < lightCount; l++)
+                {
+                    const LightBounds& bound = bounds[l];
+                    if(s < bound.firstSlice || s > bound.lastSlice)
+                        continue;
+                    for(int y = bound.firstY; y <= bound.lastY; y++)
+                    {
+                        for(int x = bound.firstX; x <= bound.lastX; x++)
+                        {
+                            int c = y * CLUSTER_TILES_X + x;
+                            sliceList[sliceClusters[c * 2] + filled[c]++] = (GLuint)l;
+                        }
+                    }
+                }
+            }
+        };
+
+        if(jobs != NULL)
+        {
+            jobs->ParallelFor(lightCount, 256, boundLights);
+            jobs->ParallelFor(CLUSTER_SLICES, 1, fillSlices);
+        }
+        else
+        {
+            boundLights(0, lightCount);
+            fillSlices(0, CLUSTER_SLICES);
+        }
+
+        //Join the slices up
+        indexCount = 0;
+        for(int s = 0; s < CLUSTER_SLICES; s++)
+            indexCount += sliceCounts[s];
+        indices.resize(glm::max(indexCount, 1));
+        maxPerCluster = 0;
+        GLuint sliceOffset = 0;
+        for(int s = 0; s < CLUSTER_SLICES; s++)
+        {
+            GLuint* sliceClusters = &clusters[s * CLUSTER_TILES_X * CLUSTER_TILES_Y * 2];
+            for(int c = 0; c < CLUSTER_TILES_X * CLUSTER_TILES_Y; c++)
+            {
+                sliceClusters[c * 2] += sliceOffset;
+                maxPerCluster = glm::max(maxPerCluster, (int)sliceClusters[c * 2 + 1]);
+            }
+            if(sliceCounts[s] > 0)
+                memcpy(&indices[sliceOffset], &sliceIndices[s][0], sliceCounts[s] * sizeof(GLuint));
+            sliceOffset += sliceCounts[s];
+        }
+
+        //The view matrix's z row, flipped as the camera looks down -z
+        header.depthPlane = glm::vec4(-view[0][2], -view[1][2], -view[2][2], -view[3][2]);
+        header.tileDepth = glm::vec4((float)viewportWidth / CLUSTER_TILES_X, (float)viewportHeight / CLUSTER_TILES_Y, sliceScale, sliceBias);
+        header.dims[0] = CLUSTER_TILES_X;
+        header.dims[1] = CLUSTER_TILES_Y;
+        header.dims[2] = CLUSTER_SLICES;
+        header.dims[3] = 0;
+
+        std::chrono::high_resolution_clock::time_point built = std::chrono::high_resolution_clock::now();
+        buildSeconds = std::chrono::duration<double>(built - start).count();
+        Upload();
+        uploadSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - built).count();
+    }
+
+    void Release()
+    {
+        if(gridBuffer.IsNull())
+            return;
+        gpuResources.Destroy(gridBuffer);
+        gpuResources.Destroy(indexBuffer);
+        perfStats.ReleaseBuffer(GetGridBytes() + indexCapacity * sizeof(GLuint));
+        indexCapacity = 0;
+    }
+
+private:
+    struct LightBounds
+    {
+        int firstSlice, lastSlice;      //Past each other if the light can't be seen
+        int firstX, firstY, lastX, lastY;     //Tiles
+    };
+
+    ClusterGridHeader header;
+    std::vector<GLuint> clusters;       //Offset and count for each cluster, slice by slice, then row by row
+    std::vector<GLuint> indices;
+    std::vector<LightBounds> bounds;
+    std::vector<std::vector<GLuint> > sliceIndices;
+    std::vector<int> sliceCounts;
+
+    GPUHandle gridBuffer;
+    GPUHandle indexBuffer;
+    int indexCapacity;
+
+    static int Slice(float depth, float scale, float bias)
+    {
+        return glm::clamp((int)(logf(depth) * scale + bias), 0, CLUSTER_SLICES - 1);
+    }
+
+    /* The tile a normalised device coordinate falls in, -1 to 1 being all the tiles across (or up) */
+    static int Tile(float ndc, int tiles)
+    {
+        return glm::clamp((int)floorf((ndc * 0.5f + 0.5f) * tiles), 0, tiles - 1);
+    }
+
+    static long GetGridBytes()
+    {
+        return sizeof(ClusterGridHeader) + CLUSTER_COUNT * 2 * sizeof(GLuint);
+    }
+
+    /* Orphan and refill both buffers, growing the index one when there are more indices than fit */
+    void Upload()
+    {
+        if(gridBuffer.IsNull())
+        {
+            gridBuffer = gpuResources.Create(GPU_BUFFER);
+            indexBuffer = gpuResources.Create(GPU_BUFFER);
+            gpuResources.SetBytes(gridBuffer, GetGridBytes());
+            perfStats.bufferMemory += GetGridBytes();
+        }
+        if((int)indices.size() > indexCapacity)
+        {
+            long newCapacity = glm::max((long)indices.size(), 2L * indexCapacity);
+            perfStats.bufferMemory += (newCapacity - indexCapacity) * sizeof(GLuint);
+            indexCapacity = (int)newCapacity;
+            gpuResources.SetBytes(indexBuffer, indexCapacity * sizeof(GLuint));
+        }
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, gpuResources.Get(gridBuffer));
+        glBufferData(GL_SHADER_STORAGE_BUFFER, GetGridBytes(), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(ClusterGridHeader), &header);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(ClusterGridHeader), clusters.size() * sizeof(GLuint), &clusters[0]);
+        perfStats.AddBufferUpload(GetGridBytes(), false);
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, gpuResources.Get(indexBuffer));
+        glBufferData(GL_SHADER_STORAGE_BUFFER, indexCapacity * sizeof(GLuint), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, indices.size() * sizeof(GLuint), &indices[0]);
+        perfStats.AddBufferUpload(indices.size() * sizeof(GLuint), false);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_STORAGE_BINDING, gpuResources.Get(gridBuffer));
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_INDEX_STORAGE_BINDING, gpuResources.Get(indexBuffer));
+        perfStats.AddStateChanges(2);
+    }
+};
+
+/* The clusters for the main loop's clustered lighting */
+LightClusters lightClusters;
+
+#endif // LIGHT_CLUSTERS_H
@@ -2,14 +2,85 @@
 #define MESH_H
 
 #include <iostream>
+#include <vector>
 
 #include "Introduction.h"
 
+class Mesh;
+
+/* A cheaper version of a mesh, and how far (in model units) its surface strays from the full one */
+struct MeshLOD
+{
+    Mesh* mesh;
+    float error;
+};
+
 class Mesh
 {
 public:
+    /* Level of detail chain, most detailed first. Empty for meshes that only have the one level */
+    std::vector<MeshLOD> lods;
+
+    virtual ~Mesh() {}
+
     /* Draw the mesh with the supplied texture */
     virtual void Draw(Shader shader) = 0;
+
+    /* Draw every vertex in the buffer once, as a point, for shaders that build something from each (e.g. NormalLines).
+       Does nothing for meshes without vertex attributes */
+    virtual void DrawVertices(Shader shader) {}
+
+    /* Copy the vertex buffer back from the GPU, e.g. for DebugDraw::AddNormals. Slow, so only for debugging.
+       Empty for meshes without vertex attributes */
+    virtual void ReadVertices(std::vector<struct Vertex>& vertices)
+    {
+        vertices.clear();
+    }
+
+    /* The colour that goes in the mesh's ObjectUniforms when it's drawn */
+    virtual glm::vec4 GetColour() const
+    {
+        return glm::vec4(1.0f);
+    }
+
+    /* The layer of its texture array that goes in the mesh's ObjectUniforms, for meshes textured from one */
+    virtual int GetTextureLayer() const
+    {
+        return 0;
+    }
+
+    /* The bindless handle of its texture that goes in the mesh's ObjectUniforms, or 0 to bind it instead */
+    virtual GLuint64 GetTextureHandle() const
+    {
+        return 0;
+    }
+
+    /* Its texture's id in the TextureStreamer, which wants to know how big it's drawn, or -1 if it isn't streamed */
+    virtual int GetStreamedTexture() const
+    {
+        return -1;
+    }
+
+    /* The ShaderFeature bits to draw it with, out of the ones wanted, e.g. no texture for a mesh that hasn't got one */
+    virtual unsigned GetShaderFeatures(unsigned wanted) const
+    {
+        return wanted & ~(SHADER_TEXTURED | SHADER_MESH_FEATURES);
+    }
+
+    void AddLOD(Mesh* lowerDetail, float error)
+    {
+        MeshLOD lod = {lowerDetail, error};
+        lods.push_back(lod);
+    }
+
+    /* The cheapest level whose error is no more than maxError model units */
+    Mesh* SelectLOD(float maxError)
+    {
+        Mesh* selected = this;
+        for(size_t i = 0; i < lods.size() && lods[i].error <= maxError; i++)
+            selected = lods[i].mesh;
+        return selected;
+    }
 };
 
 #endif // MESH_H
@@ -0,0 +1,219 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <map>
+#include <string>
+#include <chrono>
+
+#include "Introduction.h"
+#include "TriangleMesh.h"
+#include "UVSphereGeometry.h"
+#include "ConeGeometry.h"
+#include "IcosphereGeometry.h"
+#include "PrimitiveTables.h"
+
+/*
+ * Shares procedural meshes between every object that asks for the same shape.
+ * Meshes are generated at unit size (radius 1) and the objects using them are scaled to
+ * the size they want with GraphicsObject::scale, so only the shape parameters (segments,
+ * rings, the height of a cone relative to its radius) plus the look (texture and colour,
+ * which live in the mesh) make up the key.
+ *
+ * Each mesh also gets an LOD chain of the same shape at half the segments and rings, then a
+ * quarter, and so on, which are just more meshes from the cache.
+ *
+ * Shapes that have a table in PrimitiveTables.h are uploaded straight from it; the rest are generated.
+ */
+
+/* Fewest segments and rings the LOD chains go down to */
+const int SPHERE_LOD_MIN_SEGMENTS = 6;
+const int SPHERE_LOD_MIN_RINGS = 3;
+const int CONE_LOD_MIN_SEGMENTS = 4;
+const int ICOSPHERE_LOD_MIN_LEVEL = 1;
+
+/* Furthest a unit sphere's surface gets from the real sphere: the sag in the middle of the widest edge */
+float SphereError(int segments, int rings)
+{
+    double segmentSag = 1.0 - cos(glm::pi<double>() / segments);
+    double ringSag = 1.0 - cos(glm::pi<double>() / (2 * rings));
+    return (float)std::max(segmentSag, ringSag);
+}
+
+enum MeshGenerator
+{
+    MESH_SPHERE,
+    MESH_CONE,
+    MESH_ICOSPHERE
+};
+
+struct MeshKey
+{
+    MeshGenerator generator;
+    int segments;
+    int rings;      //Subdivision level for icospheres
+    double shape;   //Cone height / radius. Unused by spheres
+    std::string texturePath;
+    GLfloat colour[3];
+
+    bool operator<(const MeshKey& other) const
+    {
+        if(generator != other.generator) return generator < other.generator;
+        if(segments != other.segments) return segments < other.segments;
+        if(rings != other.rings) return rings < other.rings;
+        if(shape != other.shape) return shape < other.shape;
+        if(texturePath != other.texturePath) return texturePath < other.texturePath;
+        for(int k = 0; k < 3; k++)
+            if(colour[k] != other.colour[k]) return colour[k] < other.colour[k];
+        return false;
+    }
+};
+
+class MeshCache
+{
+public:
+    int hits;               //Requests answered with an existing mesh
+    int misses;             //Requests that had to upload a new mesh
+    int tableMeshes;        //Misses uploaded from a compile-time table rather than generated
+    long bufferBytes;       //Vertex data uploaded for the meshes currently in the cache
+    double buildSeconds;    //Time spent generating and uploading
+
+    MeshCache() : hits(0), misses(0), tableMeshes(0), bufferBytes(0), buildSeconds(0.0)
+    {
+    }
+
+    /* A sphere of radius 1 */
+    Mesh* GetSphere(int segments, int rings, const GLchar* texturePath, GLfloat colour[3])
+    {
+        MeshKey key = MakeKey(MESH_SPHERE, segments, rings, 0.0, texturePath, colour);
+        TriangleMesh* mesh = Find(key);
+        if(mesh == NULL)
+        {
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            const PrimitiveTable* table = FindSphereTable(segments, rings);
+            if(table != NULL)
+            {
+                mesh = Insert(key, new TriangleMesh(table->vertices, table->vertexCount, texturePath, colour));
+                tableMeshes++;
+            }
+            else
+                mesh = Insert(key, new TriangleMesh(GetSpherePhong(segments, rings, 1.0), texturePath, colour));
+            buildSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            int lodSegments = std::min(segments, std::max(segments / 2, SPHERE_LOD_MIN_SEGMENTS));
+            int lodRings = std::min(rings, std::max(rings / 2, SPHERE_LOD_MIN_RINGS));
+            if(lodSegments < segments || lodRings < rings)
+                AddChain(mesh, GetSphere(lodSegments, lodRings, texturePath, colour), SphereError(lodSegments, lodRings));
+        }
+        return mesh;
+    }
+
+    /* A cone with a base of radius 1, heightOverRadius tall */
+    Mesh* GetCone(int segments, double heightOverRadius, const GLchar* texturePath, GLfloat colour[3])
+    {
+        MeshKey key = MakeKey(MESH_CONE, segments, 0, heightOverRadius, texturePath, colour);
+        TriangleMesh* mesh = Find(key);
+        if(mesh == NULL)
+        {
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            const PrimitiveTable* table = FindConeTable(segments, heightOverRadius);
+            if(table != NULL)
+            {
+                mesh = Insert(key, new TriangleMesh(table->vertices, table->vertexCount, texturePath, colour));
+                tableMeshes++;
+            }
+            else
+                mesh = Insert(key, new TriangleMesh(GetConePhong(segments, heightOverRadius, 1.0), texturePath, colour));
+            buildSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            //Only the rim is approximated
+            int lodSegments = std::min(segments, std::max(segments / 2, CONE_LOD_MIN_SEGMENTS));
+            if(lodSegments < segments)
+                AddChain(mesh, GetCone(lodSegments, heightOverRadius, texturePath, colour), (float)(1.0 - cos(glm::pi<double>() / lodSegments)));
+        }
+        return mesh;
+    }
+
+    /* An indexed icosphere of radius 1 */
+    Mesh* GetIcosphere(int subdivisions, const GLchar* texturePath, GLfloat colour[3])
+    {
+        MeshKey key = MakeKey(MESH_ICOSPHERE, 0, subdivisions, 0.0, texturePath, colour);
+        TriangleMesh* mesh = Find(key);
+        if(mesh == NULL)
+        {
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            IndexedGeometry geometry = ::GetIcosphere(subdivisions, 1.0);
+            mesh = Insert(key, new TriangleMesh(geometry.vertices, geometry.indices, texturePath, colour));
+            buildSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            if(subdivisions > ICOSPHERE_LOD_MIN_LEVEL)
+            {
+                IndexedGeometry lower = ::GetIcosphere(subdivisions - 1, 1.0);
+                AddChain(mesh, GetIcosphere(subdivisions - 1, texturePath, colour), (float)MaxSphereError(lower.vertices, lower.indices, 1.0));
+            }
+        }
+        return mesh;
+    }
+
+    int MeshCount() const
+    {
+        return (int)meshes.size();
+    }
+
+    /* Delete every mesh. Anything still pointing at one must not be drawn again */
+    void Clear()
+    {
+        for(std::map<MeshKey, TriangleMesh*>::iterator it = meshes.begin(); it != meshes.end(); ++it)
+        {
+            it->second->Release();
+            delete it->second;
+        }
+        meshes.clear();
+        bufferBytes = 0;
+    }
+
+private:
+    std::map<MeshKey, TriangleMesh*> meshes;
+
+    static MeshKey MakeKey(MeshGenerator generator, int segments, int rings, double shape, const GLchar* texturePath, GLfloat colour[3])
+    {
+        MeshKey key;
+        key.generator = generator;
+        key.segments = segments;
+        key.rings = rings;
+        key.shape = shape;
+        key.texturePath = texturePath;
+        for(int k = 0; k < 3; k++)
+            key.colour[k] = colour[k];
+        return key;
+    }
+
+    TriangleMesh* Find(const MeshKey& key)
+    {
+        std::map<MeshKey, TriangleMesh*>::iterator it = meshes.find(key);
+        if(it == meshes.end())
+            return NULL;
+        hits++;
+        return it->second;
+    }
+
+    /* Give the mesh the next level down, and everything below that */
+    static void AddChain(Mesh* mesh, Mesh* lowerDetail, float error)
+    {
+        mesh->AddLOD(lowerDetail, error);
+        for(size_t i = 0; i < lowerDetail->lods.size(); i++)
+            mesh->AddLOD(lowerDetail->lods[i].mesh, lowerDetail->lods[i].error);
+    }
+
+    TriangleMesh* Insert(const MeshKey& key, TriangleMesh* mesh)
+    {
+        misses++;
+        bufferBytes += mesh->GetBufferBytes();
+        meshes[key] = mesh;
+        return mesh;
+    }
+};
+
+/* The cache the scenes share */
+MeshCache meshCache;
+
+#endif // MESH_CACHE_H
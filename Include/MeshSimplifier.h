@@ -0,0 +1,406 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <math.h>
+#include <string.h>
+#include <map>
+#include <queue>
+#include <vector>
+#include <algorithm>
+
+#include "Introduction.h"
+
+/*
+ * Quadric error metric simplification (Garland & Heckbert) for the triangle soups
+ * that the meshes upload.
+ *
+ * Corners with identical position, normal and UVs are welded into "wedges", and wedges at the
+ * same position make up one point of the topology. Edges are collapsed cheapest first, always
+ * onto one of their end points so that the surviving corners can keep real attributes. A corner
+ * that moves takes its attributes from the corner across the collapsed edge that had the same
+ * wedge, which keeps UV seams and hard normal edges lined up. Where there isn't one (the corner
+ * is on the other side of a seam) it keeps its own normal and UVs at the new position.
+ *
+ * Simplify() can be called again with smaller targets to build a whole LOD chain in one go.
+ */
+class MeshSimplifier
+{
+public:
+    MeshSimplifier(const std::vector<struct Vertex>& triangles) : maxError(0.0)
+    {
+        WeldCorners(triangles);
+        BuildQuadrics();
+        for(int p = 0; p < (int)positions.size(); p++)
+            PushEdges(p);
+    }
+
+    /* Collapse edges until there are no more than targetTriangles left, or nothing more can go */
+    void Simplify(int targetTriangles)
+    {
+        while(liveTriangles > targetTriangles && !candidates.empty())
+        {
+            Collapse candidate = candidates.top();
+            candidates.pop();
+
+            if(!pointAlive[candidate.from] || !pointAlive[candidate.to])
+                continue;
+            if(pointVersion[candidate.from] != candidate.fromVersion || pointVersion[candidate.to] != candidate.toVersion)
+                continue;
+
+            if(TryCollapse(candidate.from, candidate.to))
+                maxError = std::max(maxError, sqrt(std::max(candidate.cost, 0.0)));
+        }
+    }
+
+    int TriangleCount() const
+    {
+        return liveTriangles;
+    }
+
+    /* Largest distance any collapse so far has moved the surface, roughly, in model units */
+    double Error() const
+    {
+        return maxError;
+    }
+
+    /* The simplified mesh as a triangle list */
+    std::vector<struct Vertex> GetTriangles() const
+    {
+        std::vector<struct Vertex> result;
+        result.reserve(liveTriangles * 3);
+        for(size_t t = 0; t < triangles.size(); t++)
+        {
+            if(!triangleAlive[t])
+                continue;
+            for(int k = 0; k < 3; k++)
+                result.push_back(wedges[triangles[t].corner[k]]);
+        }
+        return result;
+    }
+
+private:
+    struct Triangle
+    {
+        int corner[3]; //Wedge indices
+    };
+
+    /* Symmetric 4x4 matrix, upper triangle only */
+    struct Quadric
+    {
+        double m[10];
+
+        Quadric() { memset(m, 0, sizeof(m)); }
+
+        void AddPlane(glm::dvec3 normal, double d)
+        {
+            double a = normal.x, b = normal.y, c = normal.z;
+            m[0] += a*a; m[1] += a*b; m[2] += a*c; m[3] += a*d;
+                         m[4] += b*b; m[5] += b*c; m[6] += b*d;
+                                      m[7] += c*c; m[8] += c*d;
+                                                   m[9] += d*d;
+        }
+
+        void Add(const Quadric& other)
+        {
+            for(int i = 0; i < 10; i++)
+                m[i] += other.m[i];
+        }
+
+        /* Sum of squared distances from p to the planes */
+        double Evaluate(glm::dvec3 p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            return m[0]*x*x + 2*m[1]*x*y + 2*m[2]*x*z + 2*m[3]*x
+                 + m[4]*y*y + 2*m[5]*y*z + 2*m[6]*y
+                 + m[7]*z*z + 2*m[8]*z
+                 + m[9];
+        }
+    };
+
+    /* Move point "from" onto point "to" */
+    struct Collapse
+    {
+        double cost;
+        int from, to;
+        int fromVersion, toVersion;
+
+        bool operator<(const Collapse& other) const
+        {
+            return cost > other.cost; //Cheapest at the top of the queue
+        }
+    };
+
+    std::vector<struct Vertex> wedges;
+    std::vector<int> wedgePoint;
+
+    std::vector<glm::dvec3> positions;
+    std::vector<Quadric> quadrics;
+    std::vector<std::vector<int> > pointTriangles; //May hold dead triangles, or ones that have since moved off the point
+    std::vector<bool> pointAlive;
+    std::vector<bool> pointOnBorder;
+    std::vector<int> pointVersion;
+
+    std::vector<Triangle> triangles;
+    std::vector<bool> triangleAlive;
+    int liveTriangles;
+
+    std::priority_queue<Collapse> candidates;
+    double maxError;
+
+    static glm::dvec3 GetPosition(const struct Vertex& v)
+    {
+        return glm::dvec3(v.position[0], v.position[1], v.position[2]);
+    }
+
+    int PointOf(const Triangle& triangle, int k) const
+    {
+        return wedgePoint[triangle.corner[k]];
+    }
+
+    /* Which corner of the triangle is at the point, or -1 */
+    int CornerAt(const Triangle& triangle, int point) const
+    {
+        for(int k = 0; k < 3; k++)
+            if(PointOf(triangle, k) == point)
+                return k;
+        return -1;
+    }
+
+    void WeldCorners(const std::vector<struct Vertex>& corners)
+    {
+        std::map<std::vector<unsigned char>, int> wedgeLookup;
+        std::map<std::vector<double>, int> pointLookup;
+
+        triangles.resize(corners.size() / 3);
+        for(size_t c = 0; c < triangles.size() * 3; c++)
+        {
+            const unsigned char* bytes = (const unsigned char*)&corners[c];
+            std::vector<unsigned char> wedgeKey(bytes, bytes + sizeof(struct Vertex));
+
+            std::map<std::vector<unsigned char>, int>::iterator found = wedgeLookup.find(wedgeKey);
+            int wedge;
+            if(found != wedgeLookup.end())
+            {
+                wedge = found->second;
+            }
+            else
+            {
+                wedge = (int)wedges.size();
+                wedgeLookup[wedgeKey] = wedge;
+                wedges.push_back(corners[c]);
+
+                std::vector<double> pointKey(corners[c].position, corners[c].position + 3);
+                std::map<std::vector<double>, int>::iterator point = pointLookup.find(pointKey);
+                if(point != pointLookup.end())
+                {
+                    wedgePoint.push_back(point->second);
+                }
+                else
+                {
+                    pointLookup[pointKey] = (int)positions.size();
+                    wedgePoint.push_back((int)positions.size());
+                    positions.push_back(GetPosition(corners[c]));
+                }
+            }
+            triangles[c / 3].corner[c % 3] = wedge;
+        }
+
+        pointTriangles.resize(positions.size());
+        pointAlive.assign(positions.size(), true);
+        pointOnBorder.assign(positions.size(), false);
+        pointVersion.assign(positions.size(), 0);
+        triangleAlive.assign(triangles.size(), true);
+        liveTriangles = (int)triangles.size();
+
+        //Edges used by a single triangle are on an open border
+        std::map<std::pair<int, int>, int> edgeUse;
+        for(size_t t = 0; t < triangles.size(); t++)
+        {
+            for(int k = 0; k < 3; k++)
+            {
+                int a = PointOf(triangles[t], k);
+                int b = PointOf(triangles[t], (k + 1) % 3);
+                pointTriangles[a].push_back((int)t);
+                edgeUse[std::make_pair(std::min(a, b), std::max(a, b))]++;
+            }
+        }
+        for(std::map<std::pair<int, int>, int>::iterator it = edgeUse.begin(); it != edgeUse.end(); ++it)
+        {
+            if(it->second == 1)
+            {
+                pointOnBorder[it->first.first] = true;
+                pointOnBorder[it->first.second] = true;
+            }
+        }
+    }
+
+    void BuildQuadrics()
+    {
+        quadrics.resize(positions.size());
+        for(size_t t = 0; t < triangles.size(); t++)
+        {
+            glm::dvec3 a = positions[PointOf(triangles[t], 0)];
+            glm::dvec3 b = positions[PointOf(triangles[t], 1)];
+            glm::dvec3 c = positions[PointOf(triangles[t], 2)];
+            glm::dvec3 normal = glm::cross(b - a, c - a);
+            double length = glm::length(normal);
+            if(length <= 0.0)
+                continue;
+            normal /= length;
+
+            for(int k = 0; k < 3; k++)
+                quadrics[PointOf(triangles[t], k)].AddPlane(normal, -glm::dot(normal, a));
+        }
+    }
+
+    /* Live triangles touching the point */
+    void TrianglesAround(int point, std::vector<int>& result) const
+    {
+        result.clear();
+        for(size_t i = 0; i < pointTriangles[point].size(); i++)
+        {
+            int t = pointTriangles[point][i];
+            if(triangleAlive[t] && CornerAt(triangles[t], point) >= 0 && std::find(result.begin(), result.end(), t) == result.end())
+                result.push_back(t);
+        }
+    }
+
+    void Neighbours(int point, std::vector<int>& result) const
+    {
+        std::vector<int> around;
+        TrianglesAround(point, around);
+        result.clear();
+        for(size_t i = 0; i < around.size(); i++)
+        {
+            for(int k = 0; k < 3; k++)
+            {
+                int other = PointOf(triangles[around[i]], k);
+                if(other != point && std::find(result.begin(), result.end(), other) == result.end())
+                    result.push_back(other);
+            }
+        }
+    }
+
+    void PushCandidate(int from, int to)
+    {
+        //Points on an open border may only slide along it
+        if(pointOnBorder[from] && !pointOnBorder[to])
+            return;
+
+        Quadric combined = quadrics[from];
+        combined.Add(quadrics[to]);
+
+        Collapse collapse;
+        collapse.cost = combined.Evaluate(positions[to]);
+        collapse.from = from;
+        collapse.to = to;
+        collapse.fromVersion = pointVersion[from];
+        collapse.toVersion = pointVersion[to];
+        candidates.push(collapse);
+    }
+
+    void PushEdges(int point)
+    {
+        std::vector<int> neighbours;
+        Neighbours(point, neighbours);
+        for(size_t i = 0; i < neighbours.size(); i++)
+        {
+            PushCandidate(point, neighbours[i]);
+            PushCandidate(neighbours[i], point);
+        }
+    }
+
+    /* A copy of the wedge at another point. Left unused if the collapse doesn't happen */
+    int MovedWedge(int wedge, int point)
+    {
+        struct Vertex moved = wedges[wedge];
+        for(int k = 0; k < 3; k++)
+            moved.position[k] = positions[point][k];
+        wedges.push_back(moved);
+        wedgePoint.push_back(point);
+        return (int)wedges.size() - 1;
+    }
+
+    bool TryCollapse(int from, int to)
+    {
+        std::vector<int> around;
+        TrianglesAround(from, around);
+
+        std::vector<int> removed, kept;
+        for(size_t i = 0; i < around.size(); i++)
+        {
+            if(CornerAt(triangles[around[i]], to) >= 0)
+                removed.push_back(around[i]);
+            else
+                kept.push_back(around[i]);
+        }
+        if(removed.empty())
+            return false;
+
+        //Link condition: the two points may only share the neighbours across the collapsing triangles,
+        //otherwise the surface would fold into something non-manifold
+        std::vector<int> fromNeighbours, toNeighbours;
+        Neighbours(from, fromNeighbours);
+        Neighbours(to, toNeighbours);
+        int shared = 0;
+        for(size_t i = 0; i < fromNeighbours.size(); i++)
+            if(std::find(toNeighbours.begin(), toNeighbours.end(), fromNeighbours[i]) != toNeighbours.end())
+                shared++;
+        if(shared != (int)removed.size())
+            return false;
+
+        //Find the wedge each moving corner turns into, and make sure no triangle flips over
+        std::vector<int> newWedge(kept.size());
+        for(size_t i = 0; i < kept.size(); i++)
+        {
+            const Triangle& triangle = triangles[kept[i]];
+            int corner = CornerAt(triangle, from);
+
+            newWedge[i] = -1;
+            for(size_t r = 0; r < removed.size() && newWedge[i] < 0; r++)
+            {
+                const Triangle& gone = triangles[removed[r]];
+                if(gone.corner[CornerAt(gone, from)] == triangle.corner[corner])
+                    newWedge[i] = gone.corner[CornerAt(gone, to)];
+            }
+            if(newWedge[i] < 0)
+            {
+                //Across a seam from the collapsing edge, so keep this side's attributes
+                newWedge[i] = MovedWedge(triangle.corner[corner], to);
+            }
+
+            glm::dvec3 before[3], after[3];
+            for(int k = 0; k < 3; k++)
+            {
+                before[k] = positions[PointOf(triangle, k)];
+                after[k] = (k == corner) ? positions[to] : before[k];
+            }
+            glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            if(glm::dot(normalBefore, normalAfter) <= 0.0)
+                return false;
+        }
+
+        //Do it
+        for(size_t r = 0; r < removed.size(); r++)
+            triangleAlive[removed[r]] = false;
+        liveTriangles -= (int)removed.size();
+
+        for(size_t i = 0; i < kept.size(); i++)
+        {
+            Triangle& triangle = triangles[kept[i]];
+            triangle.corner[CornerAt(triangle, from)] = newWedge[i];
+            pointTriangles[to].push_back(kept[i]);
+        }
+
+        quadrics[to].Add(quadrics[from]);
+        pointAlive[from] = false;
+        pointVersion[from]++;
+        pointVersion[to]++;
+
+        PushEdges(to);
+        return true;
+    }
+};
+
+#endif // MESH_SIMPLIFIER_H
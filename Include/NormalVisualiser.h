@@ -0,0 +1,44 @@
+#ifndef NORMAL_VISUALISER_H
+#define NORMAL_VISUALISER_H
+
+#include "Introduction.h"
+#include "GraphicsObject.h"
+
+/*
+ * Shows the normals of any object's mesh straight from the vertex buffer it already has.
+ * The mesh is drawn as points and a geometry shader (Shaders/NormalLines.geom) turns each one
+ * into a line along its normal, so there's no second mesh of lines to build or keep.
+ * Needs the GL context, so make it in main.
+ */
+class NormalVisualiser
+{
+public:
+    float length;   //In world units, whatever the object's scale
+    GLfloat colour[3];
+
+    NormalVisualiser(float normalLength, GLfloat lineColour[3])
+        : length(normalLength), shader("Shaders/NormalLines.vert", "Shaders/NormalLines.geom", "Shaders/Object.frag")
+    {
+        for(int k = 0; k < 3; k++)
+            colour[k] = lineColour[k];
+    }
+
+    void Draw(GraphicsObject& object, glm::mat4 view, glm::mat4 projection)
+    {
+        shader.Use();
+        glUniform1f(glGetUniformLocation(shader.getShaderProgram(), "normalLength"), length);
+        perfStats.AddStateChanges(2);
+
+        object.DrawVertices(shader, view, projection, colour);
+    }
+
+    void Release()
+    {
+        shader.Release();
+    }
+
+private:
+    Shader shader;
+};
+
+#endif // NORMAL_VISUALISER_H
@@ -2,79 +2,140 @@
 #define OBJ_MESH_H
 
 #include "Mesh.h"
+#include "TriangleMesh.h"
+#include "MeshSimplifier.h"
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "TinyOBJLoader/tiny_obj_loader.h"
 
-class OBJMesh :public Mesh
+/* How many simplified levels to make below the imported mesh, each with half the triangles of the last */
+const int OBJ_LOD_LEVELS = 4;
+
+/* Reads the .mtl files an OBJ names the same way as the OBJ, through the asset pack, from the OBJ's folder */
+class AssetMaterialReader: public tinyobj::MaterialReader
 {
 public:
-    /* Constructor */
-    OBJMesh(const GLchar* objPath, const GLchar* texturePath, GLfloat colour[3])
+    AssetMaterialReader(const std::string& objPath)
     {
-        r = colour[0];
-        g = colour[1];
-        b = colour[2];
-
-        /* TinyOBJ setup*/
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials; //Not used
-
-        std::string err;
-        bool success = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, objPath);
+        size_t slash = objPath.find_last_of("/\\");
+        folder = (slash == std::string::npos) ? std::string() : objPath.substr(0, slash + 1);
+    }
 
-        //Print any errors raised by the OBJ loader
-        if (!err.empty())
+    bool operator()(const std::string& matId, std::vector<tinyobj::material_t>* materials,
+                    std::map<std::string, int>* matMap, std::string* err)
+    {
+        Asset file;
+        if(!LoadAsset(folder + matId, file))
         {
-          std::cerr << err << std::endl;
+            if(err)
+                *err += "Material file " + folder + matId + " not found.\n";
+            return false;
         }
+        AssetStreamBuf buffer(file);
+        std::istream stream(&buffer);
+        std::string warning;
+        tinyobj::LoadMtl(matMap, materials, &stream, &warning);
+        if(err)
+            *err += warning;
+        return true;
+    }
 
-        //Exit application if could not load OBJ
-        if (!success)
-        {
-          exit(1);
-        }
+private:
+    std::string folder;
+};
 
-        std::vector<Vertex> OBJVertices;
+/* The triangles of an OBJ file, three vertices each */
+std::vector<struct Vertex> LoadOBJVertices(const GLchar* objPath)
+{
+    std::vector<struct Vertex> OBJVertices;
+
+    /* TinyOBJ setup*/
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials; //Not used
 
-        //Shapes
-        for(size_t shape = 0; shape < shapes.size(); shape++)
+    //Parsed where it is, in the asset pack's mapping if it's there
+    std::string err;
+    bool success = false;
+    Asset file;
+    if(LoadAsset(objPath, file))
+    {
+        AssetStreamBuf buffer(file);
+        std::istream stream(&buffer);
+        AssetMaterialReader materialReader(objPath);
+        success = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, &stream, &materialReader);
+    }
+    else
+    {
+        err = "Cannot open file [" + std::string(objPath) + "]\n";
+    }
+
+    //Print any errors raised by the OBJ loader
+    if (!err.empty())
+    {
+      std::cerr << err << std::endl;
+    }
+
+    //Exit application if could not load OBJ
+    if (!success)
+    {
+      exit(1);
+    }
+
+    //Shapes
+    for(size_t shape = 0; shape < shapes.size(); shape++)
+    {
+        //Polygon faces within a given shape
+        size_t index_offset = 0;
+        for(size_t face = 0; face < shapes[shape].mesh.num_face_vertices.size(); face++)
         {
-            //Polygon faces within a given shape
-            size_t index_offset = 0;
-            for(size_t face = 0; face < shapes[shape].mesh.num_face_vertices.size(); face++)
+            //Imported as triangles, so I -think- this should always be 3...
+            //Documentation could be better
+            int faceVertCount = shapes[shape].mesh.num_face_vertices[face];
+
+            //Vertices in given face
+            for(size_t vert = 0; vert < faceVertCount; vert++)
             {
-                //Imported as triangles, so I -think- this should always be 3...
-                //Documentation could be better
-                int faceVertCount = shapes[shape].mesh.num_face_vertices[face];
-
-                //Vertices in given face
-                for(size_t vert = 0; vert < faceVertCount; vert++)
-                {
-                    tinyobj::index_t i = shapes[shape].mesh.indices[index_offset + vert];
-                    float vx = attrib.vertices[3*i.vertex_index+0];
-                    float vy = attrib.vertices[3*i.vertex_index+1];
-                    float vz = attrib.vertices[3*i.vertex_index+2];
-                    float nx = attrib.normals[3*i.normal_index+0];
-                    float ny = attrib.normals[3*i.normal_index+1];
-                    float nz = attrib.normals[3*i.normal_index+2];
-                    float tx = attrib.texcoords[2*i.texcoord_index+0];
-                    float ty = attrib.texcoords[2*i.texcoord_index+1];
-                    OBJVertices.push_back({{vx, vy, vz}, {nx, ny, nz}, {tx, ty}});
-                }
-                index_offset += faceVertCount;
+                tinyobj::index_t i = shapes[shape].mesh.indices[index_offset + vert];
+                float vx = attrib.vertices[3*i.vertex_index+0];
+                float vy = attrib.vertices[3*i.vertex_index+1];
+                float vz = attrib.vertices[3*i.vertex_index+2];
+                float nx = attrib.normals[3*i.normal_index+0];
+                float ny = attrib.normals[3*i.normal_index+1];
+                float nz = attrib.normals[3*i.normal_index+2];
+                float tx = attrib.texcoords[2*i.texcoord_index+0];
+                float ty = attrib.texcoords[2*i.texcoord_index+1];
+                OBJVertices.push_back({{vx, vy, vz}, {nx, ny, nz}, {tx, ty}});
             }
+            index_offset += faceVertCount;
         }
+    }
+
+    return OBJVertices;
+}
+
+class OBJMesh :public Mesh
+{
+public:
+    /* Constructor */
+    OBJMesh(const GLchar* objPath, const GLchar* texturePath, GLfloat colour[3])
+    {
+        r = colour[0];
+        g = colour[1];
+        b = colour[2];
+
+        std::vector<Vertex> OBJVertices = LoadOBJVertices(objPath);
 
         vertexCount = OBJVertices.size();
 
-        glGenVertexArrays(1, &this->VAO);
-        glGenBuffers(1, &this->VBO);
+        this->vertexArray = gpuResources.Create(GPU_VERTEX_ARRAY);
+        this->vertexBuffer = gpuResources.Create(GPU_BUFFER);
 
         //Set up the vertex buffers
-        glBindVertexArray(this->VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+        glBindVertexArray(gpuResources.Get(this->vertexArray));
+        glBindBuffer(GL_ARRAY_BUFFER, gpuResources.Get(this->vertexBuffer));
         glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(struct Vertex), &OBJVertices[0], GL_STATIC_DRAW);
+        gpuResources.SetBytes(this->vertexBuffer, vertexCount * sizeof(struct Vertex));
+        perfStats.AddBufferUpload(vertexCount * sizeof(struct Vertex), true);
 
         //Set the vertex attrib pointers
         //Vertex positions
@@ -89,64 +150,136 @@ public:
 
         glBindVertexArray(0);
 
-        //Generate the texture
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-
-        //Set the wrapping style to repeat (This is on by default, but the code is here for completeness)
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-        //Set the texture filtering to nearest (again, only for completeness as it is the default)
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-        //Load in the texture
-        int width, height, n;
-        unsigned char* image = stbi_load(texturePath, &width, &height, &n, 3);
-        if(image != NULL)
+        //Streamed unless it's going to be bindless (see TextureStreaming.h), otherwise baked and compressed if there's
+        //a .ktx2 for it. No texture at all if it fails, so it's drawn without a texture fetch
+        texture = 0;
+        textureBytes = 0;
+        textureHandle = 0;
+        streamedTexture = -1;
+        if(streamFileTextures && !bindlessTextures.Available())
         {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-            glGenerateMipmap(GL_TEXTURE_2D);
-            std::cout << "Loaded texture at: " << texturePath << std::endl;
-            std::cout << "Image stats: " << width << ", " << height << ", " << n << std::endl;
-            std::cout << "First four bytes: " << (int)image[0] << ", " << (int)image[1] << ", " << (int)image[2] << ", " << (int)image[3] << std::endl;
+            streamedTexture = textureStreamer.AddFile(texturePath);
         }
         else
         {
-            std::cout << "Failed to load texture at: " << texturePath << std::endl;
+            texture = LoadTextureFile(texturePath, &textureBytes);
+            textureResource = gpuResources.Adopt(GPU_TEXTURE, texture, textureBytes);
+            textureHandle = bindlessTextures.Handle(texture);
+        }
+
+        //Build the LOD chain, carrying on simplifying from the previous level each time
+        MeshSimplifier simplifier(OBJVertices);
+        int triangleCount = vertexCount / 3;
+        for(int level = 0; level < OBJ_LOD_LEVELS; level++)
+        {
+            simplifier.Simplify(triangleCount / 2);
+            if(simplifier.TriangleCount() >= triangleCount)
+                break; //Can't get any simpler without tearing it
+            triangleCount = simplifier.TriangleCount();
+
+            std::vector<struct Vertex> triangles = simplifier.GetTriangles();
+            TriangleMesh* lod = (streamedTexture >= 0) ? new TriangleMesh(&triangles[0], (int)triangles.size(), streamedTexture, colour)
+                                                       : new TriangleMesh(triangles, texture, colour);
+            AddLOD(lod, (float)simplifier.Error());
+            std::cout << "LOD " << level + 1 << " of " << objPath << ": " << triangleCount << " triangles, error " << simplifier.Error() << std::endl;
         }
-        //Clean-up
-        stbi_image_free(image);
-        glBindTexture(GL_TEXTURE_2D, 0);
     }
 
     void Draw(Shader shader)
     {
-        GLint colourLocation = glGetUniformLocation(shader.getShaderProgram(), "baseColour");
-        glUniform4f(colourLocation, r, g, b, 1.0f);
+        //Colour, transform and lighting are all in the uniform buffers already (see GraphicsObject::SetUp), and so is a bindless texture
+        if(GetTextureHandle() == 0)
+        {
+            //A streamed texture's storage is remade as its detail changes, so it's looked up every time
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, streamedTexture >= 0 ? textureStreamer.GetTexture(streamedTexture) : texture);
+            glUniform1i(glGetUniformLocation(shader.getShaderProgram(), "ourTexture"), 0);
+            //The texture unit, texture binding and sampler uniform
+            perfStats.AddStateChanges(3);
+        }
 
-        //Lighting colour
-        GLint lightColourLocation = glGetUniformLocation(shader.getShaderProgram(), "lightColour");
-        glUniform4f(lightColourLocation, LIGHT_COLOUR.x, LIGHT_COLOUR.y, LIGHT_COLOUR.z, 1.0f);
-        //Lighting position
-        GLint lightPositionLocation = glGetUniformLocation(shader.getShaderProgram(), "lightPos");
-        glUniform3f(lightPositionLocation, LIGHT_POS.x, LIGHT_POS.y, LIGHT_POS.z);
+		glBindVertexArray(gpuResources.Get(this->vertexArray));
+        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+        glBindVertexArray(0);
+
+        //The VAO
+        perfStats.AddStateChanges(1);
+        perfStats.AddDraw(GL_TRIANGLES, vertexCount);
+    }
 
-        GLint viewPosLocation = glGetUniformLocation(shader.getShaderProgram(), "viewPos");
-        glUniform3f(viewPosLocation, camera.GetCameraPosition().x, camera.GetCameraPosition().y, camera.GetCameraPosition().z);
+    glm::vec4 GetColour() const
+    {
+        return glm::vec4(r, g, b, 1.0f);
+    }
 
-        glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glUniform1i(glGetUniformLocation(shader.getShaderProgram(), "ourTexture"), 0);
+    GLuint64 GetTextureHandle() const
+    {
+        return bindlessTextures.enabled ? textureHandle : 0;
+    }
 
-		glBindVertexArray(this->VAO);
-        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+    int GetStreamedTexture() const
+    {
+        return streamedTexture;
+    }
+
+    unsigned GetShaderFeatures(unsigned wanted) const
+    {
+        unsigned unavailable = SHADER_MESH_FEATURES | (texture == 0 && streamedTexture < 0 ? SHADER_TEXTURED : 0);
+        unsigned features = wanted & ~unavailable;
+        return features | ((features & SHADER_TEXTURED) && GetTextureHandle() != 0 ? SHADER_BINDLESS : 0);
+    }
+
+    void DrawVertices(Shader shader)
+    {
+        glBindVertexArray(gpuResources.Get(this->vertexArray));
+        glDrawArrays(GL_POINTS, 0, vertexCount);
         glBindVertexArray(0);
+
+        perfStats.AddStateChanges(1);
+        perfStats.AddDraw(GL_POINTS, vertexCount);
+    }
+
+    void ReadVertices(std::vector<struct Vertex>& vertices)
+    {
+        vertices.resize(vertexCount);
+        if(vertexCount == 0)
+            return;
+        glBindBuffer(GL_ARRAY_BUFFER, gpuResources.Get(this->vertexBuffer));
+        glGetBufferSubData(GL_ARRAY_BUFFER, 0, vertexCount * sizeof(struct Vertex), &vertices[0]);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    /* Give back the GL objects, and the LOD meshes made from this one (which share its texture). Releasing twice does nothing */
+    void Release()
+    {
+        if(vertexArray.IsNull())
+            return;
+
+        for(size_t i = 0; i < lods.size(); i++)
+        {
+            static_cast<TriangleMesh*>(lods[i].mesh)->Release();
+            delete lods[i].mesh;
+        }
+        lods.clear();
+
+        gpuResources.Destroy(this->vertexArray);
+        gpuResources.Destroy(this->vertexBuffer);
+        perfStats.ReleaseBuffer(vertexCount * sizeof(struct Vertex));
+        if(texture != 0)
+        {
+            bindlessTextures.Release(texture);
+            gpuResources.Destroy(this->textureResource);
+            perfStats.ReleaseTexture(textureBytes);
+        }
+        texture = 0;
     }
 
 private:
-    GLuint VAO, VBO, texture;
+    GPUHandle vertexArray, vertexBuffer, textureResource;
+    GLuint texture;
+    long textureBytes;
+    GLuint64 textureHandle; //0 without bindless textures
+    int streamedTexture;    //Its id in the TextureStreamer instead of texture, -1 if it isn't streamed
     int vertexCount;
     GLfloat r,g,b;
     glm::vec3 fragmentColour;
@@ -0,0 +1,174 @@
+#ifndef PERFORMANCE_STATS_H
+#define PERFORMANCE_STATS_H
+
+#include <stdio.h>
+#include <string.h>
+
+#include <GL/glew.h>
+
+#include "ImGUI/imgui.h"
+
+/* Number of frames kept for each graph */
+const int PERF_HISTORY_LENGTH = 300;
+
+/*
+ * Fixed-size ring of per-frame samples.
+ * All storage is inline, so pushing a sample never allocates.
+ */
+class PerfHistory
+{
+public:
+    float samples[PERF_HISTORY_LENGTH];
+    int next; //Index of the oldest sample, which is also the next one to be overwritten
+
+    PerfHistory() : next(0)
+    {
+        memset(samples, 0, sizeof(samples));
+    }
+
+    void Push(float value)
+    {
+        samples[next] = value;
+        next = (next + 1) % PERF_HISTORY_LENGTH;
+    }
+
+    float Latest() const
+    {
+        return samples[(next + PERF_HISTORY_LENGTH - 1) % PERF_HISTORY_LENGTH];
+    }
+
+    float Max() const
+    {
+        float highest = samples[0];
+        for(int i = 1; i < PERF_HISTORY_LENGTH; i++)
+            if(samples[i] > highest) highest = samples[i];
+        return highest;
+    }
+
+    float Average() const
+    {
+        float total = 0.0f;
+        for(int i = 0; i < PERF_HISTORY_LENGTH; i++)
+            total += samples[i];
+        return total / PERF_HISTORY_LENGTH;
+    }
+
+    /* Plot the ring oldest-first, with the latest value and average as the overlay */
+    void Plot(const char* label, const char* format, float scale = 1.0f) const
+    {
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), format, Latest() * scale, Average() * scale);
+        ImGui::PlotLines(label, samples, PERF_HISTORY_LENGTH, next, overlay, 0.0f, Max() * 1.1f + 1e-6f, ImVec2(0, 40));
+    }
+};
+
+/*
+ * Counters for the frame currently being rendered, plus a history of previous frames.
+ * The Draw functions of the meshes and objects bump the counters, and the main loop
+ * closes each frame with EndFrame().
+ */
+class PerformanceStats
+{
+public:
+    /* Per-frame counters, reset by EndFrame() */
+    int drawCalls;
+    long triangles;
+    int stateChanges;
+    int bufferUploads;
+    long bufferUploadBytes;
+
+    /* Running totals of memory handed to the GL */
+    long textureMemory;
+    long bufferMemory;
+
+    PerfHistory frameTimeHistory;
+    PerfHistory drawCallHistory;
+    PerfHistory triangleHistory;
+    PerfHistory stateChangeHistory;
+    PerfHistory bufferUploadHistory;
+    PerfHistory textureMemoryHistory;
+
+    PerformanceStats() : drawCalls(0), triangles(0), stateChanges(0), bufferUploads(0), bufferUploadBytes(0), textureMemory(0), bufferMemory(0)
+    {
+    }
+
+    /* Record a draw call of vertexCount vertices in the given primitive mode */
+    void AddDraw(GLenum mode, int vertexCount)
+    {
+        drawCalls++;
+        if(mode == GL_TRIANGLES)
+            triangles += vertexCount / 3;
+    }
+
+    /* Uniform updates, texture binds and VAO binds all count as a state change */
+    void AddStateChanges(int count)
+    {
+        stateChanges += count;
+    }
+
+    /* Record data sent with glBufferData/glBufferSubData. New allocations also count towards buffer memory */
+    void AddBufferUpload(long bytes, bool newAllocation)
+    {
+        bufferUploads++;
+        bufferUploadBytes += bytes;
+        if(newAllocation)
+            bufferMemory += bytes;
+    }
+
+    /* Record a texture allocation, optionally with a full mip chain (an extra third). Returns the bytes counted */
+    long AddTexture(int width, int height, int bytesPerPixel, bool mipmapped)
+    {
+        long bytes = (long)width * height * bytesPerPixel;
+        if(mipmapped)
+            bytes += bytes / 3;
+        textureMemory += bytes;
+        return bytes;
+    }
+
+    /* Record buffers and textures being deleted again */
+    void ReleaseBuffer(long bytes)
+    {
+        bufferMemory -= bytes;
+    }
+
+    void ReleaseTexture(long bytes)
+    {
+        textureMemory -= bytes;
+    }
+
+    /* Push this frame's counters into the history and reset them for the next frame */
+    void EndFrame(float frameTime)
+    {
+        frameTimeHistory.Push(frameTime);
+        drawCallHistory.Push((float)drawCalls);
+        triangleHistory.Push((float)triangles);
+        stateChangeHistory.Push((float)stateChanges);
+        bufferUploadHistory.Push((float)bufferUploads);
+        textureMemoryHistory.Push((float)textureMemory);
+
+        drawCalls = 0;
+        triangles = 0;
+        stateChanges = 0;
+        bufferUploads = 0;
+        bufferUploadBytes = 0;
+    }
+
+    /* Show the graphs inside whichever ImGui window is currently open */
+    void DrawPanel()
+    {
+        if(!ImGui::CollapsingHeader("Performance"))
+            return;
+
+        frameTimeHistory.Plot("Frame", "%.2f ms (avg %.2f)", 1000.0f);
+        drawCallHistory.Plot("Draws", "%.0f (avg %.0f)");
+        triangleHistory.Plot("Tris", "%.0f (avg %.0f)");
+        stateChangeHistory.Plot("State", "%.0f (avg %.0f)");
+        bufferUploadHistory.Plot("Uploads", "%.0f (avg %.1f)");
+        textureMemoryHistory.Plot("Tex mem", "%.2f MB (avg %.2f)", 1.0f / (1024.0f * 1024.0f));
+        ImGui::Text("Buffer memory: %.2f MB", bufferMemory / (1024.0f * 1024.0f));
+    }
+};
+
+PerformanceStats perfStats;
+
+#endif // PERFORMANCE_STATS_H
@@ -3,18 +3,24 @@
 
 #include "Introduction.h"
 
-const std::vector<struct Vertex> GetPlaneGeometry()
+/* A 1x1 square in the XY plane facing +Z, laid out by the compiler. Size it with GraphicsObject::scale */
+constexpr struct Vertex PLANE_VERTICES[] =
 {
-    const std::vector<struct Vertex> vertices = {
-		{{-0.5f, -0.5f, 0.0f},  {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}}, // Bottom left
-		{{0.5f, -0.5f, 0.0f},   {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f}},  // Bottom Right
-		{{-0.5f, 0.5f, 0.0f},   {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},  // Top Left
-		{{0.5f, 0.5f, 0.0f},    {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},	// Top right
-		{{-0.5f, 0.5f, 0.0f},   {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},  // Top Left
-		{{0.5f, -0.5f, 0.0f},   {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f}}  // Bottom Right
-	};
+    {{-0.5f, -0.5f, 0.0f},  {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}}, // Bottom left
+    {{0.5f, -0.5f, 0.0f},   {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f}},  // Bottom Right
+    {{-0.5f, 0.5f, 0.0f},   {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},  // Top Left
+    {{0.5f, 0.5f, 0.0f},    {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},	// Top right
+    {{-0.5f, 0.5f, 0.0f},   {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},  // Top Left
+    {{0.5f, -0.5f, 0.0f},   {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f}}  // Bottom Right
+};
+
+const int PLANE_VERTEX_COUNT = sizeof(PLANE_VERTICES) / sizeof(PLANE_VERTICES[0]);
+
+static_assert(PLANE_VERTEX_COUNT == 6, "A plane is two triangles");
 
-	return vertices;
+const std::vector<struct Vertex> GetPlaneGeometry()
+{
+    return std::vector<struct Vertex>(PLANE_VERTICES, PLANE_VERTICES + PLANE_VERTEX_COUNT);
 }
 
 #endif // PLANE_H
@@ -0,0 +1,153 @@
+#ifndef POINT_LIGHTS_H
+#define POINT_LIGHTS_H
+
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include "Introduction.h"
+#include "PerformanceStats.h"
+#include "GPUResources.h"
+
+/*
+ * Point lights on top of the one at LIGHT_POS. Each has a position, a colour and a radius it fades out to nothing at,
+ * so it only lights what's near it.
+ *
+ * They live in one buffer: a count, then the lights. It's read three ways:
+ *  - as the LightUniforms block, by forward shading with SHADER_POINT_LIGHTS, which lights every fragment with
+ *    every light. Only the first MAX_UNIFORM_POINT_LIGHTS fit: 1024 lights is 32 KB of block, which fits the 64 KB
+ *    every desktop GL 4 driver allows but not the 16 KB the spec promises
+ *  - as the LightStorage shader storage block, by SHADER_CLUSTERED, which only looks at the lights in each
+ *    fragment's cluster (LightClusters.h)
+ *  - as instance attributes, a quad per light, by the deferred lighting pass (DeferredShading.h)
+ */
+
+const int MAX_POINT_LIGHTS = 16384;
+const int MAX_UNIFORM_POINT_LIGHTS = 1024;
+
+/* std140 layout of one light in LightUniforms */
+struct PointLight
+{
+    glm::vec4 positionRadius;   //xyz in the world, w where it fades out
+    glm::vec4 colour;
+};
+
+/* Where the lights start in the buffer, after the count (padded out to a vec4) */
+const GLintptr POINT_LIGHTS_OFFSET = 4 * sizeof(GLint);
+
+class PointLights
+{
+public:
+    std::vector<PointLight> lights;
+
+    PointLights() : dirty(true) {}
+
+    void Add(glm::vec3 position, float radius, glm::vec3 colour)
+    {
+        if((int)lights.size() >= MAX_POINT_LIGHTS)
+            return;
+        PointLight light = {glm::vec4(position, radius), glm::vec4(colour, 1.0f)};
+        lights.push_back(light);
+        dirty = true;
+    }
+
+    void Clear()
+    {
+        lights.clear();
+        dirty = true;
+    }
+
+    /* Replace the lights with count of them spread around a box, all the same radius, in bright colours that
+       get dimmer the more of them there are, so that a lot of overlapping ones don't wash everything out */
+    void Scatter(int count, glm::vec3 low, glm::vec3 high, float radius, unsigned seed)
+    {
+        Clear();
+        float brightness = glm::min(1.0f, 4.0f / sqrtf((float)glm::max(count, 1)));
+        unsigned state = seed * 2654435761u + 1;
+        for(int i = 0; i < count && i < MAX_POINT_LIGHTS; i++)
+        {
+            glm::vec3 position(Random(state), Random(state), Random(state));
+            glm::vec3 colour(0.3f + 0.7f * Random(state), 0.3f + 0.7f * Random(state), 0.3f + 0.7f * Random(state));
+            Add(low + (high - low) * position, radius, brightness * colour);
+        }
+    }
+
+    int Count() const
+    {
+        return (int)lights.size();
+    }
+
+    /* Copy the lights into the buffer if they've changed, and bind it to LIGHT_UNIFORMS_BINDING (and to
+       LIGHT_STORAGE_BINDING, where there are shader storage buffers) */
+    void Upload()
+    {
+        if(buffer.IsNull())
+        {
+            buffer = gpuResources.Create(GPU_BUFFER);
+            glBindBuffer(GL_UNIFORM_BUFFER, gpuResources.Get(buffer));
+            glBufferData(GL_UNIFORM_BUFFER, GetBufferBytes(), NULL, GL_DYNAMIC_DRAW);
+            gpuResources.SetBytes(buffer, GetBufferBytes());
+            perfStats.bufferMemory += GetBufferBytes();
+            dirty = true;
+        }
+        if(dirty)
+        {
+            //Only as much as there are lights, as the shaders never read past the count
+            std::vector<char> data(POINT_LIGHTS_OFFSET + lights.size() * sizeof(PointLight), 0);
+            GLint count = (GLint)lights.size();
+            memcpy(&data[0], &count, sizeof(count));
+            if(!lights.empty())
+                memcpy(&data[POINT_LIGHTS_OFFSET], &lights[0], lights.size() * sizeof(PointLight));
+
+            glBindBuffer(GL_UNIFORM_BUFFER, gpuResources.Get(buffer));
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, data.size(), &data[0]);
+            perfStats.AddBufferUpload(data.size(), false);
+            dirty = false;
+        }
+        glBindBufferRange(GL_UNIFORM_BUFFER, LIGHT_UNIFORMS_BINDING, gpuResources.Get(buffer), 0, GetUniformBlockBytes());
+        if(GLEW_ARB_shader_storage_buffer_object)
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_STORAGE_BINDING, gpuResources.Get(buffer));
+    }
+
+    /* The buffer, once Upload has made it */
+    GLuint GetBuffer() const
+    {
+        return gpuResources.Get(buffer);
+    }
+
+    static long GetBufferBytes()
+    {
+        return POINT_LIGHTS_OFFSET + MAX_POINT_LIGHTS * sizeof(PointLight);
+    }
+
+    /* The part of the buffer the LightUniforms block covers */
+    static long GetUniformBlockBytes()
+    {
+        return POINT_LIGHTS_OFFSET + MAX_UNIFORM_POINT_LIGHTS * sizeof(PointLight);
+    }
+
+    void Release()
+    {
+        if(buffer.IsNull())
+            return;
+        gpuResources.Destroy(buffer);
+        perfStats.ReleaseBuffer(GetBufferBytes());
+        dirty = true;
+    }
+
+private:
+    GPUHandle buffer;
+    bool dirty;     //Changed since they were last uploaded
+
+    /* 0 to 1, from a simple LCG so the same seed always gives the same lights */
+    static float Random(unsigned& state)
+    {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) / 16777216.0f;
+    }
+};
+
+/* The lights the scenes are lit by */
+PointLights pointLights;
+
+#endif // POINT_LIGHTS_H
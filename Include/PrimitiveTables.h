@@ -0,0 +1,119 @@
+#ifndef PRIMITIVE_TABLES_H
+#define PRIMITIVE_TABLES_H
+
+#include "Introduction.h"
+#include "UVSphereGeometry.h"
+#include "ConeGeometry.h"
+
+/*
+ * Unit spheres and cones worked out by the compiler and stored in the binary's read-only data,
+ * so the mesh cache can upload them straight from there without generating anything or touching the heap.
+ * The list is the shapes the scenes ask for plus their LOD chains; anything else is made at runtime as before.
+ * Sizes are applied with GraphicsObject::scale.
+ */
+
+template<int Segments, int Rings>
+struct SphereTable
+{
+    static constexpr int VERTEX_COUNT = SphereVertexCount(Segments, Rings);
+    struct Vertex vertices[VERTEX_COUNT];
+};
+
+template<int Segments, int Rings>
+constexpr SphereTable<Segments, Rings> MakeSphereTable()
+{
+    SphereTable<Segments, Rings> table = {};
+    BuildSpherePhong(Segments, Rings, table.vertices);
+    return table;
+}
+
+template<int Segments>
+struct ConeTable
+{
+    static constexpr int VERTEX_COUNT = ConeVertexCount(Segments);
+    struct Vertex vertices[VERTEX_COUNT];
+};
+
+template<int Segments>
+constexpr ConeTable<Segments> MakeConeTable(double heightOverRadius)
+{
+    ConeTable<Segments> table = {};
+    BuildConePhong(Segments, heightOverRadius, table.vertices);
+    return table;
+}
+
+//Solar system, asteroids and the sphere in the first scene, with their LOD chains
+constexpr SphereTable<30, 10> SPHERE_30_10 = MakeSphereTable<30, 10>();
+constexpr SphereTable<20, 20> SPHERE_20_20 = MakeSphereTable<20, 20>();
+constexpr SphereTable<15, 5> SPHERE_15_5 = MakeSphereTable<15, 5>();
+constexpr SphereTable<10, 10> SPHERE_10_10 = MakeSphereTable<10, 10>();
+constexpr SphereTable<8, 8> SPHERE_8_8 = MakeSphereTable<8, 8>();
+constexpr SphereTable<7, 3> SPHERE_7_3 = MakeSphereTable<7, 3>();
+constexpr SphereTable<6, 5> SPHERE_6_5 = MakeSphereTable<6, 5>();
+constexpr SphereTable<6, 4> SPHERE_6_4 = MakeSphereTable<6, 4>();
+constexpr SphereTable<6, 3> SPHERE_6_3 = MakeSphereTable<6, 3>();
+constexpr SphereTable<5, 5> SPHERE_5_5 = MakeSphereTable<5, 5>();
+constexpr SphereTable<5, 3> SPHERE_5_3 = MakeSphereTable<5, 3>();
+//Sphere field
+constexpr SphereTable<24, 12> SPHERE_24_12 = MakeSphereTable<24, 12>();
+constexpr SphereTable<12, 6> SPHERE_12_6 = MakeSphereTable<12, 6>();
+
+//The cone thing that follows the small planet round the solar system, twice as tall as it is wide
+constexpr double CONE_TABLE_HEIGHT = 2.0;
+constexpr ConeTable<10> CONE_10 = MakeConeTable<10>(CONE_TABLE_HEIGHT);
+constexpr ConeTable<5> CONE_5 = MakeConeTable<5>(CONE_TABLE_HEIGHT);
+constexpr ConeTable<4> CONE_4 = MakeConeTable<4>(CONE_TABLE_HEIGHT);
+
+static_assert(SphereTable<6, 3>::VERTEX_COUNT == 6 * 3 * 2 + 6 * 6, "Two caps and one band of quads");
+static_assert(SphereTable<30, 10>::VERTEX_COUNT == 30 * 3 * 2 + 30 * 6 * 8, "Two caps and eight bands of quads");
+static_assert(sizeof(SPHERE_24_12.vertices) == SphereVertexCount(24, 12) * sizeof(struct Vertex), "Sphere tables hold nothing but vertices");
+static_assert(ConeTable<10>::VERTEX_COUNT == 10 * 3 * 2, "A triangle per segment on the side and on the base");
+static_assert(SPHERE_6_3.vertices[0].position[1] == 1.0, "Spheres start at the north pole");
+static_assert(CONE_4.vertices[1].position[1] == CONE_TABLE_HEIGHT / 2, "Cones have their tip at +height/2");
+
+/* A table and the shape it was made for */
+struct PrimitiveTable
+{
+    int segments;
+    int rings;      //0 for cones
+    double shape;   //Cone height / radius. 0 for spheres
+    const struct Vertex* vertices;
+    int vertexCount;
+};
+
+#define SPHERE_TABLE_ENTRY(s, r) {s, r, 0.0, SPHERE_##s##_##r.vertices, SphereTable<s, r>::VERTEX_COUNT}
+#define CONE_TABLE_ENTRY(s) {s, 0, CONE_TABLE_HEIGHT, CONE_##s.vertices, ConeTable<s>::VERTEX_COUNT}
+
+constexpr PrimitiveTable PRIMITIVE_TABLES[] =
+{
+    SPHERE_TABLE_ENTRY(30, 10), SPHERE_TABLE_ENTRY(20, 20), SPHERE_TABLE_ENTRY(15, 5), SPHERE_TABLE_ENTRY(10, 10),
+    SPHERE_TABLE_ENTRY(8, 8), SPHERE_TABLE_ENTRY(7, 3), SPHERE_TABLE_ENTRY(6, 5), SPHERE_TABLE_ENTRY(6, 4),
+    SPHERE_TABLE_ENTRY(6, 3), SPHERE_TABLE_ENTRY(5, 5), SPHERE_TABLE_ENTRY(5, 3), SPHERE_TABLE_ENTRY(24, 12),
+    SPHERE_TABLE_ENTRY(12, 6),
+    CONE_TABLE_ENTRY(10), CONE_TABLE_ENTRY(5), CONE_TABLE_ENTRY(4)
+};
+
+#undef SPHERE_TABLE_ENTRY
+#undef CONE_TABLE_ENTRY
+
+const int PRIMITIVE_TABLE_COUNT = sizeof(PRIMITIVE_TABLES) / sizeof(PRIMITIVE_TABLES[0]);
+
+/* The baked unit sphere with these segments and rings, or NULL if it has to be generated */
+const PrimitiveTable* FindSphereTable(int segments, int rings)
+{
+    for(int t = 0; t < PRIMITIVE_TABLE_COUNT; t++)
+        if(PRIMITIVE_TABLES[t].rings == rings && PRIMITIVE_TABLES[t].segments == segments && PRIMITIVE_TABLES[t].shape == 0.0)
+            return &PRIMITIVE_TABLES[t];
+    return NULL;
+}
+
+/* The baked cone with a base of radius 1, or NULL if it has to be generated */
+const PrimitiveTable* FindConeTable(int segments, double heightOverRadius)
+{
+    for(int t = 0; t < PRIMITIVE_TABLE_COUNT; t++)
+        if(PRIMITIVE_TABLES[t].rings == 0 && PRIMITIVE_TABLES[t].segments == segments && PRIMITIVE_TABLES[t].shape == heightOverRadius)
+            return &PRIMITIVE_TABLES[t];
+    return NULL;
+}
+
+#endif // PRIMITIVE_TABLES_H
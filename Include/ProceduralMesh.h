@@ -0,0 +1,175 @@
+#ifndef PROCEDURAL_MESH_H
+#define PROCEDURAL_MESH_H
+
+#include <vector>
+#include <algorithm>
+
+#include "Mesh.h"
+#include "UVSphereGeometry.h"
+#include "ConeGeometry.h"
+#include "GPUResources.h"
+
+/*
+ * Spheres and cones that are made by the vertex shader (Shaders/Object.vert, with SHADER_PROCEDURAL) instead of being
+ * uploaded. There is no vertex buffer at all: each instance is two vec4s saying where it is, its radius and
+ * how many segments and rings it has, and the shader works each vertex out from gl_VertexID.
+ * That makes every instance free to have its own resolution, which would cost a mesh each on the CPU side.
+ *
+ * The vertices cost some trig in the shader every frame in exchange, so this is for lots of different
+ * shapes, or very detailed ones, rather than a replacement for the mesh cache.
+ */
+
+/* One sphere or cone, in world space (the model matrix of the object drawing the batch still applies) */
+struct ProceduralShape
+{
+    GLfloat centre[3];
+    GLfloat radius;
+    GLfloat segments;
+    GLfloat rings;
+    GLfloat heightOverRadius;   //0 for a sphere
+    GLfloat padding;
+
+    static ProceduralShape Sphere(glm::vec3 centre, float radius, int segments, int rings)
+    {
+        //Same minimums as GetSpherePhong
+        ProceduralShape shape = {{centre.x, centre.y, centre.z}, radius, (GLfloat)std::max(segments, 3), (GLfloat)std::max(rings, 3), 0.0f, 0.0f};
+        return shape;
+    }
+
+    static ProceduralShape Cone(glm::vec3 centre, float radius, int segments, float heightOverRadius)
+    {
+        ProceduralShape shape = {{centre.x, centre.y, centre.z}, radius, (GLfloat)std::max(segments, 3), 0.0f, heightOverRadius, 0.0f};
+        return shape;
+    }
+
+    /* Vertices the shader is run for, the same as the CPU generators would make */
+    int VertexCount() const
+    {
+        if(heightOverRadius > 0.0f)
+            return ConeVertexCount((int)segments);
+        return SphereVertexCount((int)segments, (int)rings);
+    }
+};
+
+class ProceduralShapes: public Mesh
+{
+public:
+    /* Constructor. All of the shapes are drawn in the one colour */
+    ProceduralShapes(const std::vector<ProceduralShape>& shapes, GLfloat colour[3])
+    {
+        r = colour[0];
+        g = colour[1];
+        b = colour[2];
+        totalVertices = 0;
+
+        //Instances with the same vertex count go next to each other, so each count is one instanced draw
+        std::vector<ProceduralShape> sorted(shapes);
+        std::stable_sort(sorted.begin(), sorted.end(), [](const ProceduralShape& a, const ProceduralShape& b)
+        {
+            return a.VertexCount() < b.VertexCount();
+        });
+        for(size_t i = 0; i < sorted.size(); i++)
+        {
+            int count = sorted[i].VertexCount();
+            if(groups.empty() || groups.back().vertexCount != count)
+            {
+                ShapeGroup group = {count, (int)i, 0};
+                groups.push_back(group);
+            }
+            groups.back().instanceCount++;
+            totalVertices += count;
+        }
+        instanceCount = (int)sorted.size();
+
+        this->vertexArray = gpuResources.Create(GPU_VERTEX_ARRAY);
+        this->instanceBuffer = gpuResources.Create(GPU_BUFFER);
+
+        glBindVertexArray(gpuResources.Get(this->vertexArray));
+        glBindBuffer(GL_ARRAY_BUFFER, gpuResources.Get(this->instanceBuffer));
+        glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(ProceduralShape), sorted.empty() ? NULL : &sorted[0], GL_STATIC_DRAW);
+        gpuResources.SetBytes(this->instanceBuffer, GetBufferBytes());
+        perfStats.AddBufferUpload(GetBufferBytes(), true);
+
+        //Per-instance attributes only. Which instance each group starts at is set in Draw
+        glVertexAttribDivisor(3, 1);
+        glEnableVertexAttribArray(3);
+        glVertexAttribDivisor(4, 1);
+        glEnableVertexAttribArray(4);
+
+        glBindVertexArray(0);
+    }
+
+    void Draw(Shader shader)
+    {
+        glBindVertexArray(gpuResources.Get(this->vertexArray));
+        glBindBuffer(GL_ARRAY_BUFFER, gpuResources.Get(this->instanceBuffer));
+        for(size_t i = 0; i < groups.size(); i++)
+        {
+            //No base instance before GL 4.2, so point the attributes at the group's first instance instead
+            GLintptr first = groups[i].firstInstance * sizeof(ProceduralShape);
+            glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(ProceduralShape), (const GLvoid*)(first + offsetof(ProceduralShape, centre)));
+            glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(ProceduralShape), (const GLvoid*)(first + offsetof(ProceduralShape, segments)));
+            glDrawArraysInstanced(GL_TRIANGLES, 0, groups[i].vertexCount, groups[i].instanceCount);
+            perfStats.AddDraw(GL_TRIANGLES, groups[i].vertexCount * groups[i].instanceCount);
+        }
+        glBindVertexArray(0);
+
+        //The VAO, then the two attribute pointers for each group
+        perfStats.AddStateChanges(1 + 2 * (int)groups.size());
+    }
+
+    glm::vec4 GetColour() const
+    {
+        return glm::vec4(r, g, b, 1.0f);
+    }
+
+    /* There's nothing to texture with, and the vertices have to come from the shader */
+    unsigned GetShaderFeatures(unsigned wanted) const
+    {
+        return (wanted & ~(SHADER_TEXTURED | SHADER_MESH_FEATURES)) | SHADER_PROCEDURAL;
+    }
+
+    void Release()
+    {
+        if(vertexArray.IsNull())
+            return;
+
+        gpuResources.Destroy(this->vertexArray);
+        gpuResources.Destroy(this->instanceBuffer);
+        perfStats.ReleaseBuffer(GetBufferBytes());
+    }
+
+    /* Bytes of instance data, the only buffer there is */
+    long GetBufferBytes() const
+    {
+        return instanceCount * sizeof(ProceduralShape);
+    }
+
+    /* Vertices the shader runs for in one Draw */
+    long GetVertexCount() const
+    {
+        return totalVertices;
+    }
+
+    int GetDrawCount() const
+    {
+        return (int)groups.size();
+    }
+
+private:
+    /* A run of instances with the same vertex count */
+    struct ShapeGroup
+    {
+        int vertexCount;
+        int firstInstance;
+        int instanceCount;
+    };
+
+    GPUHandle vertexArray, instanceBuffer;
+    int instanceCount;
+    long totalVertices;
+    std::vector<ShapeGroup> groups;
+    GLfloat r,g,b;
+};
+
+#endif // PROCEDURAL_MESH_H
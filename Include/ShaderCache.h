@@ -0,0 +1,166 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <stdio.h>
+#include <string>
+#include <iostream>
+
+#include <GL/glew.h>
+
+/*
+ * Linked programs saved to disk with glGetProgramBinary, so the next launch can skip compiling.
+ * A program is filed under a hash of its sources and the driver's vendor, renderer and version strings,
+ * so editing a shader or updating the driver just misses the cache. A driver can still refuse a binary
+ * it made itself (the format is entirely up to it), in which case the program is compiled as normal
+ * and the file written again.
+ *
+ * Files go in SHADER_CACHE_DIRECTORY, which has to exist. Delete its contents to start cold.
+ */
+
+const char* SHADER_CACHE_DIRECTORY = "shadercache/";
+
+/* Start of every cache file, before the driver's own binary */
+struct ShaderCacheHeader
+{
+    char magic[4];          //"GLPB"
+    GLuint version;         //SHADER_CACHE_VERSION, in case this header changes
+    unsigned long long key; //Sources and driver hash, again, to catch a file renamed by hand
+    GLenum format;          //As given by glGetProgramBinary
+    GLint length;           //Bytes of binary after the header
+};
+
+const GLuint SHADER_CACHE_VERSION = 1;
+
+class ShaderCache
+{
+public:
+    bool enabled;   //Turn off to always compile, e.g. to time a cold start
+    int hits;       //Programs loaded from the cache
+    int misses;     //Programs that had to be compiled
+
+    ShaderCache() : enabled(true), hits(0), misses(0), driverHash(0), checkedDriver(false), supported(false) {}
+
+    /* Whether the cache can be used at all, which needs a GL context */
+    bool Available()
+    {
+        if(!checkedDriver)
+        {
+            checkedDriver = true;
+            GLint formats = 0;
+            if(GLEW_ARB_get_program_binary)
+                glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            supported = formats > 0;
+
+            //Anything that would change what the driver makes of the same source
+            driverHash = Hash(FNV_OFFSET, "GL");
+            GLenum strings[3] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+            for(int s = 0; s < 3; s++)
+            {
+                const GLubyte* text = glGetString(strings[s]);
+                driverHash = Hash(driverHash, text != NULL ? (const char*)text : "");
+            }
+        }
+        return enabled && supported;
+    }
+
+    /* The name a program with these stages (NULL for ones it doesn't have) is cached under */
+    unsigned long long Key(const std::string* sources[], int stageCount)
+    {
+        Available();
+        unsigned long long key = driverHash;
+        for(int s = 0; s < stageCount; s++)
+            key = Hash(key, sources[s] != NULL ? sources[s]->c_str() : "(none)");
+        return key;
+    }
+
+    /* Fill in the (created, not yet linked) program from the cache. False if there's no usable binary for it */
+    bool Load(GLuint program, unsigned long long key)
+    {
+        if(!Available())
+            return false;
+
+        std::string path = FilePath(key);
+        FILE* file = fopen(path.c_str(), "rb");
+        if(file == NULL)
+            return false;
+
+        ShaderCacheHeader header;
+        bool loaded = false;
+        if(fread(&header, sizeof(header), 1, file) == 1 && std::string(header.magic, 4) == "GLPB" &&
+           header.version == SHADER_CACHE_VERSION && header.key == key && header.length > 0)
+        {
+            std::string binary(header.length, '\0');
+            if(fread(&binary[0], 1, header.length, file) == (size_t)header.length)
+            {
+                glProgramBinary(program, header.format, binary.data(), header.length);
+                GLint success;
+                glGetProgramiv(program, GL_LINK_STATUS, &success);
+                loaded = (success == GL_TRUE);
+                if(!loaded)
+                    std::cout << "Cached shader program " << path << " was rejected by the driver, compiling instead" << std::endl;
+            }
+        }
+        fclose(file);
+
+        if(loaded)
+            hits++;
+        return loaded;
+    }
+
+    /* Write a program that has just been linked (with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set) to the cache */
+    void Save(GLuint program, unsigned long long key)
+    {
+        misses++;
+        if(!Available())
+            return;
+
+        ShaderCacheHeader header = {{'G', 'L', 'P', 'B'}, SHADER_CACHE_VERSION, key, 0, 0};
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &header.length);
+        if(header.length <= 0)
+            return;
+        std::string binary(header.length, '\0');
+        glGetProgramBinary(program, header.length, NULL, &header.format, &binary[0]);
+
+        std::string path = FilePath(key);
+        FILE* file = fopen(path.c_str(), "wb");
+        if(file == NULL)
+        {
+            std::cout << "Couldn't write shader cache file " << path << std::endl;
+            return;
+        }
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(binary.data(), 1, header.length, file);
+        fclose(file);
+    }
+
+private:
+    static const unsigned long long FNV_OFFSET = 14695981039346656037ULL;
+    static const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+    unsigned long long driverHash;
+    bool checkedDriver;
+    bool supported;
+
+    /* 64 bit FNV-1a, including the terminating zero so "ab" + "c" and "a" + "bc" differ */
+    static unsigned long long Hash(unsigned long long hash, const char* text)
+    {
+        do
+        {
+            hash ^= (unsigned char)*text;
+            hash *= FNV_PRIME;
+        } while(*text++ != '\0');
+        return hash;
+    }
+
+    static std::string FilePath(unsigned long long key)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", key);
+        return std::string(SHADER_CACHE_DIRECTORY) + name;
+    }
+};
+
+/* Shared by every Shader */
+ShaderCache shaderCache;
+
+#endif // SHADER_CACHE_H
@@ -14,98 +14,287 @@
 
 #include <GL/glew.h>
 
+#include "ShaderCache.h"
+#include "AssetPack.h"
+#include "GPUResources.h"
+
+/* Where the shared uniform blocks (see UniformBuffers.h) are bound. GLSL 4.0 can't say so itself, so every program is told when it's linked */
+const GLuint FRAME_UNIFORMS_BINDING = 0;
+const GLuint OBJECT_UNIFORMS_BINDING = 1;
+const GLuint LIGHT_UNIFORMS_BINDING = 2;
+
+/* The same for the shader storage blocks, which have bindings of their own (see LightClusters.h) */
+const GLuint LIGHT_STORAGE_BINDING = 0;
+const GLuint CLUSTER_STORAGE_BINDING = 1;
+const GLuint CLUSTER_INDEX_STORAGE_BINDING = 2;
+
+/* Texture unit the ourTextures array sampler reads from, set when each program is linked. Unit 0 is left for ourTexture */
+const GLint TEXTURE_ARRAY_UNIT = 1;
+
+/* Stages a program can have, in the order Shader keeps them */
+const int SHADER_STAGES = 3;
+
+/* What a permutation of the object shaders (Shaders/Object.vert and .frag) does. Each bit becomes a #define */
+enum ShaderFeature
+{
+    SHADER_TEXTURED = 1,        //Multiply the colour by ourTexture
+    SHADER_LIT = 2,             //Phong lighting from FrameUniforms
+    SHADER_PROCEDURAL = 4,      //No vertex attributes, the shape comes from the instance (ProceduralMesh.h)
+    SHADER_TEXTURE_ARRAY = 8,   //With TEXTURED, sample a layer of ourTextures instead (TextureArrays.h)
+    SHADER_INSTANCED = 16,      //A model matrix and texture layer per instance, inside the object's (InstancedMesh.h)
+    SHADER_BINDLESS = 32,       //With TEXTURED, sample the bindless handle in ObjectUniforms instead (BindlessTextures.h)
+    SHADER_POINT_LIGHTS = 64,   //With LIT, add every light in LightUniforms as well (PointLights.h)
+    SHADER_GBUFFER = 128,       //With LIT, write the surface and normal to the G-buffer instead of lighting it (DeferredShading.h)
+    SHADER_CLUSTERED = 256      //With LIT, add the point lights in the fragment's cluster, from storage buffers (LightClusters.h)
+};
+
+const char* SHADER_FEATURE_NAMES[] = {"TEXTURED", "LIT", "PROCEDURAL", "TEXTURE_ARRAY", "INSTANCED", "BINDLESS", "POINT_LIGHTS", "GBUFFER", "CLUSTERED"};
+const int SHADER_FEATURE_COUNT = 9;
+
+/* Features that come from how a mesh is stored rather than how it's asked to look, so only the mesh sets them */
+const unsigned SHADER_MESH_FEATURES = SHADER_PROCEDURAL | SHADER_TEXTURE_ARRAY | SHADER_INSTANCED | SHADER_BINDLESS;
+
+/* The program last bound by Shader::Use, so that a redundant glUseProgram can be skipped */
+GLuint shaderInUse = 0;
+
 class Shader
 {
 	public:
-		GLuint ProgramID;
 		/* Constructor does all of the work */
 		Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
 		{
-			std::string vertexCode;
-			std::string fragmentCode;
-			std::ifstream vShaderFile;
-			std::ifstream fShaderFile;
+			Begin(vertexPath, NULL, fragmentPath, "");
+			Finish();
+		}
+
+		/* Constructor for a program with a geometry shader between the vertex and fragment shaders */
+		Shader(const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath)
+		{
+			Begin(vertexPath, geometryPath, fragmentPath, "");
+			Finish();
+		}
+
+		/*
+		 * Constructor that can leave the driver compiling and linking in the background (see ShaderManager),
+		 * in which case nothing about the program is asked until Finish. geometryPath can be NULL.
+		 * defines are extra lines (e.g. "#define FOO\n") put just after each stage's #version line.
+		 */
+		Shader(const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath, const std::string& defines, bool waitForLink)
+		{
+			Begin(vertexPath, geometryPath, fragmentPath, defines);
+			if(waitForLink)
+				Finish();
+		}
+
+		void Use()
+		{
+			GLuint programID = getShaderProgram();
+			glUseProgram(programID);
+			shaderInUse = programID;
+		}
+
+		/* The #defines for a set of ShaderFeature bits, for the constructor that takes them */
+		static std::string FeatureDefines(unsigned features)
+		{
+			std::string defines;
+			for(int f = 0; f < SHADER_FEATURE_COUNT; f++)
+				if(features & (1u << f))
+					defines += std::string("#define ") + SHADER_FEATURE_NAMES[f] + "\n";
+			return defines;
+		}
+
+		/* Looked up through the handle every time, so a copy of a released Shader gets 0 rather than a deleted (or reused) name */
+		GLuint getShaderProgram()
+		{
+			return gpuResources.Get(program);
+		}
+
+		/* Give the program back to gpuResources. Copies share the handle, so releasing any of them (or all) is fine */
+		void Release()
+		{
+			if(shaderInUse == getShaderProgram())
+				shaderInUse = 0;
+			gpuResources.Destroy(program);
+		}
+
+		/* Point a sampler at a texture unit for good. Needs the program bound before GL 4.1, so it's put back after */
+		void BindSampler(const GLchar* name, GLint unit)
+		{
+			GLuint programID = getShaderProgram();
+			GLint location = glGetUniformLocation(programID, name);
+			if(location == -1)
+				return;
+			glUseProgram(programID);
+			glUniform1i(location, unit);
+			glUseProgram(shaderInUse);
+		}
 
-			//Allow the input streams to throw exceptions
-			vShaderFile.exceptions(std::ifstream::badbit);
-			fShaderFile.exceptions(std::ifstream::badbit);
-			try
+		/* Whether Finish can go ahead without waiting for the driver. Without parallel compile there's no way to ask, so it's always true */
+		bool IsReady()
+		{
+			if(!pending || fromCache)
+				return true;
+			if(!GLEW_KHR_parallel_shader_compile && !GLEW_ARB_parallel_shader_compile)
+				return true;
+
+			GLint done = GL_FALSE;
+			glGetProgramiv(getShaderProgram(), GL_COMPLETION_STATUS_KHR, &done);
+			return done == GL_TRUE;
+		}
+
+		/* Check the compile and link (waiting for them if need be), report any errors and get the program ready to use */
+		void Finish()
+		{
+			if(!pending)
+				return;
+			pending = false;
+
+			if(!fromCache)
 			{
-				// Open files
-				vShaderFile.open(vertexPath);
-				fShaderFile.open(fragmentPath);
-				std::stringstream vShaderStream, fShaderStream;
-				// Read file's buffer contents into streams
-				vShaderStream << vShaderFile.rdbuf();
-				fShaderStream << fShaderFile.rdbuf();
-				// Close files
-				vShaderFile.close();
-				fShaderFile.close();
-				vertexCode = vShaderStream.str();
-				fragmentCode = fShaderStream.str();
+				GLint success;
+				GLchar log[512];
+				const char* names[SHADER_STAGES] = {"Vertex", "Geometry", "Fragment"};
+				for(int s = 0; s < SHADER_STAGES; s++)
+				{
+					if(stages[s] == 0)
+						continue;
+					// Print compile errors if any
+					glGetShaderiv(stages[s], GL_COMPILE_STATUS, &success);
+					if (!success)
+					{
+						glGetShaderInfoLog(stages[s], 512, NULL, log);
+						std::cout << names[s] << " shader failed to compile\n" << log << std::endl;
+					}
+				}
+
+				// Print linking errors if any
+				glGetProgramiv(getShaderProgram(), GL_LINK_STATUS, &success);
+				if (!success)
+				{
+					glGetProgramInfoLog(getShaderProgram(), 512, NULL, log);
+					std::cout << "Shader program failed to link\n" << log << std::endl;
+				}
+
+				// Delete the shaders as they're linked into our program now and no longer necessery
+				for(int s = 0; s < SHADER_STAGES; s++)
+				{
+					if(stages[s] == 0)
+						continue;
+					glDetachShader(getShaderProgram(), stages[s]);
+					glDeleteShader(stages[s]);
+					stages[s] = 0;
+				}
+
+				if(success)
+					shaderCache.Save(getShaderProgram(), cacheKey);
 			}
-			catch (std::ifstream::failure e)
+
+			// Attach whichever of the shared uniform blocks the program uses
+			BindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
+			BindUniformBlock("ObjectUniforms", OBJECT_UNIFORMS_BINDING);
+			BindUniformBlock("LightUniforms", LIGHT_UNIFORMS_BINDING);
+			if(GLEW_ARB_shader_storage_buffer_object)
 			{
-				std::cout << "Shader files not correctly read" << std::endl;
+				BindStorageBlock("LightStorage", LIGHT_STORAGE_BINDING);
+				BindStorageBlock("ClusterGrid", CLUSTER_STORAGE_BINDING);
+				BindStorageBlock("ClusterLightIndices", CLUSTER_INDEX_STORAGE_BINDING);
 			}
-			const GLchar* vShaderCode = vertexCode.c_str();
-			const GLchar* fShaderCode = fragmentCode.c_str();
-
-			//Set up the shader program
-			GLuint vertex, fragment;
-			GLint success;
-			GLchar log[512];
-
-			// Vertex Shader
-			vertex = glCreateShader(GL_VERTEX_SHADER);
-			glShaderSource(vertex, 1, &vShaderCode, NULL);
-			glCompileShader(vertex);
-			// Print compile errors if any
-			glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-			if (!success)
-			{
-				glGetShaderInfoLog(vertex, 512, NULL, log);
-				std::cout << "Vertex shader failed to compile\n" << log << std::endl;
-			};
-
-			// Fragment Shader
-			fragment = glCreateShader(GL_FRAGMENT_SHADER);
-			glShaderSource(fragment, 1, &fShaderCode, NULL);
-			glCompileShader(fragment);
-			// Print compile errors if any
-			glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-			if (!success)
+			BindSampler("ourTextures", TEXTURE_ARRAY_UNIT);
+		}
+
+	private:
+		GPUHandle program;
+		bool pending;       //Started but not yet Finished
+		bool fromCache;     //Loaded by the program binary cache, so there's nothing to check
+		GLuint stages[SHADER_STAGES];
+		unsigned long long cacheKey;
+
+		/* Read the sources, then load the program from the cache or start compiling and linking it */
+		void Begin(const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath, const std::string& defines)
+		{
+			const GLchar* paths[SHADER_STAGES] = {vertexPath, geometryPath, fragmentPath};
+			const GLenum types[SHADER_STAGES] = {GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER};
+			std::string codes[SHADER_STAGES];
+			const std::string* sources[SHADER_STAGES];
+			for(int s = 0; s < SHADER_STAGES; s++)
 			{
-				glGetShaderInfoLog(fragment, 512, NULL, log);
-				std::cout << "Fragment shader failed to compile\n" << log << std::endl;
+				stages[s] = 0;
+				sources[s] = NULL;
+				if(paths[s] == NULL)
+					continue;
+				codes[s] = AddDefines(ReadSource(paths[s]), defines);
+				sources[s] = &codes[s];
 			}
+			pending = true;
+
+			// Shader Program, straight from the cache if it's been built before with this driver
+			program = gpuResources.Create(GPU_PROGRAM);
+			cacheKey = shaderCache.Key(sources, SHADER_STAGES);
+			fromCache = shaderCache.Load(getShaderProgram(), cacheKey);
+			if(fromCache)
+				return;
 
-			// Shader Program
-			this->ProgramID = glCreateProgram();
-			glAttachShader(this->ProgramID, vertex);
-			glAttachShader(this->ProgramID, fragment);
-			glLinkProgram(this->ProgramID);
-			// Print linking errors if any
-			glGetProgramiv(this->ProgramID, GL_LINK_STATUS, &success);
-			if (!success)
+			//Set up the shader program. The driver can get on with these while we do other things
+			for(int s = 0; s < SHADER_STAGES; s++)
 			{
-				glGetProgramInfoLog(this->ProgramID, 512, NULL, log);
-				std::cout << "Shader program failed to link\n" << log << std::endl;
+				if(sources[s] == NULL)
+					continue;
+				stages[s] = CompileShader(types[s], codes[s]);
+				glAttachShader(getShaderProgram(), stages[s]);
 			}
+			// Ask the driver to keep the binary around for the cache
+			if(GLEW_ARB_get_program_binary)
+				glProgramParameteri(getShaderProgram(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			glLinkProgram(getShaderProgram());
+		}
 
-			// Delete the shaders as they're linked into our program now and no longer necessery
-			glDeleteShader(vertex);
-			glDeleteShader(fragment);
+		void BindUniformBlock(const GLchar* name, GLuint binding)
+		{
+			GLuint index = glGetUniformBlockIndex(getShaderProgram(), name);
+			if(index != GL_INVALID_INDEX)
+				glUniformBlockBinding(getShaderProgram(), index, binding);
 		}
 
-		void Use()
+		void BindStorageBlock(const GLchar* name, GLuint binding)
 		{
-			glUseProgram(this->ProgramID);
+			GLuint index = glGetProgramResourceIndex(getShaderProgram(), GL_SHADER_STORAGE_BLOCK, name);
+			if(index != GL_INVALID_INDEX)
+				glShaderStorageBlockBinding(getShaderProgram(), index, binding);
 		}
 
-		GLuint getShaderProgram()
+		/* A stage's source, from the asset pack or the loose file */
+		static std::string ReadSource(const GLchar* path)
+		{
+			Asset source;
+			if(!LoadAsset(path, source))
+			{
+				std::cout << "Shader files not correctly read" << std::endl;
+				return std::string();
+			}
+			return std::string((const char*)source.data, source.size);
+		}
+
+		/* GLSL wants #version before anything else, so the defines go on the line after it */
+		static std::string AddDefines(const std::string& code, const std::string& defines)
 		{
-			return this->ProgramID;
+			if(defines.empty())
+				return code;
+			size_t version = code.find("#version");
+			size_t lineEnd = (version == std::string::npos) ? std::string::npos : code.find('\n', version);
+			if(lineEnd == std::string::npos)
+				return defines + code;
+			return code.substr(0, lineEnd + 1) + defines + code.substr(lineEnd + 1);
+		}
+
+		/* Start compiling one stage. Errors are reported by Finish */
+		static GLuint CompileShader(GLenum type, const std::string& code)
+		{
+			const GLchar* shaderCode = code.c_str();
+
+			GLuint shader = glCreateShader(type);
+			glShaderSource(shader, 1, &shaderCode, NULL);
+			glCompileShader(shader);
+			return shader;
 		}
 };
 
@@ -0,0 +1,160 @@
+#ifndef SHADER_MANAGER_H
+#define SHADER_MANAGER_H
+
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "Introduction.h"
+
+/*
+ * Starts every program compiling at once and only waits for one when it's first asked for.
+ * Without anything to wait on, the driver can get on with compiling (on its own threads, with
+ * KHR_parallel_shader_compile) while the program loads meshes and textures.
+ * Add returns a handle, and Get turns it into a finished Shader.
+ */
+class ShaderManager
+{
+public:
+    ShaderManager() : parallel(false), threadsSet(false) {}
+
+    /* Start a program compiling (or loading from the cache). geometryPath can be NULL */
+    int Add(const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath, const std::string& defines = "")
+    {
+        if(!threadsSet)
+        {
+            //Let the driver use as many threads as it likes
+            threadsSet = true;
+            parallel = GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+            if(GLEW_KHR_parallel_shader_compile)
+                glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+            else if(GLEW_ARB_parallel_shader_compile)
+                glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        }
+
+        Clock::time_point added = Clock::now();
+        ManagedShader entry = {Shader(vertexPath, geometryPath, fragmentPath, defines, false), std::string(), added, 0.0, 0.0, false};
+        entry.submitSeconds = SecondsSince(added);
+        entry.name = std::string(fragmentPath) + " + " + vertexPath;
+        if(geometryPath != NULL)
+            entry.name += std::string(" + ") + geometryPath;
+        if(!defines.empty())
+            entry.name += " (" + std::to_string(std::count(defines.begin(), defines.end(), '\n')) + " defines)";
+        entries.push_back(entry);
+        return (int)entries.size() - 1;
+    }
+
+    /* The program, waiting for it to finish if it hasn't yet */
+    Shader Get(int handle)
+    {
+        Poll();
+        ManagedShader& entry = entries[handle];
+        if(!entry.finished)
+            Finish(entry);
+        return entry.shader;
+    }
+
+    /* Finish any programs the driver has done with, without waiting for the rest. Only useful with parallel compile */
+    void Poll()
+    {
+        if(!parallel)
+            return;
+        for(size_t i = 0; i < entries.size(); i++)
+            if(!entries[i].finished && entries[i].shader.IsReady())
+                Finish(entries[i]);
+    }
+
+    /* Wait for everything */
+    void FinishAll()
+    {
+        Poll();
+        for(size_t i = 0; i < entries.size(); i++)
+            if(!entries[i].finished)
+                Finish(entries[i]);
+    }
+
+    bool ParallelCompile() const
+    {
+        return parallel;
+    }
+
+    int Count() const
+    {
+        return (int)entries.size();
+    }
+
+    /* Longest time any one program took from Add to being ready */
+    double SlowestSeconds() const
+    {
+        double slowest = 0.0;
+        for(size_t i = 0; i < entries.size(); i++)
+            if(entries[i].finished && entries[i].readySeconds > slowest)
+                slowest = entries[i].readySeconds;
+        return slowest;
+    }
+
+    /* How long each program took to submit and to be ready, to the console */
+    void PrintTimes() const
+    {
+        std::cout << "Shader programs (" << (parallel ? "parallel compile" : "no parallel compile") << "):" << std::endl;
+        for(size_t i = 0; i < entries.size(); i++)
+        {
+            char line[64];
+            if(entries[i].finished)
+                snprintf(line, sizeof(line), "  %7.2f ms to submit, ready after %7.2f ms: ", entries[i].submitSeconds * 1000.0, entries[i].readySeconds * 1000.0);
+            else
+                snprintf(line, sizeof(line), "  %7.2f ms to submit, not asked for yet: ", entries[i].submitSeconds * 1000.0);
+            std::cout << line << entries[i].name << std::endl;
+        }
+    }
+
+    /* Delete every program. Shaders from Get are copies, so they go too */
+    void Release()
+    {
+        for(size_t i = 0; i < entries.size(); i++)
+        {
+            Finish(entries[i]);
+            entries[i].shader.Release();
+        }
+        entries.clear();
+    }
+
+private:
+    typedef std::chrono::high_resolution_clock Clock;
+
+    struct ManagedShader
+    {
+        Shader shader;
+        std::string name;
+        Clock::time_point added;
+        double submitSeconds;   //Reading the sources and handing them to the driver
+        double readySeconds;    //From Add until it was known to be compiled and linked
+        bool finished;
+    };
+
+    std::vector<ManagedShader> entries;
+    bool parallel;
+    bool threadsSet;
+
+    void Finish(ManagedShader& entry)
+    {
+        if(entry.finished)
+            return;
+        entry.shader.Finish();
+        entry.readySeconds = SecondsSince(entry.added);
+        entry.finished = true;
+    }
+
+    static double SecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+};
+
+/* The demo's programs */
+ShaderManager shaderManager;
+
+#endif // SHADER_MANAGER_H
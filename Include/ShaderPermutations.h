@@ -0,0 +1,79 @@
+#ifndef SHADER_PERMUTATIONS_H
+#define SHADER_PERMUTATIONS_H
+
+#include <map>
+#include <string>
+
+#include "Introduction.h"
+#include "ShaderManager.h"
+
+/*
+ * Every permutation of one set of shader files, each made by adding the #defines for its ShaderFeature bits.
+ * A permutation is compiled the first time it's asked for (or started early with Prepare), goes through the
+ * ShaderManager and so the binary cache like any other program, and is kept for next time.
+ */
+class ShaderPermutations
+{
+public:
+    ShaderPermutations(const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath, ShaderManager& programs = shaderManager)
+        : vertex(vertexPath), geometry(geometryPath), fragment(fragmentPath), manager(programs) {}
+
+    /* Start a permutation compiling in the background, if it hasn't been already */
+    void Prepare(unsigned features)
+    {
+        if(handles.find(features) == handles.end())
+            handles[features] = manager.Add(vertex, geometry, fragment, Shader::FeatureDefines(features));
+    }
+
+    /* The permutation with exactly these features, compiling it now if it has to */
+    Shader Get(unsigned features)
+    {
+        Prepare(features);
+        return manager.Get(handles[features]);
+    }
+
+    /* Get the permutation and make it the current program, unless it already is */
+    Shader Use(unsigned features)
+    {
+        Shader shader = Get(features);
+        if(shaderInUse != shader.getShaderProgram())
+        {
+            shader.Use();
+            perfStats.AddStateChanges(1);
+        }
+        return shader;
+    }
+
+    /* Permutations made so far */
+    int Count() const
+    {
+        return (int)handles.size();
+    }
+
+    /* A name for the features, e.g. "TEXTURED + LIT", for reports */
+    static std::string FeatureNames(unsigned features)
+    {
+        std::string names;
+        for(int f = 0; f < SHADER_FEATURE_COUNT; f++)
+        {
+            if(!(features & (1u << f)))
+                continue;
+            if(!names.empty())
+                names += " + ";
+            names += SHADER_FEATURE_NAMES[f];
+        }
+        return names.empty() ? std::string("none") : names;
+    }
+
+private:
+    const GLchar* vertex;
+    const GLchar* geometry;
+    const GLchar* fragment;
+    ShaderManager& manager;
+    std::map<unsigned, int> handles;    //Features to ShaderManager handle
+};
+
+/* Shaders/Object.vert and .frag, which everything but the debug lines is drawn with */
+ShaderPermutations objectShaders("Shaders/Object.vert", NULL, "Shaders/Object.frag");
+
+#endif // SHADER_PERMUTATIONS_H
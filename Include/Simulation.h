@@ -0,0 +1,146 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <math.h>
+#include <vector>
+
+#include "Introduction.h"
+#include "GraphicsObject.h"
+#include <glm/gtc/quaternion.hpp>
+
+/* Position and orientation of an object at one simulation step */
+struct Transform
+{
+    glm::vec3 position;
+    glm::quat rotation;
+
+    glm::mat4 GetMatrix() const
+    {
+        return glm::translate(glm::mat4(), position) * glm::mat4_cast(rotation);
+    }
+};
+
+/* Blend between two simulation steps. alpha = 0 gives a, alpha = 1 gives b */
+Transform InterpolateTransforms(const Transform& a, const Transform& b, float alpha)
+{
+    Transform result;
+    result.position = glm::mix(a.position, b.position, alpha);
+    result.rotation = glm::slerp(a.rotation, b.rotation, alpha);
+    return result;
+}
+
+/*
+ * Accumulates real frame time and hands it out in fixed-size simulation steps.
+ * Usage, once per rendered frame:
+ *     clock.Accumulate(frameTime);
+ *     while(clock.Step()) { previous = current; update(current, clock.time); }
+ *     render(interpolate(previous, current, clock.Alpha()));
+ */
+class FixedTimestep
+{
+public:
+    double step;            //Length of one simulation step, in seconds
+    double time;            //Simulation time reached by the latest step
+    double timeScale;       //Simulated seconds per real second. > 1 runs faster than real time
+    int maxStepsPerFrame;   //Steps allowed per frame at a time scale of 1, so a slow frame can't snowball
+    int stepsThisFrame;
+
+    FixedTimestep(double stepLength) : step(stepLength), time(0.0), timeScale(1.0), maxStepsPerFrame(10), stepsThisFrame(0), accumulator(0.0)
+    {
+    }
+
+    void Accumulate(double frameTime)
+    {
+        accumulator += frameTime * timeScale;
+        stepsThisFrame = 0;
+    }
+
+    /* Consume one step of accumulated time. Returns false once there isn't a whole step left */
+    bool Step()
+    {
+        int stepLimit = maxStepsPerFrame * (int)ceil(timeScale > 1.0 ? timeScale : 1.0);
+        if(accumulator < step)
+            return false;
+
+        if(stepsThisFrame >= stepLimit)
+        {
+            //Fallen too far behind, so drop the whole steps rather than trying to catch up
+            accumulator = fmod(accumulator, step);
+            return false;
+        }
+
+        accumulator -= step;
+        time += step;
+        stepsThisFrame++;
+        return true;
+    }
+
+    /* How far between the last two steps the current frame is */
+    float Alpha() const
+    {
+        return (float)(accumulator / step);
+    }
+
+private:
+    double accumulator;
+};
+
+/* One object to draw, with its transform already worked out */
+struct DrawItem
+{
+    GraphicsObject* object;
+    glm::mat4 model;
+};
+
+/* Sets every transform to where its object is at the given simulation time */
+typedef void (*AnimationUpdate)(double time, std::vector<Transform>& transforms);
+
+/*
+ * A set of objects moved by a fixed-step animation function.
+ * Keeps the last two steps so that frames can be drawn between them.
+ */
+class AnimatedScene
+{
+public:
+    std::vector<GraphicsObject> objects;
+    FixedTimestep clock;
+
+    AnimatedScene(const std::vector<GraphicsObject>& sceneObjects, AnimationUpdate updateFunction, double step) :
+        objects(sceneObjects), clock(step), update(updateFunction), previous(sceneObjects.size()), current(sceneObjects.size())
+    {
+        update(clock.time, current);
+        previous = current;
+    }
+
+    /* Run as many steps as the elapsed time covers. Returns the number of steps taken */
+    int Advance(double frameTime, double timeScale)
+    {
+        clock.timeScale = timeScale;
+        clock.Accumulate(frameTime);
+        while(clock.Step())
+        {
+            previous.swap(current);
+            update(clock.time, current);
+        }
+        return clock.stepsThisFrame;
+    }
+
+    /* Interpolated model matrices for drawing the current frame */
+    void BuildDrawList(std::vector<DrawItem>& drawList)
+    {
+        float alpha = clock.Alpha();
+        drawList.resize(objects.size());
+        for(size_t i = 0; i < objects.size(); i++)
+        {
+            drawList[i].object = &objects[i];
+            drawList[i].model = glm::scale(InterpolateTransforms(previous[i], current[i], alpha).GetMatrix(), glm::vec3(objects[i].scale));
+        }
+    }
+
+private:
+    AnimationUpdate update;
+    std::vector<Transform> previous;
+    std::vector<Transform> current;
+};
+
+#endif // SIMULATION_H
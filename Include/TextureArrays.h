@@ -0,0 +1,242 @@
+#ifndef TEXTURE_ARRAYS_H
+#define TEXTURE_ARRAYS_H
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+#include "Introduction.h"
+#include "PerformanceStats.h"
+#include "TextureLoader.h"
+
+/*
+ * Textures of the same size and format packed into the layers of shared GL_TEXTURE_2D_ARRAYs.
+ * Meshes textured from one draw with SHADER_TEXTURE_ARRAY and say which layer in ObjectUniforms (or per instance,
+ * see InstancedMesh.h), so the array only has to be bound when the next mesh is in a different one,
+ * and a single instanced draw can give every instance its own texture.
+ *
+ * Layers are filled on texture unit 0 and drawn from TEXTURE_ARRAY_UNIT, so filling one never disturbs what's bound.
+ *
+ * Each array has a fixed number of layers, allocated up front with every mip level: as many as fit in
+ * TEXTURE_ARRAY_BYTES, but no more than TEXTURE_ARRAY_LAYERS. Once it's full another is made.
+ */
+
+/* Most layers in one array */
+const int TEXTURE_ARRAY_LAYERS = 256;
+
+/* Roughly how much memory to give each array, which decides the layers of big textures */
+const long TEXTURE_ARRAY_BYTES = 16 * 1024 * 1024;
+
+/* Where a texture ended up. An array of 0 means it couldn't be loaded */
+struct TextureSlot
+{
+    GLuint array;
+    int layer;
+};
+
+class TextureArrays
+{
+public:
+    TextureArrays() : boundArray(0), maxLayers(0) {}
+
+    /* Load an image into a layer, from its baked .ktx2 if there is one (see TextureLoader.h) */
+    TextureSlot Add(const GLchar* path)
+    {
+        TextureSlot slot = {0, 0};
+        KTX2Texture baked;
+        if(useBakedTextures && ReadKTX2(BakedTexturePath(path), baked) && BlockFormatSupported(baked.format))
+        {
+            slot = Add(baked);
+        }
+        else
+        {
+            Asset file;
+            int width, height, n;
+            unsigned char* pixels = NULL;
+            if(LoadAsset(path, file))
+                pixels = stbi_load_from_memory(file.data, (int)file.size, &width, &height, &n, 4);
+            if(pixels != NULL)
+            {
+                RGBAImage image;
+                image.width = width;
+                image.height = height;
+                image.pixels.assign(pixels, pixels + width * height * 4);
+                stbi_image_free(pixels);
+                slot = Add(image);
+            }
+        }
+
+        if(slot.array != 0)
+            std::cout << "Loaded texture at: " << path << " into layer " << slot.layer << " of texture array " << slot.array << std::endl;
+        else
+            std::cout << "Failed to load texture at: " << path << std::endl;
+        return slot;
+    }
+
+    /* Put an image in a layer of an RGB array, with its mipmaps made here as there's no glGenerateMipmap for one layer */
+    TextureSlot Add(const RGBAImage& image)
+    {
+        std::vector<RGBAImage> levels = BuildMipChain(image);
+        TextureArray& array = FindSpace(image.width, image.height, GL_RGB8, (int)levels.size());
+        TextureSlot slot = {array.texture, array.used++};
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+        for(size_t l = 0; l < levels.size(); l++)
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)l, 0, 0, slot.layer, levels[l].width, levels[l].height, 1,
+                            GL_RGBA, GL_UNSIGNED_BYTE, levels[l].pixels.data());
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        return slot;
+    }
+
+    /* Put a baked texture in a layer of an array of its format. The driver has to support the format */
+    TextureSlot Add(const KTX2Texture& baked)
+    {
+        TextureArray& array = FindSpace(baked.width, baked.height, BLOCK_FORMAT_GL[baked.format], (int)baked.levels.size());
+        TextureSlot slot = {array.texture, array.used++};
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+        for(size_t l = 0; l < baked.levels.size(); l++)
+        {
+            int width = std::max(baked.width >> l, 1), height = std::max(baked.height >> l, 1);
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)l, 0, 0, slot.layer, width, height, 1,
+                                      BLOCK_FORMAT_GL[baked.format], (GLsizei)baked.levels[l].size(), baked.levels[l].data());
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        return slot;
+    }
+
+    /* Bind an array for drawing, unless it already is */
+    void Bind(GLuint array)
+    {
+        if(array == boundArray)
+            return;
+        glActiveTexture(GL_TEXTURE0 + TEXTURE_ARRAY_UNIT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+        glActiveTexture(GL_TEXTURE0);
+        boundArray = array;
+        perfStats.AddStateChanges(1);
+    }
+
+    int ArrayCount() const
+    {
+        return (int)arrays.size();
+    }
+
+    /* Layers filled so far, in every array */
+    int LayerCount() const
+    {
+        int layers = 0;
+        for(size_t a = 0; a < arrays.size(); a++)
+            layers += arrays[a].used;
+        return layers;
+    }
+
+    /* Memory allocated for every array, whether its layers are used yet or not */
+    long GetBytes() const
+    {
+        long bytes = 0;
+        for(size_t a = 0; a < arrays.size(); a++)
+            bytes += arrays[a].bytes;
+        return bytes;
+    }
+
+    /* Delete every array. Slots handed out before are no good after this */
+    void Release()
+    {
+        for(size_t a = 0; a < arrays.size(); a++)
+        {
+            glDeleteTextures(1, &arrays[a].texture);
+            perfStats.ReleaseTexture(arrays[a].bytes);
+        }
+        arrays.clear();
+        boundArray = 0;
+    }
+
+private:
+    struct TextureArray
+    {
+        GLuint texture;
+        int width;
+        int height;
+        GLenum internalFormat;
+        int levels;
+        int used;       //Layers filled, which are always the first ones
+        int capacity;
+        long bytes;
+    };
+
+    std::vector<TextureArray> arrays;
+    GLuint boundArray;
+    GLint maxLayers;
+
+    /* Bytes in one layer of an array of this size and format, with all of its levels */
+    static long LayerBytes(int width, int height, GLenum internalFormat, int levels)
+    {
+        long bytes = 0;
+        for(int l = 0; l < levels; l++)
+        {
+            int levelWidth = std::max(width >> l, 1), levelHeight = std::max(height >> l, 1);
+            if(internalFormat == GL_RGB8)
+                bytes += (long)levelWidth * levelHeight * 3;
+            for(int f = 0; f < 3; f++)
+                if(internalFormat == BLOCK_FORMAT_GL[f])
+                    bytes += CompressedSize((BlockFormat)f, levelWidth, levelHeight);
+        }
+        return bytes;
+    }
+
+    /* An array with a free layer for this kind of texture, making one if they're all full */
+    TextureArray& FindSpace(int width, int height, GLenum internalFormat, int levels)
+    {
+        for(size_t a = 0; a < arrays.size(); a++)
+        {
+            TextureArray& array = arrays[a];
+            if(array.width == width && array.height == height && array.internalFormat == internalFormat &&
+               array.levels == levels && array.used < array.capacity)
+                return array;
+        }
+
+        if(maxLayers == 0)
+            glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+        long layerBytes = LayerBytes(width, height, internalFormat, levels);
+        int capacity = (int)std::max(1L, std::min((long)std::min(TEXTURE_ARRAY_LAYERS, (int)maxLayers), TEXTURE_ARRAY_BYTES / std::max(layerBytes, 1L)));
+        TextureArray array = {0, width, height, internalFormat, levels, 0, capacity, layerBytes * capacity};
+
+        glGenTextures(1, &array.texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+        if(GLEW_ARB_texture_storage)
+        {
+            glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, internalFormat, width, height, capacity);
+        }
+        else
+        {
+            //Every level has to be specified by hand, compressed formats with the size they'll be
+            for(int l = 0; l < levels; l++)
+            {
+                int levelWidth = std::max(width >> l, 1), levelHeight = std::max(height >> l, 1);
+                if(internalFormat == GL_RGB8)
+                    glTexImage3D(GL_TEXTURE_2D_ARRAY, l, internalFormat, levelWidth, levelHeight, capacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+                else
+                    glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, l, internalFormat, levelWidth, levelHeight, capacity, 0,
+                                           (GLsizei)(LayerBytes(levelWidth, levelHeight, internalFormat, 1) * capacity), NULL);
+            }
+        }
+        //Same sampling as the single textures (see CreateMeshTexture)
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        perfStats.textureMemory += array.bytes;
+        std::cout << "Made a texture array of " << capacity << " " << width << "x" << height << " layers, " << array.bytes / 1024 << " KB" << std::endl;
+        arrays.push_back(array);
+        return arrays.back();
+    }
+};
+
+/* The demo's texture arrays */
+TextureArrays textureArrays;
+
+#endif // TEXTURE_ARRAYS_H
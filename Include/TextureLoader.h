@@ -0,0 +1,132 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <string>
+#include <iostream>
+
+#include "Introduction.h"
+#include "PerformanceStats.h"
+#include "KTX2File.h"
+
+/*
+ * Loads a texture for a mesh. If Tools/TextureBaker has left a .ktx2 next to the image (e.g. Images/thunderbird.ktx2
+ * for Images/thunderbird.png), its compressed levels go straight to the GPU with glCompressedTexImage2D: no PNG
+ * decode, no glGenerateMipmap, and a quarter to a sixth of the memory. Otherwise (or if the driver can't take the
+ * format) the image is loaded as before, as RGB with mipmaps made by the driver.
+ */
+
+/* Use baked textures when there are any. Off to compare against loading the PNGs */
+bool useBakedTextures = true;
+
+/* GL internal formats for each BlockFormat */
+const GLenum BLOCK_FORMAT_GL[] = {GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_COMPRESSED_RGBA_BPTC_UNORM};
+
+inline bool BlockFormatSupported(BlockFormat format)
+{
+    if(format == BLOCK_BC7)
+        return GLEW_ARB_texture_compression_bptc != 0;
+    return GLEW_EXT_texture_compression_s3tc != 0;
+}
+
+/* A new, bound texture with the demo's usual sampling: clamped, nearest, nearest mipmap */
+GLuint CreateMeshTexture()
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return texture;
+}
+
+/* Upload every level of a baked texture. Returns 0 if the driver doesn't support its format */
+GLuint UploadCompressedTexture(const KTX2Texture& baked, long* bytes)
+{
+    if(!BlockFormatSupported(baked.format))
+        return 0;
+
+    GLuint texture = CreateMeshTexture();
+    for(size_t l = 0; l < baked.levels.size(); l++)
+    {
+        int width = std::max(baked.width >> l, 1), height = std::max(baked.height >> l, 1);
+        glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)l, BLOCK_FORMAT_GL[baked.format], width, height, 0,
+                               (GLsizei)baked.levels[l].size(), baked.levels[l].data());
+    }
+    //Only as many levels as were baked, in case a file stops short of 1x1
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)baked.levels.size() - 1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    *bytes = baked.GetBytes();
+    perfStats.textureMemory += *bytes;
+    return texture;
+}
+
+/* Upload an image as RGB and have the driver make its mipmaps. Returns 0 if it couldn't be loaded */
+GLuint UploadImageTexture(const GLchar* path, long* bytes)
+{
+    Asset file;
+    if(!LoadAsset(path, file))
+        return 0;
+    int width, height, n;
+    unsigned char* image = stbi_load_from_memory(file.data, (int)file.size, &width, &height, &n, 3);
+    if(image == NULL)
+        return 0;
+
+    GLuint texture = CreateMeshTexture();
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    stbi_image_free(image);
+
+    *bytes = perfStats.AddTexture(width, height, 3, true);
+    std::cout << "Image stats: " << width << ", " << height << ", " << n << std::endl;
+    return texture;
+}
+
+/* Decode an image to RGBA pixels, e.g. for TextureStreamer::AddFile to make a mip chain from. False if it couldn't be loaded */
+bool LoadRGBAImage(const GLchar* path, RGBAImage& image)
+{
+    Asset file;
+    if(!LoadAsset(path, file))
+        return false;
+    int n;
+    unsigned char* pixels = stbi_load_from_memory(file.data, (int)file.size, &image.width, &image.height, &n, 4);
+    if(pixels == NULL)
+        return false;
+    image.pixels.assign(pixels, pixels + (long)image.width * image.height * 4);
+    stbi_image_free(pixels);
+    return true;
+}
+
+/* The texture for an image, baked if possible. Returns 0 (with bytes at 0) if there's neither */
+GLuint LoadTextureFile(const GLchar* path, long* bytes)
+{
+    *bytes = 0;
+    if(useBakedTextures)
+    {
+        std::string bakedPath = BakedTexturePath(path);
+        KTX2Texture baked;
+        if(ReadKTX2(bakedPath, baked))
+        {
+            GLuint texture = UploadCompressedTexture(baked, bytes);
+            if(texture != 0)
+            {
+                std::cout << "Loaded baked texture at: " << bakedPath << " (" << BLOCK_FORMAT_NAMES[baked.format] << ", "
+                          << baked.levels.size() << " levels, " << *bytes / 1024 << " KB)" << std::endl;
+                return texture;
+            }
+            std::cout << "No driver support for " << BLOCK_FORMAT_NAMES[baked.format] << " in " << bakedPath << ", using the image instead" << std::endl;
+        }
+    }
+
+    GLuint texture = UploadImageTexture(path, bytes);
+    if(texture != 0)
+        std::cout << "Loaded texture at: " << path << std::endl;
+    else
+        std::cout << "Failed to load texture at: " << path << std::endl;
+    return texture;
+}
+
+#endif // TEXTURE_LOADER_H
@@ -0,0 +1,357 @@
+#ifndef TEXTURE_STREAMING_H
+#define TEXTURE_STREAMING_H
+
+#include <math.h>
+#include <vector>
+#include <deque>
+#include <map>
+#include <string>
+#include <algorithm>
+#include <iostream>
+
+#include "Introduction.h"
+#include "PerformanceStats.h"
+#include "TextureLoader.h"
+#include "GPUResources.h"
+
+/*
+ * Textures that are only as detailed as what's using them needs, inside a memory budget.
+ *
+ * Each texture starts with just its smallest levels (STREAMING_MIN_SIZE and below). Every frame the objects drawn
+ * with it say how big it is on screen (see GraphicsObject::SetUp), and Update works out the level each texture
+ * should start at: the finest one that's still no more than a texel per pixel, then coarser, least visible textures
+ * first, until they all fit in budgetBytes. Finer levels are then uploaded a level per texture per frame, as many as
+ * uploadBytesPerFrame allows, and levels that aren't wanted any more are dropped.
+ *
+ * glTexStorage2D storage can't change size, so a texture gets new storage with just the levels it's keeping
+ * whenever its detail changes. The levels it had already are copied across on the GPU (GL_ARB_copy_image), or
+ * uploaded again without it, and the new ones are uploaded a level at a time from the source, which stays in
+ * memory like a file would on disk. Meshes ask for the current texture each time they draw.
+ *
+ * The demo's own textures (the ones TriangleMesh and OBJMesh load from a path) are streamed too, through AddFile,
+ * which keeps their sources here. Not when they're going to be bindless, though: a handle has to be made
+ * non-resident before its texture is deleted, and the streamer swaps textures whenever their detail changes, so
+ * those are still uploaded whole by LoadTextureFile. Textures in arrays (TextureArrays.h) are never streamed.
+ */
+
+/* Levels this size and smaller are always resident, so there's something to draw with from the first frame */
+const int STREAMING_MIN_SIZE = 64;
+
+/* Frames a texture keeps detail it doesn't need before dropping it, when it's not needed to fit the budget */
+const int STREAMING_EVICT_DELAY = 30;
+
+/* Stream the textures meshes load from files (when they aren't bindless). Off to upload them whole, as before */
+bool streamFileTextures = true;
+
+class TextureStreamer
+{
+public:
+    long budgetBytes;           //Most memory for the streamed textures. The smallest levels are kept whatever it is
+    long uploadBytesPerFrame;   //Most bytes uploaded per Update, so a burst of detail is spread over frames
+
+    /* Stats */
+    long residentBytes;
+    long uploadedBytes;         //Since the start
+    long uploadedThisFrame;
+    long copiedBytes;           //Moved between old and new storage on the GPU rather than uploaded again
+    int reallocations;
+
+    TextureStreamer() : budgetBytes(256L * 1024 * 1024), uploadBytesPerFrame(16L * 1024 * 1024), residentBytes(0),
+                        uploadedBytes(0), uploadedThisFrame(0), copiedBytes(0), reallocations(0) {}
+
+    /* Stream a texture from its mip chain (see BuildMipChain), uploaded as RGBA. The chain has to outlive the texture */
+    int Add(const std::vector<RGBAImage>* mips)
+    {
+        StreamedTexture texture = NewTexture((*mips)[0].width, (*mips)[0].height, (int)mips->size(), GL_RGBA8);
+        texture.mips = mips;
+        return AddTexture(texture);
+    }
+
+    /* Stream a baked texture, which the driver has to support (see BlockFormatSupported) and has to outlive the texture */
+    int Add(const KTX2Texture* baked)
+    {
+        StreamedTexture texture = NewTexture(baked->width, baked->height, (int)baked->levels.size(), BLOCK_FORMAT_GL[baked->format]);
+        texture.baked = baked;
+        return AddTexture(texture);
+    }
+
+    /* Stream an image file: baked if there's a .ktx2 for it the driver can take (as LoadTextureFile would), otherwise
+       decoded and mipmapped here. The source is kept for as long as the streamer, and a file already added gives
+       the same id again. -1 if there's neither */
+    int AddFile(const GLchar* path)
+    {
+        std::map<std::string, int>::iterator found = fileIds.find(path);
+        if(found != fileIds.end())
+            return found->second;
+
+        int id = -1;
+        if(useBakedTextures)
+        {
+            KTX2Texture baked;
+            if(ReadKTX2(BakedTexturePath(path), baked) && BlockFormatSupported(baked.format))
+            {
+                fileBaked.push_back(baked);
+                id = Add(&fileBaked.back());
+            }
+        }
+        if(id < 0)
+        {
+            RGBAImage image;
+            if(LoadRGBAImage(path, image))
+            {
+                fileChains.push_back(BuildMipChain(image));
+                id = Add(&fileChains.back());
+            }
+        }
+
+        if(id >= 0)
+            std::cout << "Streaming texture at: " << path << " (" << textures[id].width << "x" << textures[id].height << ", "
+                      << textures[id].levels - textures[id].minLevel << " levels to start with)" << std::endl;
+        else
+            std::cout << "Failed to load texture at: " << path << std::endl;
+        fileIds[path] = id;
+        return id;
+    }
+
+    /* Note that something is being drawn with a texture this frame, covering pixelsPerUnit pixels on screen for each
+       unit of its texture coordinates */
+    void Request(int id, float pixelsPerUnit)
+    {
+        textures[id].wantedPixels = std::max(textures[id].wantedPixels, pixelsPerUnit);
+    }
+
+    /* The texture to bind, which changes whenever its resident levels do */
+    GLuint GetTexture(int id) const
+    {
+        return textures[id].texture;
+    }
+
+    /* The finest level it has now, 0 being full size */
+    int GetResidentLevel(int id) const
+    {
+        return textures[id].residentLevel;
+    }
+
+    int TextureCount() const
+    {
+        return (int)textures.size();
+    }
+
+    /* Bytes every texture would take with all of its levels */
+    long GetFullBytes() const
+    {
+        long bytes = 0;
+        for(size_t t = 0; t < textures.size(); t++)
+            bytes += BytesFrom(textures[t], 0);
+        return bytes;
+    }
+
+    /* Once a frame, after everything's been drawn: pick each texture's levels from this frame's requests, then evict and upload */
+    void Update()
+    {
+        uploadedThisFrame = 0;
+        if(textures.empty())
+            return;
+
+        //Most visible first, as they get first go at the budget and the uploads
+        std::vector<int> order(textures.size());
+        for(size_t t = 0; t < textures.size(); t++)
+            order[t] = (int)t;
+        std::sort(order.begin(), order.end(), [this](int a, int b) { return textures[a].wantedPixels > textures[b].wantedPixels; });
+
+        //The smallest levels are always there, so the budget is shared out on top of them
+        long remaining = budgetBytes;
+        for(size_t t = 0; t < textures.size(); t++)
+            remaining -= BytesFrom(textures[t], textures[t].minLevel);
+        for(size_t o = 0; o < order.size(); o++)
+        {
+            StreamedTexture& texture = textures[order[o]];
+            int target = WantedLevel(texture);
+            while(target < texture.minLevel && BytesFrom(texture, target) - BytesFrom(texture, texture.minLevel) > remaining)
+                target++;
+            remaining -= BytesFrom(texture, target) - BytesFrom(texture, texture.minLevel);
+            texture.targetLevel = target;
+            texture.wantedPixels = 0.0f;
+        }
+
+        //Drop detail first, so there's room for the new. Straight away if keeping it and adding the new wouldn't fit,
+        //otherwise once it's been unneeded a while, so something going back and forth isn't uploaded over and over
+        long keptBytes = 0;
+        for(size_t t = 0; t < textures.size(); t++)
+            keptBytes += BytesFrom(textures[t], std::min(textures[t].residentLevel, textures[t].targetLevel));
+        bool overBudget = keptBytes > budgetBytes;
+        for(size_t t = 0; t < textures.size(); t++)
+        {
+            StreamedTexture& texture = textures[t];
+            texture.unneededFrames = (texture.targetLevel > texture.residentLevel) ? texture.unneededFrames + 1 : 0;
+            if(texture.targetLevel > texture.residentLevel && (overBudget || texture.unneededFrames >= STREAMING_EVICT_DELAY))
+                Reallocate(texture, texture.targetLevel);
+        }
+
+        //Then a level more for each texture that wants it, until this frame's uploads are used up
+        for(size_t o = 0; o < order.size(); o++)
+        {
+            StreamedTexture& texture = textures[order[o]];
+            if(texture.targetLevel >= texture.residentLevel)
+                continue;
+            int next = texture.residentLevel - 1;
+            long cost = GLEW_ARB_copy_image ? LevelBytes(texture, next) : BytesFrom(texture, next);
+            if(uploadedThisFrame > 0 && uploadedThisFrame + cost > uploadBytesPerFrame)
+                break;
+            Reallocate(texture, next);
+        }
+    }
+
+    /* Delete every texture. Ids handed out before are no good after this */
+    void Release()
+    {
+        for(size_t t = 0; t < textures.size(); t++)
+        {
+            gpuResources.Destroy(textures[t].resource);
+            perfStats.ReleaseTexture(textures[t].bytes);
+        }
+        textures.clear();
+        residentBytes = 0;
+        fileIds.clear();
+        fileChains.clear();
+        fileBaked.clear();
+    }
+
+private:
+    struct StreamedTexture
+    {
+        const std::vector<RGBAImage>* mips;     //Where its levels come from, one or the other
+        const KTX2Texture* baked;
+        int width;
+        int height;
+        int levels;
+        GLenum internalFormat;
+        int minLevel;           //The first of the levels that are always resident
+        int residentLevel;      //The finest level in its storage now
+        int targetLevel;        //What Update decided it should have
+        int unneededFrames;     //How long it's had finer levels than it needs
+        float wantedPixels;     //Biggest on screen it's been asked for this frame
+        GLuint texture;
+        long bytes;
+        GPUHandle resource;     //Owns texture
+    };
+
+    std::vector<StreamedTexture> textures;
+
+    //AddFile's sources, in deques so they stay put as more are added
+    std::map<std::string, int> fileIds;
+    std::deque<std::vector<RGBAImage> > fileChains;
+    std::deque<KTX2Texture> fileBaked;
+
+    static StreamedTexture NewTexture(int width, int height, int levels, GLenum internalFormat)
+    {
+        StreamedTexture texture = {NULL, NULL, width, height, levels, internalFormat, 0, 0, 0, 0, 0.0f, 0, 0, GPUHandle()};
+        while(texture.minLevel < levels - 1 && std::max(width >> texture.minLevel, height >> texture.minLevel) > STREAMING_MIN_SIZE)
+            texture.minLevel++;
+        texture.residentLevel = texture.targetLevel = levels;  //Nothing yet
+        return texture;
+    }
+
+    int AddTexture(StreamedTexture& texture)
+    {
+        Reallocate(texture, texture.minLevel);
+        textures.push_back(texture);
+        return (int)textures.size() - 1;
+    }
+
+    static long LevelBytes(const StreamedTexture& texture, int level)
+    {
+        int width = std::max(texture.width >> level, 1), height = std::max(texture.height >> level, 1);
+        if(texture.baked != NULL)
+            return CompressedSize(texture.baked->format, width, height);
+        return (long)width * height * 4;
+    }
+
+    /* Bytes for a texture starting at a level, with all the smaller ones */
+    static long BytesFrom(const StreamedTexture& texture, int level)
+    {
+        long bytes = 0;
+        for(int l = level; l < texture.levels; l++)
+            bytes += LevelBytes(texture, l);
+        return bytes;
+    }
+
+    /* The finest level that's no more than a texel per pixel where it's biggest, assuming its texture coordinates
+       go 0-1 across a unit of the mesh (as they do on the cube). The smallest ones if nothing asked for it */
+    static int WantedLevel(const StreamedTexture& texture)
+    {
+        if(texture.wantedPixels <= 0.0f)
+            return texture.minLevel;
+        float texelsPerPixel = std::max(texture.width, texture.height) / texture.wantedPixels;
+        int level = (texelsPerPixel > 1.0f) ? (int)floorf(log2f(texelsPerPixel)) : 0;
+        return std::min(level, texture.minLevel);
+    }
+
+    /* Give a texture new storage, starting at level base, with what it had copied and the rest uploaded */
+    void Reallocate(StreamedTexture& texture, int base)
+    {
+        int width = std::max(texture.width >> base, 1), height = std::max(texture.height >> base, 1);
+        int count = texture.levels - base;
+        GLuint replacement = CreateMeshTexture();
+        if(GLEW_ARB_texture_storage)
+        {
+            glTexStorage2D(GL_TEXTURE_2D, count, texture.internalFormat, width, height);
+        }
+        else
+        {
+            //Every level by hand, compressed ones with the size they'll be
+            for(int l = 0; l < count; l++)
+            {
+                int levelWidth = std::max(width >> l, 1), levelHeight = std::max(height >> l, 1);
+                if(texture.baked == NULL)
+                    glTexImage2D(GL_TEXTURE_2D, l, texture.internalFormat, levelWidth, levelHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+                else
+                    glCompressedTexImage2D(GL_TEXTURE_2D, l, texture.internalFormat, levelWidth, levelHeight, 0,
+                                           (GLsizei)LevelBytes(texture, base + l), NULL);
+            }
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, count - 1);
+
+        for(int l = base; l < texture.levels; l++)
+        {
+            int levelWidth = std::max(texture.width >> l, 1), levelHeight = std::max(texture.height >> l, 1);
+            if(texture.texture != 0 && l >= texture.residentLevel && GLEW_ARB_copy_image)
+            {
+                glCopyImageSubData(texture.texture, GL_TEXTURE_2D, l - texture.residentLevel, 0, 0, 0,
+                                   replacement, GL_TEXTURE_2D, l - base, 0, 0, 0, levelWidth, levelHeight, 1);
+                copiedBytes += LevelBytes(texture, l);
+            }
+            else
+            {
+                if(texture.baked != NULL)
+                    glCompressedTexSubImage2D(GL_TEXTURE_2D, l - base, 0, 0, levelWidth, levelHeight, texture.internalFormat,
+                                              (GLsizei)texture.baked->levels[l].size(), texture.baked->levels[l].data());
+                else
+                    glTexSubImage2D(GL_TEXTURE_2D, l - base, 0, 0, levelWidth, levelHeight, GL_RGBA, GL_UNSIGNED_BYTE,
+                                    (*texture.mips)[l].pixels.data());
+                uploadedBytes += LevelBytes(texture, l);
+                uploadedThisFrame += LevelBytes(texture, l);
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        //Things drawn this frame used the old storage, so it goes once the GPU's finished with them
+        gpuResources.Destroy(texture.resource);
+        perfStats.ReleaseTexture(texture.bytes);
+        residentBytes -= texture.bytes;
+
+        texture.texture = replacement;
+        texture.residentLevel = base;
+        texture.unneededFrames = 0;
+        texture.bytes = BytesFrom(texture, base);
+        texture.resource = gpuResources.Adopt(GPU_TEXTURE, replacement, texture.bytes);
+        perfStats.textureMemory += texture.bytes;
+        residentBytes += texture.bytes;
+        reallocations++;
+    }
+};
+
+/* The demo's streamed textures */
+TextureStreamer textureStreamer;
+
+#endif // TEXTURE_STREAMING_H
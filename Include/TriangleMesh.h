@@ -2,102 +2,252 @@
 #define TRIMESH_H
 
 #include "Mesh.h"
+#include "TextureLoader.h"
+#include "TextureArrays.h"
+#include "BindlessTextures.h"
+#include "TextureStreaming.h"
+#include "GPUResources.h"
 
 class TriangleMesh: public Mesh
 {
 public:
     /* Constructor */
-    TriangleMesh(const std::vector<struct Vertex> vertices, const GLchar* texturePath, GLfloat colour[3])
+    TriangleMesh(const std::vector<struct Vertex>& vertices, const GLchar* texturePath, GLfloat colour[3])
     {
-        vertexCount = vertices.size();
-        r = colour[0];
-        g = colour[1];
-        b = colour[2];
-
-        glGenVertexArrays(1, &this->VAO);
-        glGenBuffers(1, &this->VBO);
-
-        //Set up the vertex buffers
-        glBindVertexArray(this->VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(struct Vertex), &vertices[0], GL_STATIC_DRAW);
+        SetUp(&vertices[0], vertices.size(), NULL, 0, colour);
+        LoadTexture(texturePath);
+    }
 
-        //Set the vertex attrib pointers
-        //Vertex positions
-        glVertexAttribPointer(0, 3, GL_DOUBLE, GL_FALSE, sizeof(struct Vertex), (const GLvoid*) offsetof (struct Vertex, position));
-        glEnableVertexAttribArray(0);
-        //Vertex texture coordinates
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(struct Vertex), (const GLvoid*) offsetof (struct Vertex, textureCoords));
-        glEnableVertexAttribArray(1);
-        //Normal positions
-        glVertexAttribPointer(2, 3, GL_DOUBLE, GL_FALSE, sizeof(struct Vertex), (const GLvoid*) offsetof (struct Vertex, normal));
-        glEnableVertexAttribArray(2);
+    /* Constructor for vertices that live somewhere else, e.g. the constexpr tables */
+    TriangleMesh(const struct Vertex* vertices, int count, const GLchar* texturePath, GLfloat colour[3])
+    {
+        SetUp(vertices, count, NULL, 0, colour);
+        LoadTexture(texturePath);
+    }
 
-        glBindVertexArray(0);
+    /* Constructor for an indexed mesh, where triangles share vertices */
+    TriangleMesh(const std::vector<struct Vertex>& vertices, const std::vector<GLuint>& indices, const GLchar* texturePath, GLfloat colour[3])
+    {
+        SetUp(&vertices[0], vertices.size(), &indices[0], indices.size(), colour);
+        LoadTexture(texturePath);
+    }
 
-        //Generate the texture
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
+    /* Constructor for a mesh that draws with a texture belonging to another mesh (e.g. a lower LOD) */
+    TriangleMesh(const std::vector<struct Vertex>& vertices, GLuint sharedTexture, GLfloat colour[3])
+    {
+        SetUp(&vertices[0], vertices.size(), NULL, 0, colour);
+        ownsTexture = false;
+        texture = sharedTexture;
+        textureHandle = bindlessTextures.Handle(texture);
+    }
 
-        //Set the wrapping style to repeat (This is on by default, but the code is here for completeness)
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    /* Constructor for a mesh textured from a layer of a texture array (see TextureArrays.h), which it doesn't own */
+    TriangleMesh(const struct Vertex* vertices, int count, TextureSlot slot, GLfloat colour[3])
+    {
+        SetUp(vertices, count, NULL, 0, colour);
+        ownsTexture = false;
+        texture = 0;
+        textureArray = slot.array;
+        textureLayer = slot.layer;
+    }
 
-        //Set the texture filtering to nearest (again, only for completeness as it is the default)
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    /* Constructor for a mesh with a texture from the TextureStreamer, which it doesn't own */
+    TriangleMesh(const struct Vertex* vertices, int count, int streamedTexture, GLfloat colour[3])
+    {
+        SetUp(vertices, count, NULL, 0, colour);
+        ownsTexture = false;
+        texture = 0;
+        this->streamedTexture = streamedTexture;
+    }
 
-        //Load in the texture
-        int width, height, n;
-        unsigned char* image = stbi_load(texturePath, &width, &height, &n, 3);
-        if(image != NULL)
+    /* Draw the mesh with the supplied texture */
+    void Draw(Shader shader)
+    {
+        //Colour, transform and lighting are all in the uniform buffers already (see GraphicsObject::SetUp)
+        if(textureArray != 0)
         {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-            glGenerateMipmap(GL_TEXTURE_2D);
-            std::cout << "Loaded texture at: " << texturePath << std::endl;
-            std::cout << "Image stats: " << width << ", " << height << ", " << n << std::endl;
-            std::cout << "First four bytes: " << (int)image[0] << ", " << (int)image[1] << ", " << (int)image[2] << ", " << (int)image[3] << std::endl;
+            //The layer is in ObjectUniforms, so there's only a bind if the last mesh was in a different array
+            textureArrays.Bind(textureArray);
         }
-        else
+        else if(GetTextureHandle() == 0)
         {
-            std::cout << "Failed to load texture at: " << texturePath << std::endl;
+            //A streamed texture's storage is remade as its detail changes, so it's looked up every time
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, streamedTexture >= 0 ? textureStreamer.GetTexture(streamedTexture) : texture);
+            glUniform1i(glGetUniformLocation(shader.getShaderProgram(), "ourTexture"), 0);
+            //The texture unit, texture binding and sampler uniform
+            perfStats.AddStateChanges(3);
         }
-        //Clean-up
-        stbi_image_free(image);
-        glBindTexture(GL_TEXTURE_2D, 0);
+
+		glBindVertexArray(gpuResources.Get(this->vertexArray));
+		if(indexCount > 0)
+            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+		else
+            glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+        glBindVertexArray(0);
+
+        //The VAO
+        perfStats.AddStateChanges(1);
+        perfStats.AddDraw(GL_TRIANGLES, indexCount > 0 ? indexCount : vertexCount);
     }
 
-    /* Draw the mesh with the supplied texture */
-    void Draw(Shader shader)
+    glm::vec4 GetColour() const
     {
-        GLint colourLocation = glGetUniformLocation(shader.getShaderProgram(), "baseColour");
-        glUniform4f(colourLocation, r, g, b, 1.0f);
+        return glm::vec4(r, g, b, 1.0f);
+    }
 
-        //Lighting colour
-        GLint lightColourLocation = glGetUniformLocation(shader.getShaderProgram(), "lightColour");
-        glUniform4f(lightColourLocation, LIGHT_COLOUR.x, LIGHT_COLOUR.y, LIGHT_COLOUR.z, 1.0f);
-        //Lighting position
-        GLint lightPositionLocation = glGetUniformLocation(shader.getShaderProgram(), "lightPos");
-        glUniform3f(lightPositionLocation, LIGHT_POS.x, LIGHT_POS.y, LIGHT_POS.z);
+    int GetTextureLayer() const
+    {
+        return textureLayer;
+    }
 
-        GLint viewPosLocation = glGetUniformLocation(shader.getShaderProgram(), "viewPos");
-        glUniform3f(viewPosLocation, camera.GetCameraPosition().x, camera.GetCameraPosition().y, camera.GetCameraPosition().z);
+    GLuint64 GetTextureHandle() const
+    {
+        return bindlessTextures.enabled ? textureHandle : 0;
+    }
 
-        glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glUniform1i(glGetUniformLocation(shader.getShaderProgram(), "ourTexture"), 0);
+    int GetStreamedTexture() const
+    {
+        return streamedTexture;
+    }
+
+    unsigned GetShaderFeatures(unsigned wanted) const
+    {
+        unsigned features = wanted & ~SHADER_MESH_FEATURES;
+        if(textureArray != 0)
+            return features | ((features & SHADER_TEXTURED) ? SHADER_TEXTURE_ARRAY : 0);
+        if(texture == 0 && streamedTexture < 0)
+            return features & ~SHADER_TEXTURED;
+        return features | ((features & SHADER_TEXTURED) && GetTextureHandle() != 0 ? SHADER_BINDLESS : 0);
+    }
 
-		glBindVertexArray(this->VAO);
-        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+    void DrawVertices(Shader shader)
+    {
+        //Straight through the vertex buffer, so an indexed mesh's shared vertices come up once each
+        glBindVertexArray(gpuResources.Get(this->vertexArray));
+        glDrawArrays(GL_POINTS, 0, vertexCount);
         glBindVertexArray(0);
+
+        perfStats.AddStateChanges(1);
+        perfStats.AddDraw(GL_POINTS, vertexCount);
+    }
+
+    void ReadVertices(std::vector<struct Vertex>& vertices)
+    {
+        vertices.resize(vertexCount);
+        if(vertexCount == 0)
+            return;
+        glBindBuffer(GL_ARRAY_BUFFER, gpuResources.Get(this->vertexBuffer));
+        glGetBufferSubData(GL_ARRAY_BUFFER, 0, vertexCount * sizeof(struct Vertex), &vertices[0]);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    /* Give the GL objects back to gpuResources, which deletes them once the GPU's done with them.
+     * Not done in a destructor as the meshes in main() outlive the GL context. Releasing twice does nothing */
+    void Release()
+    {
+        if(vertexArray.IsNull())
+            return;
+
+        gpuResources.Destroy(this->vertexArray);
+        gpuResources.Destroy(this->vertexBuffer);
+        gpuResources.Destroy(this->indexBuffer);
+        perfStats.ReleaseBuffer(GetBufferBytes());
+        if(ownsTexture && texture != 0)
+        {
+            bindlessTextures.Release(texture);
+            gpuResources.Destroy(this->textureResource);
+            perfStats.ReleaseTexture(textureBytes);
+        }
+        texture = 0;
+    }
+
+    /* Bytes of vertex and index data in the buffers */
+    long GetBufferBytes() const
+    {
+        return vertexCount * sizeof(struct Vertex) + indexCount * sizeof(GLuint);
     }
 
 private:
-    GLuint VAO, VBO, texture;
+    GPUHandle vertexArray, vertexBuffer, indexBuffer;
+    GPUHandle textureResource;  //Only when it owns the texture
+    GLuint texture;
+    GLuint textureArray;    //Instead of texture, when it's textured from an array
+    int textureLayer;
+    int streamedTexture;    //Or from the TextureStreamer, -1 if not
+    GLuint64 textureHandle; //0 without bindless textures
     int vertexCount;
+    int indexCount; //0 when not indexed
+    long textureBytes;
+    bool ownsTexture;
     GLfloat r,g,b;
     glm::vec3 fragmentColour;
+
+    /* Upload the vertices (and indices, if there are any) and set up the VAO */
+    void SetUp(const struct Vertex* vertices, int count, const GLuint* indices, int indicesCount, GLfloat colour[3])
+    {
+        vertexCount = count;
+        indexCount = indicesCount;
+        textureBytes = 0;
+        textureArray = 0;
+        textureLayer = 0;
+        streamedTexture = -1;
+        textureHandle = 0;
+        r = colour[0];
+        g = colour[1];
+        b = colour[2];
+
+        this->vertexArray = gpuResources.Create(GPU_VERTEX_ARRAY);
+        this->vertexBuffer = gpuResources.Create(GPU_BUFFER);
+
+        //Set up the vertex buffers
+        glBindVertexArray(gpuResources.Get(this->vertexArray));
+        glBindBuffer(GL_ARRAY_BUFFER, gpuResources.Get(this->vertexBuffer));
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(struct Vertex), vertices, GL_STATIC_DRAW);
+        gpuResources.SetBytes(this->vertexBuffer, vertexCount * sizeof(struct Vertex));
+        perfStats.AddBufferUpload(vertexCount * sizeof(struct Vertex), true);
+
+        //The index buffer binding is part of the VAO's state
+        if(indexCount > 0)
+        {
+            this->indexBuffer = gpuResources.Create(GPU_BUFFER);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpuResources.Get(this->indexBuffer));
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(GLuint), indices, GL_STATIC_DRAW);
+            gpuResources.SetBytes(this->indexBuffer, indexCount * sizeof(GLuint));
+            perfStats.AddBufferUpload(indexCount * sizeof(GLuint), true);
+        }
+
+        //Set the vertex attrib pointers
+        //Vertex positions
+        glVertexAttribPointer(0, 3, GL_DOUBLE, GL_FALSE, sizeof(struct Vertex), (const GLvoid*) offsetof (struct Vertex, position));
+        glEnableVertexAttribArray(0);
+        //Vertex texture coordinates
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(struct Vertex), (const GLvoid*) offsetof (struct Vertex, textureCoords));
+        glEnableVertexAttribArray(1);
+        //Normal positions
+        glVertexAttribPointer(2, 3, GL_DOUBLE, GL_FALSE, sizeof(struct Vertex), (const GLvoid*) offsetof (struct Vertex, normal));
+        glEnableVertexAttribArray(2);
+
+        glBindVertexArray(0);
+    }
+
+    void LoadTexture(const GLchar* texturePath)
+    {
+        //Streamed, from just its smallest levels, unless it's going to be bindless (see TextureStreaming.h)
+        if(streamFileTextures && !bindlessTextures.Available())
+        {
+            ownsTexture = false;
+            texture = 0;
+            streamedTexture = textureStreamer.AddFile(texturePath);
+            return;
+        }
+
+        //Baked and compressed if there's a .ktx2 for it. No texture at all if it fails, so it's drawn without a texture fetch
+        ownsTexture = true;
+        texture = LoadTextureFile(texturePath, &textureBytes);
+        textureResource = gpuResources.Adopt(GPU_TEXTURE, texture, textureBytes);
+        textureHandle = bindlessTextures.Handle(texture);
+    }
 };
 
 #endif // MESH_H
-
@@ -0,0 +1,29 @@
+#ifndef TRIG_TABLES_H
+#define TRIG_TABLES_H
+
+#include <math.h>
+#include <vector>
+
+#include "Introduction.h"
+
+/*
+ * sin and cos of count evenly spaced angles, startDegrees + k * stepDegrees.
+ * The generators look these up instead of calling sin/cos for every vertex.
+ */
+struct TrigTable
+{
+    std::vector<double> sine;
+    std::vector<double> cosine;
+
+    TrigTable(int count, double startDegrees, double stepDegrees) : sine(count), cosine(count)
+    {
+        for(int k = 0; k < count; k++)
+        {
+            double angle = glm::radians(startDegrees + k * stepDegrees);
+            sine[k] = sin(angle);
+            cosine[k] = cos(angle);
+        }
+    }
+};
+
+#endif // TRIG_TABLES_H
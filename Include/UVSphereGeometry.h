@@ -2,15 +2,26 @@
 #define UV_SPHERE_H
 
 #include "Introduction.h"
+#include "TrigTables.h"
+#include "VertexKernels.h"
+#include "JobSystem.h"
+#include "ConstexprMath.h"
 #include <math.h>
 #include <iostream>
 
+/* Roughly how many vertices are worth handing to the job system as one chunk */
+const int SPHERE_VERTICES_PER_JOB = 16384;
+
 /*  Produce the vertex data for a sphere with smooth shading.
     The normal at each vertex is along the direction from the centre to the vertex.
     Segments = number of bands of quads split by lines of longitude
     Rings = number of bands of quads split by the lines of latitude
     There are (rings + 1) lines of latitude, inc the points at the top and bottom
     No generated UVs. Sorry.
+
+    Each band between two lines of latitude writes to its own part of the output,
+    so the bands are filled in parallel across the job system. Within a band, each
+    line of latitude is worked out once by the SIMD ring kernel and then interleaved.
 */
 const std::vector<struct Vertex> GetSpherePhong(int segments, int rings, double radius)
 {
@@ -18,158 +29,153 @@ const std::vector<struct Vertex> GetSpherePhong(int segments, int rings, double
     if(segments < 3) segments = 3;
     if(rings < 3) rings = 3;
 
-    std::vector<struct Vertex> vertices;
-
     double ringAngle = 180.0f / rings;
     double segmentAngle = 360.0f / segments;
 
     /*
      * NB: rn is the nth line of latitude, starting at the top
      * bn is the nth line of longitude, starting from positive X direction
-     * This notation is to save space; the parameters still define the number of
-     * quad bands in the respective direction, NOT the lines of lat/long
+     * Latitude j is at theta(j) = 90 - j * ringAngle, longitude i at phi(i) = i * segmentAngle
      */
+    TrigTable latitude(rings + 1, 90.0, -ringAngle);
+    RingTable longitude(TrigTable(segments, 0.0, segmentAngle));
 
-    //Oth line of latitude is the point on top
-    int i;
-    double theta = glm::radians(90.0 - ringAngle);
-    for(i = 0; i < segments; i++)
-    {
-        struct Vertex r0 = {{0.0, radius, 0.0},   {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}};
-
-        double phii = glm::radians(i * segmentAngle); //phi(i)
-        double r1biX = radius * cos(theta) * cos(phii);
-        double r1biY = radius * sin(theta);
-        double r1biZ = radius * cos(theta) * sin(phii);
-        glm::vec3 normali = glm::normalize(glm::vec3(r1biX, r1biY, r1biZ));
-        struct Vertex r1bi = {{r1biX, r1biY, r1biZ},    {normali.x, normali.y, normali.z},    {0.0f, 0.0f}};
-
-        double phii2 = glm::radians(((i + 1) % segments) * segmentAngle); //phi(i+1)
-        double r1bi2X = radius * cos(theta) * cos(phii2);
-        double r1bi2Y = radius * sin(theta);
-        double r1bi2Z = radius * cos(theta) * sin(phii2);
-        glm::vec3 normali2 = glm::normalize(glm::vec3(r1bi2X, r1bi2Y, r1bi2Z));
-        struct Vertex r1bi2 = {{r1bi2X, r1bi2Y, r1bi2Z},    {normali2.x, normali2.y, normali2.z},    {0.0f, 0.0f}};
-
-        vertices.push_back(r0);
-        vertices.push_back(r1bi);
-        vertices.push_back(r1bi2);
-
-        //std::cout << "RingAngle: " << ringAngle << ", SegmentAngle: " << segmentAngle << std::endl;
-        //std::cout << "r1bi:(" << r1biX << ","  << r1biY << "," << r1biZ << ")" << std::endl;
-    }
+    //One triangle per segment in each cap, two in each of the (rings - 2) middle bands
+    int capVertices = 3 * segments;
+    int bandVertices = 6 * segments;
+    std::vector<struct Vertex> vertices(2 * capVertices + (rings - 2) * bandVertices);
 
-    //Middle rings are made from quads (kinda...), so require different attention
-    for(int j = 1; j < rings - 1; j++)
+    //Band 0 is the top cap, band (rings - 1) the bottom cap, and the rest are quads
+    auto fillBands = [&](int firstBand, int endBand)
     {
-        double thetaj = glm::radians(90 - (j * ringAngle)); //theta(j)
-        double thetaj2 = glm::radians(90 - ((j + 1) * ringAngle)); //theta(j+1)
-        for(i = 0; i < segments; i++)
+        //Each line of latitude is shared by two bands, so keep the last two around
+        RingPoints ringCache[2];
+        int cachedRing[2] = {-1, -1};
+        auto getRing = [&](int j) -> const RingPoints&
+        {
+            for(int slot = 0; slot < 2; slot++)
+                if(cachedRing[slot] == j)
+                    return ringCache[slot];
+
+            int slot = cachedRing[0] < cachedRing[1] ? 0 : 1;
+            ringCache[slot].Compute(longitude, (float)(radius * latitude.cosine[j]), (float)(radius * latitude.sine[j]),
+                                    (float)latitude.cosine[j], (float)latitude.sine[j]);
+            cachedRing[slot] = j;
+            return ringCache[slot];
+        };
+
+        for(int band = firstBand; band < endBand; band++)
         {
-            double phii = glm::radians(i * segmentAngle); //phi(i)
-            double phii2 = glm::radians(((i + 1) % segments) * segmentAngle); //phi(i+1)
-
-            double rjbiX = radius * cos(thetaj) * cos(phii);
-            double rjbiY = radius * sin(thetaj);
-            double rjbiZ = radius * cos(thetaj) * sin(phii);
-            glm::vec3 normalrjbi = glm::normalize(glm::vec3(rjbiX, rjbiY, rjbiZ));
-            struct Vertex rjbi = {{rjbiX, rjbiY, rjbiZ},    {normalrjbi.x, normalrjbi.y, normalrjbi.z}, {0.0f, 0.0f}};;
-
-            double rjbi2X = radius * cos(thetaj) * cos(phii2);
-            double rjbi2Y = radius * sin(thetaj);
-            double rjbi2Z = radius * cos(thetaj) * sin(phii2);
-            glm::vec3 normalrjbi2 = glm::normalize(glm::vec3(rjbi2X, rjbi2Y, rjbi2Z));
-            struct Vertex rjbi2 = {{rjbi2X, rjbi2Y, rjbi2Z},    {normalrjbi2.x, normalrjbi2.y, normalrjbi2.z}, {0.0f, 0.0f}};;
-
-            double rj2biX = radius * cos(thetaj2) * cos(phii);
-            double rj2biY = radius * sin(thetaj2);
-            double rj2biZ = radius * cos(thetaj2) * sin(phii);
-            glm::vec3 normalrj2bi = glm::normalize(glm::vec3(rj2biX, rj2biY, rj2biZ));
-            struct Vertex rj2bi = {{rj2biX, rj2biY, rj2biZ},    {normalrj2bi.x, normalrj2bi.y, normalrj2bi.z}, {0.0f, 0.0f}};;
-
-            double rj2bi2X = radius * cos(thetaj2) * cos(phii2);
-            double rj2bi2Y = radius * sin(thetaj2);
-            double rj2bi2Z = radius * cos(thetaj2) * sin(phii2);
-            glm::vec3 normalrj2bi2 = glm::normalize(glm::vec3(rj2bi2X, rj2bi2Y, rj2bi2Z));
-            struct Vertex rj2bi2 = {{rj2bi2X, rj2bi2Y, rj2bi2Z},    {normalrj2bi2.x, normalrj2bi2.y, normalrj2bi2.z}, {0.0f, 0.0f}};;
-
-            vertices.push_back(rjbi);
-            vertices.push_back(rjbi2);
-            vertices.push_back(rj2bi);
-
-            vertices.push_back(rjbi2);
-            vertices.push_back(rj2bi2);
-            vertices.push_back(rj2bi);
-
-            //std::cout << "r" << j << "b" << i << ":(" << rjbiX << ","  << rjbiY << "," << rjbiZ << ")" << std::endl;
-            //Oh god, this is more code than I had hoped
-            //Yeah, but I am particularly verbose
+            if(band == 0)
+            {
+                struct Vertex r0 = {{0.0, radius, 0.0},   {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}};
+                const RingPoints& r1 = getRing(1);
+                struct Vertex* out = &vertices[0];
+                for(int i = 0; i < segments; i++)
+                {
+                    *out++ = r0;
+                    *out++ = r1.GetVertex(i);
+                    *out++ = r1.GetVertex(i + 1);
+                }
+            }
+            else if(band == rings - 1)
+            {
+                struct Vertex rn2 = {{0.0, -radius, 0.0},   {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f}};
+                const RingPoints& rn = getRing(rings - 1);
+                struct Vertex* out = &vertices[capVertices + (rings - 2) * bandVertices];
+                for(int i = 0; i < segments; i++)
+                {
+                    *out++ = rn2;
+                    *out++ = rn.GetVertex(i);
+                    *out++ = rn.GetVertex(i + 1);
+                }
+            }
+            else
+            {
+                const RingPoints& rj = getRing(band);
+                const RingPoints& rj2 = getRing(band + 1);
+                struct Vertex* out = &vertices[capVertices + (band - 1) * bandVertices];
+                for(int i = 0; i < segments; i++)
+                {
+                    struct Vertex rjbi = rj.GetVertex(i);
+                    struct Vertex rjbi2 = rj.GetVertex(i + 1);
+                    struct Vertex rj2bi = rj2.GetVertex(i);
+                    struct Vertex rj2bi2 = rj2.GetVertex(i + 1);
+
+                    *out++ = rjbi;
+                    *out++ = rjbi2;
+                    *out++ = rj2bi;
+
+                    *out++ = rjbi2;
+                    *out++ = rj2bi2;
+                    *out++ = rj2bi;
+                }
+            }
         }
-    }
+    };
 
-    //(rings + 1)th line of latitude is the point on bottom
-    theta = glm::radians(ringAngle - 90);
-    for(i = 0; i < segments; i++)
-    {
-        struct Vertex rn2 = {{0.0, -radius, 0.0},   {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f}};
-
-        double phii = glm::radians(i * segmentAngle); //phi(i)
-        double rnbiX = radius * cos(theta) * cos(phii);
-        double rnbiY = radius * sin(theta);
-        double rnbiZ = radius * cos(theta) * sin(phii);
-        glm::vec3 normali = glm::normalize(glm::vec3(rnbiX, rnbiY, rnbiZ));
-        struct Vertex rnbi = {{rnbiX, rnbiY, rnbiZ},    {normali.x, normali.y, normali.z},    {0.0f, 0.0f}};
-
-        double phii2 = glm::radians(((i + 1) % segments) * segmentAngle); //phi(i+1)
-        double rnbi2X = radius * cos(theta) * cos(phii2);
-        double rnbi2Y = radius * sin(theta);
-        double rnbi2Z = radius * cos(theta) * sin(phii2);
-        glm::vec3 normali2 = glm::normalize(glm::vec3(rnbi2X, rnbi2Y, rnbi2Z));
-        struct Vertex rnbi2 = {{rnbi2X, rnbi2Y, rnbi2Z},    {normali2.x, normali2.y, normali2.z},    {0.0f, 0.0f}};
-
-        vertices.push_back(rn2);
-        vertices.push_back(rnbi);
-        vertices.push_back(rnbi2);
-    }
+    int bandsPerJob = SPHERE_VERTICES_PER_JOB / bandVertices;
+    jobSystem.ParallelFor(rings, bandsPerJob > 1 ? bandsPerJob : 1, fillBands);
 
     return vertices;
 }
 
-const std::vector<struct Vertex> GetSphereNormalLines(int segments, int rings, double radius, float normalLength)
+/* Vertices GetSpherePhong makes: one triangle per segment in each cap, two in each middle band */
+constexpr int SphereVertexCount(int segments, int rings)
 {
-    /* Minimum of 3 segments and 3 rings */
-    if(segments < 3) segments = 3;
-    if(rings < 3) rings = 3;
+    return 6 * segments * (rings - 1);
+}
 
-    std::vector<struct Vertex> vertices;
+/* Point i on line of latitude j of a unit sphere, where the normal is the position */
+constexpr struct Vertex SphereRingVertex(int segments, int rings, int j, int i)
+{
+    double theta = (90.0 - j * 180.0 / rings) * CONSTEXPR_PI / 180.0;
+    double phi = (i % segments) * 2.0 * CONSTEXPR_PI / segments;
+    double x = ConstexprCos(theta) * ConstexprCos(phi);
+    double y = ConstexprSin(theta);
+    double z = ConstexprCos(theta) * ConstexprSin(phi);
+    struct Vertex v = {{x, y, z}, {x, y, z}, {0.0f, 0.0f}};
+    return v;
+}
 
-    double ringAngle = 180.0f / rings;
-    double segmentAngle = 360.0f / segments;
+/*
+ * GetSpherePhong at radius 1, in the same order, but simple enough for the compiler to run.
+ * It works in double precision all the way through, so it is slightly more accurate than the
+ * float ring kernels. Used for the tables in PrimitiveTables.h
+ */
+constexpr void BuildSpherePhong(int segments, int rings, struct Vertex* out)
+{
+    struct Vertex top = {{0.0, 1.0, 0.0}, {0.0, 1.0, 0.0}, {0.0f, 0.0f}};
+    struct Vertex bottom = {{0.0, -1.0, 0.0}, {0.0, -1.0, 0.0}, {0.0f, 0.0f}};
+    int v = 0;
 
-    //Top point
-    vertices.push_back({{0.0, radius, 0.0},   {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}});
-    vertices.push_back({{0.0, radius + normalLength, 0.0},   {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}});
-    //Rings
-    for(int j = 1; j < rings; j++)
+    for(int i = 0; i < segments; i++)
+    {
+        out[v++] = top;
+        out[v++] = SphereRingVertex(segments, rings, 1, i);
+        out[v++] = SphereRingVertex(segments, rings, 1, i + 1);
+    }
+
+    for(int j = 1; j < rings - 1; j++)
     {
-        double theta = glm::radians(90 - (j * ringAngle)); //theta(j)
         for(int i = 0; i < segments; i++)
         {
-            double phi = glm::radians(i * segmentAngle); //phi(i)
-
-            glm::vec3 point = glm::vec3(radius * cos(theta) * cos(phi), radius * sin(theta), radius * cos(theta) * sin(phi));
-            glm::vec3 normal = glm::normalize(point);
-            glm::vec3 normalend = point + normal * normalLength;
+            out[v++] = SphereRingVertex(segments, rings, j, i);
+            out[v++] = SphereRingVertex(segments, rings, j, i + 1);
+            out[v++] = SphereRingVertex(segments, rings, j + 1, i);
 
-            vertices.push_back({{point.x, point.y, point.z},    {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}});
-            vertices.push_back({{normalend.x, normalend.y, normalend.z},    {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}});
+            out[v++] = SphereRingVertex(segments, rings, j, i + 1);
+            out[v++] = SphereRingVertex(segments, rings, j + 1, i + 1);
+            out[v++] = SphereRingVertex(segments, rings, j + 1, i);
         }
     }
-    //Bottom point
-    vertices.push_back({{0.0, -radius, 0.0},   {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}});
-    vertices.push_back({{0.0, -radius - normalLength, 0.0},   {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}});
 
-    return vertices;
+    for(int i = 0; i < segments; i++)
+    {
+        out[v++] = bottom;
+        out[v++] = SphereRingVertex(segments, rings, rings - 1, i);
+        out[v++] = SphereRingVertex(segments, rings, rings - 1, i + 1);
+    }
 }
 
 #endif // UV_SPHERE_H
@@ -0,0 +1,219 @@
+#ifndef UNIFORM_BUFFERS_H
+#define UNIFORM_BUFFERS_H
+
+#include <string.h>
+#include <vector>
+
+#include "Introduction.h"
+#include "PerformanceStats.h"
+
+/*
+ * Uniform blocks for everything the object shaders read, instead of a glUniform call per value per draw.
+ * FrameUniforms (light and camera) is written once a frame, ObjectUniforms (matrices and colour) once per draw,
+ * and each draw just points binding OBJECT_UNIFORMS_BINDING at its own slot with glBindBufferRange.
+ *
+ * All of the slots live in one buffer that stays mapped (GL 4.4 / ARB_buffer_storage), split into a region per
+ * frame in flight and guarded by fences like DebugDraw's. A slot is never written twice while the GPU might
+ * still be reading it: every write takes the next slot, and a region that fills up mid-frame just moves on to the
+ * next one early. Without buffer storage each slot is copied in with glBufferSubData instead.
+ */
+
+/* Frames of uniforms the buffer holds at once */
+const int UNIFORM_BUFFER_REGIONS = 3;
+
+/* Slots in each region, for the shared uniformBuffers. The sphere field and asteroid belt are under 6000 draws */
+const int UNIFORM_BUFFER_SLOTS = 16384;
+
+/* std140 layout of the FrameUniforms block. The vec3s in the shader are padded out to 16 bytes anyway */
+struct FrameUniformData
+{
+    glm::vec4 lightColour;
+    glm::vec4 lightPos;
+    glm::vec4 viewPos;
+};
+
+/* std140 layout of the ObjectUniforms block */
+struct ObjectUniformData
+{
+    glm::mat4 MVPmatrix;
+    glm::mat4 modelMatrix;
+    glm::vec4 baseColour;
+    GLint textureLayer;
+    GLint padding;          //uvec2s start on 8 bytes
+    GLuint64 textureHandle; //The shader's uvec2, for SHADER_BINDLESS
+};
+
+class UniformBuffers
+{
+public:
+    bool usePersistentMapping;  //Map the buffer persistently when it's made, if the driver can
+    bool persistent;            //Whether it is, once it has been made
+    int objectsThisFrame;
+    int regionsThisFrame;       //More than one when a frame has more draws than a region has slots
+
+    UniformBuffers(int slotsPerRegion) : usePersistentMapping(true), persistent(false), objectsThisFrame(0), regionsThisFrame(1),
+                                         slots(slotsPerRegion), used(0), region(0), stride(0), UBO(0), mapped(NULL)
+    {
+        for(int r = 0; r < UNIFORM_BUFFER_REGIONS; r++)
+            fences[r] = 0;
+
+        frame.lightColour = glm::vec4(LIGHT_COLOUR, 1.0f);
+        frame.lightPos = glm::vec4(LIGHT_POS, 1.0f);
+        frame.viewPos = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    /* The camera for this frame. The light doesn't move, so that's all that changes */
+    void SetFrame(glm::vec3 viewPosition)
+    {
+        frame.viewPos = glm::vec4(viewPosition, 1.0f);
+        WriteFrame();
+    }
+
+    /* Fill in the next slot and bind it, for the draw that comes next */
+    void SetObject(glm::mat4 MVP, glm::mat4 model, glm::vec4 colour, int textureLayer = 0, GLuint64 textureHandle = 0)
+    {
+        ObjectUniformData object;
+        object.MVPmatrix = MVP;
+        object.modelMatrix = model;
+        object.baseColour = colour;
+        object.textureLayer = textureLayer;
+        object.padding = 0;
+        object.textureHandle = textureHandle;
+
+        GLintptr offset = Write(&object, sizeof(ObjectUniformData));
+        glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_UNIFORMS_BINDING, this->UBO, offset, sizeof(ObjectUniformData));
+        objectsThisFrame++;
+    }
+
+    /* Fence off this frame's region and move on to the next one, with the frame uniforms carried over */
+    void EndFrame()
+    {
+        if(UBO != 0)
+            NextRegion();
+        objectsThisFrame = 0;
+        regionsThisFrame = 1;
+    }
+
+    /* Delete the buffer. The next write makes it again, with usePersistentMapping as it is then */
+    void Release()
+    {
+        if(UBO == 0)
+            return;
+
+        for(int r = 0; r < UNIFORM_BUFFER_REGIONS; r++)
+        {
+            if(fences[r] != 0)
+                glDeleteSync(fences[r]);
+            fences[r] = 0;
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+        if(persistent)
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glDeleteBuffers(1, &this->UBO);
+        perfStats.ReleaseBuffer(GetBufferBytes());
+
+        UBO = 0;
+        mapped = NULL;
+        used = 0;
+        region = 0;
+    }
+
+    long GetBufferBytes() const
+    {
+        return (long)UNIFORM_BUFFER_REGIONS * slots * stride;
+    }
+
+private:
+    int slots;      //In each region
+    int used;       //Slots written in the current region
+    int region;
+    GLsizei stride; //Bytes per slot, rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    GLuint UBO;
+    GLsync fences[UNIFORM_BUFFER_REGIONS];
+    char* mapped;   //Start of the whole buffer, when it's persistently mapped
+    FrameUniformData frame;
+
+    void Create()
+    {
+        GLint alignment;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        stride = (GLsizei)((sizeof(ObjectUniformData) + alignment - 1) / alignment * alignment);
+
+        glGenBuffers(1, &this->UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+
+        persistent = usePersistentMapping && GLEW_ARB_buffer_storage;
+        if(persistent)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_UNIFORM_BUFFER, GetBufferBytes(), NULL, flags);
+            mapped = (char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, GetBufferBytes(), flags);
+        }
+        else
+        {
+            glBufferData(GL_UNIFORM_BUFFER, GetBufferBytes(), NULL, GL_STREAM_DRAW);
+            mapped = NULL;
+        }
+        perfStats.bufferMemory += GetBufferBytes();
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        used = 0;
+        WriteFrame();
+    }
+
+    void WriteFrame()
+    {
+        GLintptr offset = Write(&frame, sizeof(FrameUniformData));
+        glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, this->UBO, offset, sizeof(FrameUniformData));
+    }
+
+    /* Copy into the next free slot and return its offset in the buffer */
+    GLintptr Write(const void* data, GLsizeiptr bytes)
+    {
+        if(UBO == 0)
+            Create();
+
+        if(used == slots)
+        {
+            //Out of room, so carry on in the next region. That region starts with the frame uniforms again
+            NextRegion();
+            regionsThisFrame++;
+        }
+
+        GLintptr offset = ((GLintptr)region * slots + used) * stride;
+        used++;
+        if(persistent)
+        {
+            memcpy(mapped + offset, data, bytes);
+        }
+        else
+        {
+            glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+            glBufferSubData(GL_UNIFORM_BUFFER, offset, bytes, data);
+            perfStats.AddBufferUpload(bytes, false);
+        }
+        return offset;
+    }
+
+    void NextRegion()
+    {
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        region = (region + 1) % UNIFORM_BUFFER_REGIONS;
+        used = 0;
+
+        //Only waits if the CPU is a whole UNIFORM_BUFFER_REGIONS regions ahead
+        if(fences[region] != 0)
+        {
+            glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            glDeleteSync(fences[region]);
+            fences[region] = 0;
+        }
+        WriteFrame();
+    }
+};
+
+/* Per-frame and per-draw uniforms for every object shader */
+UniformBuffers uniformBuffers(UNIFORM_BUFFER_SLOTS);
+
+#endif // UNIFORM_BUFFERS_H
@@ -0,0 +1,189 @@
+#ifndef VERTEX_KERNELS_H
+#define VERTEX_KERNELS_H
+
+#include <vector>
+
+#include "Introduction.h"
+#include "TrigTables.h"
+
+/*
+ * SIMD kernels for the ring-shaped parts of the procedural meshes.
+ * A ring of points is worked out in structure-of-arrays form, 4 (SSE) or 8 (AVX2) points
+ * per iteration, and the generators then interleave it into Vertex structs.
+ * Every kernel does exactly the same float multiplies, so they all give bit-identical results;
+ * the best one the CPU supports is picked at startup.
+ */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define VERTEX_KERNELS_X86 1
+    #define VERTEX_KERNEL_TARGET(isa) __attribute__((target(isa)))
+    #include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #define VERTEX_KERNELS_X86 1
+    #define VERTEX_KERNEL_TARGET(isa)
+    #include <intrin.h>
+    #include <immintrin.h>
+#endif
+
+/*
+ * x = positionScale * cosine, z = positionScale * sine,
+ * normalX = normalScale * cosine, normalZ = normalScale * sine, for count points
+ */
+typedef void (*RingKernel)(const float* cosine, const float* sine, int count, float positionScale, float normalScale,
+                           float* x, float* z, float* normalX, float* normalZ);
+
+void RingKernelScalar(const float* cosine, const float* sine, int count, float positionScale, float normalScale,
+                      float* x, float* z, float* normalX, float* normalZ)
+{
+    for(int i = 0; i < count; i++)
+    {
+        x[i] = positionScale * cosine[i];
+        z[i] = positionScale * sine[i];
+        normalX[i] = normalScale * cosine[i];
+        normalZ[i] = normalScale * sine[i];
+    }
+}
+
+#ifdef VERTEX_KERNELS_X86
+VERTEX_KERNEL_TARGET("sse2")
+void RingKernelSSE(const float* cosine, const float* sine, int count, float positionScale, float normalScale,
+                   float* x, float* z, float* normalX, float* normalZ)
+{
+    __m128 position = _mm_set1_ps(positionScale);
+    __m128 normal = _mm_set1_ps(normalScale);
+
+    int i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128 c = _mm_loadu_ps(cosine + i);
+        __m128 s = _mm_loadu_ps(sine + i);
+        _mm_storeu_ps(x + i, _mm_mul_ps(position, c));
+        _mm_storeu_ps(z + i, _mm_mul_ps(position, s));
+        _mm_storeu_ps(normalX + i, _mm_mul_ps(normal, c));
+        _mm_storeu_ps(normalZ + i, _mm_mul_ps(normal, s));
+    }
+    RingKernelScalar(cosine + i, sine + i, count - i, positionScale, normalScale, x + i, z + i, normalX + i, normalZ + i);
+}
+
+VERTEX_KERNEL_TARGET("avx2")
+void RingKernelAVX2(const float* cosine, const float* sine, int count, float positionScale, float normalScale,
+                    float* x, float* z, float* normalX, float* normalZ)
+{
+    __m256 position = _mm256_set1_ps(positionScale);
+    __m256 normal = _mm256_set1_ps(normalScale);
+
+    int i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        __m256 c = _mm256_loadu_ps(cosine + i);
+        __m256 s = _mm256_loadu_ps(sine + i);
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(position, c));
+        _mm256_storeu_ps(z + i, _mm256_mul_ps(position, s));
+        _mm256_storeu_ps(normalX + i, _mm256_mul_ps(normal, c));
+        _mm256_storeu_ps(normalZ + i, _mm256_mul_ps(normal, s));
+    }
+    RingKernelScalar(cosine + i, sine + i, count - i, positionScale, normalScale, x + i, z + i, normalX + i, normalZ + i);
+}
+
+bool CpuSupportsAVX2()
+{
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    //AVX2 is leaf 7 EBX bit 5, and the OS has to be saving the YMM registers too
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    bool osSavesYMM = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesYMM && (info[1] & (1 << 5));
+#endif
+}
+#endif
+
+/* A kernel and whether this CPU can run it, for the benchmarks */
+struct RingKernelInfo
+{
+    const char* name;
+    RingKernel kernel;
+    bool supported;
+};
+
+/* Every kernel built into this binary, slowest first */
+std::vector<RingKernelInfo> GetRingKernels()
+{
+    std::vector<RingKernelInfo> kernels;
+    RingKernelInfo scalar = {"Scalar", RingKernelScalar, true};
+    kernels.push_back(scalar);
+#ifdef VERTEX_KERNELS_X86
+    //SSE2 is always there on x86-64, and on anything that could run the GL this needs
+    RingKernelInfo sse = {"SSE", RingKernelSSE, true};
+    RingKernelInfo avx2 = {"AVX2", RingKernelAVX2, CpuSupportsAVX2()};
+    kernels.push_back(sse);
+    kernels.push_back(avx2);
+#endif
+    return kernels;
+}
+
+RingKernel SelectRingKernel()
+{
+    std::vector<RingKernelInfo> kernels = GetRingKernels();
+    for(size_t i = kernels.size(); i-- > 0;)
+        if(kernels[i].supported)
+            return kernels[i].kernel;
+    return RingKernelScalar;
+}
+
+/* The kernel the generators use */
+RingKernel ringKernel = SelectRingKernel();
+
+/* sin/cos tables as floats, padded with a copy of the first entry so that i + 1 never needs wrapping */
+struct RingTable
+{
+    std::vector<float> sine;
+    std::vector<float> cosine;
+    int count;
+
+    RingTable(const TrigTable& table) : sine(table.sine.size() + 1), cosine(table.cosine.size() + 1), count((int)table.sine.size())
+    {
+        for(int k = 0; k < count; k++)
+        {
+            sine[k] = (float)table.sine[k];
+            cosine[k] = (float)table.cosine[k];
+        }
+        sine[count] = sine[0];
+        cosine[count] = cosine[0];
+    }
+};
+
+/* One ring of points in structure-of-arrays form. Has count + 1 entries, the last repeating the first */
+struct RingPoints
+{
+    std::vector<float> x, z, normalX, normalZ;
+    float y, normalY;
+
+    /* Work the ring out with the selected kernel */
+    void Compute(const RingTable& around, float positionScale, float ringY, float normalScale, float ringNormalY, RingKernel kernel = ringKernel)
+    {
+        int count = around.count + 1;
+        x.resize(count);
+        z.resize(count);
+        normalX.resize(count);
+        normalZ.resize(count);
+        y = ringY;
+        normalY = ringNormalY;
+
+        kernel(&around.cosine[0], &around.sine[0], count, positionScale, normalScale, &x[0], &z[0], &normalX[0], &normalZ[0]);
+    }
+
+    struct Vertex GetVertex(int i) const
+    {
+        struct Vertex v = {{x[i], y, z[i]}, {normalX[i], normalY, normalZ[i]}, {0.0f, 0.0f}};
+        return v;
+    }
+};
+
+#endif // VERTEX_KERNELS_H
@@ -11,9 +11,23 @@
 #include "include/UVSphereGeometry.h"
 #include "include/ConeGeometry.h"
 #include "include/TriangleMesh.h"
-#include "include/LineArray.h"
+#include "include/UniformBuffers.h"
+#include "include/DebugDraw.h"
+#include "include/NormalVisualiser.h"
 #include "include/GraphicsObject.h"
 #include "include/OBJMesh.h"
+#include "include/MeshCache.h"
+#include "include/ProceduralMesh.h"
+#include "include/Simulation.h"
+#include "include/FramePipeline.h"
+#include "include/JobSystem.h"
+#include "include/AssetPack.h"
+#include "include/ShaderManager.h"
+#include "include/ShaderPermutations.h"
+#include "include/PointLights.h"
+#include "include/DeferredShading.h"
+#include "include/LightClusters.h"
+#include "include/Benchmarks.h"
 
 /* Screen parameters */
 const int width = 800;
@@ -25,8 +39,20 @@ void mouse_movement(GLFWwindow *window, double xPos, double yPos);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 void scroll_callback(GLFWwindow* window, double xpos, double ypos);
 
+/* Simulation functions */
+void updateAnimation(double time, std::vector<Transform>& transforms);
+void updateAsteroidBelt(double time, std::vector<Transform>& transforms);
+
+/* Scene set-up functions */
+void placeFieldSphere(int i, glm::vec3& position, float& radius, int& colour);
+void buildSphereField(std::vector<GraphicsObject>& field, int count);
+void buildProceduralSphereField(std::vector<ProceduralShape> shapes[4], int count);
+
 /* Render functions */
-void renderAnimation(std::vector<GraphicsObject> objects, Shader shader, glm::mat4 view, glm::mat4 projection);
+void renderAnimation(const FrameSnapshot& frame, ShaderPermutations& shaders, unsigned features, glm::mat4 view, glm::mat4 projection);
+
+/* Benchmark functions */
+void updatePipelineBenchmark(FramePipeline& pipeline, float frameTime);
 
 /* Stuff to read the mouse input to move the camera */
 GLfloat lastX = width / 2.0;
@@ -46,6 +72,28 @@ bool keys[1024];
 GLfloat deltaTime = 0.0f;
 GLfloat lastFrame = 0.0f;
 
+//The animation runs at a fixed 60 steps per second, whatever the frame rate
+const double SIMULATION_STEP = 1.0 / 60.0;
+float simulationSpeed = 1.0f;
+bool uncappedFrameRate = false;
+
+//Size of the heavy animated scene
+const int ASTEROID_COUNT = 5000;
+
+//Size of the scene of differently sized spheres sharing cached meshes
+const int SPHERE_FIELD_COUNT = 4000;
+GLfloat sphereFieldColours[4][3] = {{1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {0.0f, 0.8f, 0.0f}, {0.0f, 0.5f, 1.0f}};
+
+//Thunderbirds in the LOD test scene
+const int CROWD_ROWS = 16;
+const int CROWD_COLUMNS = 24;
+
+//Serial vs pipelined throughput on the asteroid belt
+const int PIPELINE_BENCHMARK_FRAMES = 300;
+int pipelineBenchmarkPhase = -1; //-1 = not running, 0 = serial, 1 = pipelined
+int pipelineBenchmarkFrame = 0;
+double pipelineBenchmarkTotals[2] = {0.0, 0.0};
+
 //For scene selection
 static int e = 0;
 bool stillRunning = true;
@@ -93,10 +141,21 @@ int main(void)
 	ImGui_ImplGlfwGL3_Init(window, false);
 	bool show_guiWindow = true;
 
-    /* Load the shader program */
-	Shader textureShader("shaders/TexturedDefault.vert", "shaders/TexturedDefault.frag");
-	Shader phongShader("shaders/UntexturedPhong.vert", "shaders/UntexturedPhong.frag");
-	Shader unshadedShader("shaders/UnshadedDefault.vert", "shaders/UnshadedDefault.frag");
+    /* Map the asset pack, if Tools/AssetPacker has made one. Anything that isn't in it comes from its loose file */
+    if(assetPack.Open(ASSET_PACK_PATH))
+        std::cout << "Mapped asset pack " << ASSET_PACK_PATH << ": " << assetPack.EntryCount() << " assets, " << assetPack.GetBytes() / 1024 << " KB" << std::endl;
+    else
+        std::cout << "No asset pack at " << ASSET_PACK_PATH << ", loading loose files" << std::endl;
+
+    /* Start the shader permutations the scenes use compiling. Nothing waits for them until the scenes have loaded */
+    double shaderStart = glfwGetTime();
+	objectShaders.Prepare(0);
+	objectShaders.Prepare(SHADER_TEXTURED);
+	objectShaders.Prepare(SHADER_LIT);
+	objectShaders.Prepare(SHADER_PROCEDURAL | SHADER_LIT);
+	if(bindlessTextures.Available())
+		objectShaders.Prepare(SHADER_TEXTURED | SHADER_BINDLESS);
+	double shaderSubmitSeconds = glfwGetTime() - shaderStart;
 
     /* Some colours to use later */
     GLfloat red[3] = {1.0f, 0.0f, 0.0f};
@@ -109,41 +168,93 @@ int main(void)
 	int segments = 30;
 	int rings = 10;
 	double radius = 2.0;
-    TriangleMesh sphereMesh(GetSpherePhong(segments, rings, radius), "images/crate.png", white);
-    GraphicsObject sphereObject(&sphereMesh, glm::vec3(0.0f), glm::quat());
-    /* Create the normals object for the sphere */
-    Lines sphereNormalsMesh(GetSphereNormalLines(segments, rings, radius, 0.4), red);
-    GraphicsObject sphereNormalsObject(&sphereNormalsMesh, glm::vec3(0.0f), glm::quat());
-
-    /* Create some spheres for a solar system */
+    GraphicsObject sphereObject(meshCache.GetSphere(segments, rings, "Images/crate.png", white), glm::vec3(0.0f), glm::quat(), radius);
+    /* Normals are drawn by a geometry shader, from the buffers the meshes already have */
+    NormalVisualiser normalVisualiser(0.4f, red);
+    bool showNormals = false;
+    bool normalsAsDebugLines = false;   //Read back and drawn with debugDraw instead, to check the geometry shader against
+    bool showBounds = false;
+    bool frustumFrozen = false;
+    glm::mat4 frozenFrustum;
+
+    /* Point lights over the lit scenes (the shaded sphere and the sphere fields), lit forward, clustered or deferred */
+    bool deferredShading = false;
+    bool clusteredLights = false;
+    int pointLightCount = 0;
+
+    /* Create some spheres for a solar system. Sizes are applied as a scale on unit meshes from the cache */
     std::vector<GraphicsObject> solarSystem;
+    solarSystem.push_back(GraphicsObject(meshCache.GetSphere(20, 20, "_", yellow), glm::vec3(0.0f), glm::quat(), 1.0f));
+    solarSystem.push_back(GraphicsObject(meshCache.GetSphere(10, 10, "_", red), glm::vec3(2.0f, 0.0f, 0.0f), glm::quat(), 0.3f));
+    //Height 1, radius 0.5
+    solarSystem.push_back(GraphicsObject(meshCache.GetCone(10, 2.0, "_", white), glm::vec3(2.0f, 0.0f, 0.0f), glm::quat(), 0.5f));
+    solarSystem.push_back(GraphicsObject(meshCache.GetSphere(10, 10, "_", cyan), glm::vec3(4.0f, 0.0f, 0.0f), glm::quat(), 0.5f));
+    solarSystem.push_back(GraphicsObject(meshCache.GetSphere(5, 5, "_", green), glm::vec3(4.8f, 0.0f, 0.0f), glm::quat(), 0.1f));
+    solarSystem.push_back(GraphicsObject(meshCache.GetSphere(8, 8, "_", white), glm::vec3(7.0f, 0.0f, 0.0f), glm::quat(), 0.2f));
+
+    AnimatedScene solarSystemScene(solarSystem, updateAnimation, SIMULATION_STEP);
+
+    /* A heavy animated scene: thousands of tumbling rocks sharing one mesh */
+    std::vector<GraphicsObject> asteroids;
+    for(int i = 0; i < ASTEROID_COUNT; i++)
+        asteroids.push_back(GraphicsObject(meshCache.GetSphere(6, 5, "_", white), glm::vec3(0.0f), glm::quat(), 0.08f));
+    AnimatedScene asteroidScene(asteroids, updateAsteroidBelt, SIMULATION_STEP);
+
+    /* Thousands of spheres of all different sizes, drawn from a handful of cached meshes */
+    std::vector<GraphicsObject> sphereField;
+    BenchmarkClock::time_point sphereFieldStart = BenchmarkClock::now();
+    buildSphereField(sphereField, SPHERE_FIELD_COUNT);
+    BenchmarkLog("Sphere field: %d spheres in %.1f ms", SPHERE_FIELD_COUNT, SecondsSince(sphereFieldStart) * 1000.0);
+    BenchmarkLog("Mesh cache: %d meshes (%d from tables) for %d requests, %.1f KB of vertex data, %.1f ms generating",
+                 meshCache.MeshCount(), meshCache.tableMeshes, meshCache.hits + meshCache.misses, meshCache.bufferBytes / 1024.0, meshCache.buildSeconds * 1000.0);
+
+    /* The same field made by the vertex shader, where every sphere can have its own resolution. One batch per colour */
+    std::vector<GraphicsObject> proceduralField;
+    BenchmarkClock::time_point proceduralFieldStart = BenchmarkClock::now();
+    std::vector<ProceduralShape> proceduralShapes[4];
+    buildProceduralSphereField(proceduralShapes, SPHERE_FIELD_COUNT);
+    long proceduralBytes = 0;
+    for(int c = 0; c < 4; c++)
+    {
+        ProceduralShapes* batch = new ProceduralShapes(proceduralShapes[c], sphereFieldColours[c]);
+        proceduralBytes += batch->GetBufferBytes();
+        proceduralField.push_back(GraphicsObject(batch, glm::vec3(0.0f), glm::quat()));
+    }
+    BenchmarkLog("GPU sphere field: %d spheres in %.1f ms, %.1f KB of instance data", SPHERE_FIELD_COUNT, SecondsSince(proceduralFieldStart) * 1000.0, proceduralBytes / 1024.0);
 
-    TriangleMesh sun(GetSpherePhong(20, 20, 1.0), "_", yellow);
-    solarSystem.push_back(GraphicsObject(&sun, glm::vec3(0.0f), glm::quat()));
-
-    TriangleMesh smallPlanet(GetSpherePhong(10, 10, 0.3), "_", red);
-    solarSystem.push_back(GraphicsObject(&smallPlanet, glm::vec3(2.0f, 0.0f, 0.0f), glm::quat()));
-
-    TriangleMesh smallCone(GetConePhong(10, 1.0, 0.5), "_", white);
-    solarSystem.push_back(GraphicsObject(&smallCone, glm::vec3(2.0f, 0.0f, 0.0f), glm::quat()));
-
-    TriangleMesh bigPlanet(GetSpherePhong(10, 10, 0.5), "_", cyan);
-    solarSystem.push_back(GraphicsObject(&bigPlanet, glm::vec3(4.0f, 0.0f, 0.0f), glm::quat()));
-
-    TriangleMesh moon(GetSpherePhong(5, 5, 0.1), "_", green);
-    solarSystem.push_back(GraphicsObject(&moon, glm::vec3(4.8f, 0.0f, 0.0f), glm::quat()));
-
-    TriangleMesh tinyPlanet(GetSpherePhong(8, 8, 0.2), "_", white);
-    solarSystem.push_back(GraphicsObject(&tinyPlanet, glm::vec3(7.0f, 0.0f, 0.0f), glm::quat()));
+    /* Animation runs on its own thread, a frame ahead of the rendering */
+    FramePipeline framePipeline;
 
     /* Create a textured box */
-    TriangleMesh cubeMesh(GetCubeGeometry(3), "images/glowstone.png", white);
-    GraphicsObject cubeObject(&cubeMesh, glm::vec3(0.0f), glm::quat());
+    TriangleMesh cubeMesh(CUBE_VERTICES, CUBE_VERTEX_COUNT, "Images/glowstone.png", white);
+    GraphicsObject cubeObject(&cubeMesh, glm::vec3(0.0f), glm::quat(), 3.0f);
 
     /* Load in a obj file */
-    OBJMesh thunderbirdMesh("models/thunderbird.obj", "images/thunderbird.png", white);
+    OBJMesh thunderbirdMesh("models/thunderbird.obj", "Images/thunderbird.png", white);
     GraphicsObject thunderbirdObject(&thunderbirdMesh, glm::vec3(0.0f), glm::quat());
 
+    /* A crowd of thunderbirds stretching off into the distance, to show off the LOD chain */
+    std::vector<GraphicsObject> thunderbirdCrowd;
+    for(int row = 0; row < CROWD_ROWS; row++)
+    {
+        for(int column = 0; column < CROWD_COLUMNS; column++)
+        {
+            glm::vec3 position((column - (CROWD_COLUMNS - 1) / 2.0f) * 7.0f, 0.0f, -6.0f * row);
+            glm::quat heading = glm::angleAxis(glm::radians((float)((row * 7 + column * 13) % 40) - 20.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            thunderbirdCrowd.push_back(GraphicsObject(&thunderbirdMesh, position, heading, 0.5f));
+        }
+    }
+
+    /* Now the shaders are needed, and have most likely finished while everything else loaded */
+    double shaderWaitStart = glfwGetTime();
+    shaderManager.FinishAll();
+    std::cout << "Shaders: " << shaderSubmitSeconds * 1000.0 << " ms to start, " << (glfwGetTime() - shaderWaitStart) * 1000.0 << " ms waiting for them ("
+              << shaderCache.hits << " from the cache, " << shaderCache.misses << " compiled)" << std::endl;
+    shaderManager.PrintTimes();
+
+    /* LOD selection works in pixels */
+    lodViewportHeight = height;
+
 	/* Main loop */
 	while(!glfwWindowShouldClose(window) && stillRunning)
 	{
@@ -154,6 +265,15 @@ int main(void)
 
 		glfwPollEvents();
 
+		updatePipelineBenchmark(framePipeline, deltaTime);
+
+		/* Hand the animated scene to the simulation, and get back the frame to draw */
+		FrameInput frameInput;
+		frameInput.scene = (e == 3) ? &solarSystemScene : (e == 6) ? &asteroidScene : NULL;
+		frameInput.frameTime = deltaTime;
+		frameInput.timeScale = simulationSpeed;
+		const FrameSnapshot& animationFrame = framePipeline.BeginFrame(frameInput);
+
 		/*ImGUI UI code*/
 		ImGui_ImplGlfwGL3_NewFrame();
 
@@ -169,8 +289,55 @@ int main(void)
         ImGui::RadioButton("D: Animated scene", &e, 3);
         ImGui::RadioButton("E: Textured box", &e, 4);
         ImGui::RadioButton("F: Imported mesh", &e, 5);
+        ImGui::RadioButton("G: Asteroid belt", &e, 6);
+        ImGui::RadioButton("H: Sphere field", &e, 7);
+        ImGui::RadioButton("I: Thunderbird crowd", &e, 8);
+        ImGui::RadioButton("J: GPU sphere field", &e, 9);
 
 		ImGui::Text("(%.1f FPS)", ImGui::GetIO().Framerate);
+
+		ImGui::SliderFloat("Sim speed", &simulationSpeed, 0.0f, 32.0f);
+		if(ImGui::Checkbox("Uncap frame rate", &uncappedFrameRate))
+            glfwSwapInterval(uncappedFrameRate ? 0 : 1);
+		ImGui::Text("Sim steps this frame: %d", animationFrame.simulationSteps);
+		ImGui::Checkbox("Pipelined simulation", &framePipeline.pipelined);
+		ImGui::Checkbox("LOD", &lodEnabled);
+		ImGui::SliderFloat("LOD error (px)", &lodPixelError, 0.25f, 16.0f);
+		ImGui::Text("Tris %.0f, %.2f ms per frame", perfStats.triangleHistory.Latest(), perfStats.frameTimeHistory.Average() * 1000.0f);
+		ImGui::Checkbox("Normals", &showNormals);
+		ImGui::SameLine();
+		ImGui::SliderFloat("Length", &normalVisualiser.length, 0.05f, 1.0f);
+		ImGui::SameLine();
+		ImGui::Checkbox("As debug lines", &normalsAsDebugLines);
+		if(GLEW_ARB_bindless_texture)
+			ImGui::Checkbox("Bindless textures", &bindlessTextures.enabled);
+		ImGui::Checkbox("Deferred shading", &deferredShading);
+		if(GLEW_ARB_shader_storage_buffer_object)
+		{
+			ImGui::SameLine();
+			ImGui::Checkbox("Clustered lights", &clusteredLights);
+		}
+		if(ImGui::SliderInt("Point lights", &pointLightCount, 0, MAX_POINT_LIGHTS))
+			pointLights.Scatter(pointLightCount, glm::vec3(-12.0f, 0.2f, -12.0f), glm::vec3(12.0f, 2.5f, 12.0f), 3.0f, 1);
+		if(clusteredLights && !deferredShading)
+			ImGui::Text("Light assignment %.3f ms, upload %.3f ms, %d indices, up to %d a cluster", lightClusters.buildSeconds * 1000.0,
+			            lightClusters.uploadSeconds * 1000.0, lightClusters.indexCount, lightClusters.maxPerCluster);
+		ImGui::Checkbox("Debug bounds", &showBounds);
+		ImGui::SameLine();
+		bool captureFrustum = ImGui::Checkbox("Freeze frustum", &frustumFrozen) && frustumFrozen;
+		if(debugDraw.totalDroppedLines > 0)
+			ImGui::Text("Debug lines dropped: %d last frame, %ld in all", debugDraw.lastDroppedLines, debugDraw.totalDroppedLines);
+		if(pipelineBenchmarkPhase < 0 && ImGui::Button("Benchmark pipelining"))
+        {
+            pipelineBenchmarkPhase = 0;
+            pipelineBenchmarkFrame = 0;
+        }
+        if(pipelineBenchmarkTotals[1] > 0.0)
+            ImGui::Text("Serial %.2f ms, pipelined %.2f ms", pipelineBenchmarkTotals[0] * 1000.0 / PIPELINE_BENCHMARK_FRAMES, pipelineBenchmarkTotals[1] * 1000.0 / PIPELINE_BENCHMARK_FRAMES);
+
+		perfStats.DrawPanel();
+		gpuResources.DrawPanel();
+		DrawBenchmarkPanel();
 		ImGui::End();
 
 		/* Rendering commands */
@@ -184,6 +351,42 @@ int main(void)
 		glm::mat4 projection;
 		projection = glm::perspective(glm::radians(camera.Fov), (GLfloat)width / (GLfloat)width, 0.1f, 100.0f);
 
+		/* Light and camera for every shader this frame */
+		uniformBuffers.SetFrame(camera.GetCameraPosition());
+
+		auto drawNormals = [&](GraphicsObject& object)
+		{
+			if(normalsAsDebugLines)
+				debugDraw.AddNormals(object, view, projection, normalVisualiser.length, red);
+			else
+				normalVisualiser.Draw(object, view, projection);
+		};
+
+		/* The lit scenes either light as they draw, with every point light or just their cluster's, or write the
+		   G-buffer to be lit afterwards */
+		bool litScene = (e == 2 || e == 7 || e == 9);
+		bool deferred = deferredShading && litScene;
+		unsigned litFeatures = SHADER_LIT | (pointLights.Count() > 0 ? SHADER_POINT_LIGHTS : 0);
+		if(deferred)
+		{
+			litFeatures = SHADER_LIT | SHADER_GBUFFER;
+			deferredRenderer.BeginGeometry(width, height);
+		}
+		else if(clusteredLights && litScene && GLEW_ARB_shader_storage_buffer_object)
+		{
+			litFeatures = SHADER_LIT | SHADER_CLUSTERED;
+			pointLights.Upload();
+			lightClusters.Build(pointLights, view, projection, 0.1f, 100.0f, width, height);
+		}
+		else if(pointLights.Count() > 0)
+		{
+			pointLights.Upload();
+		}
+
+		/* Leave the camera's view volume where it is now, to look at from elsewhere */
+		if(captureFrustum)
+            frozenFrustum = projection * view;
+
 		/* Scene switcher */
 		//Get it? Because it's a switch statement.
 		switch(e)
@@ -191,86 +394,248 @@ int main(void)
         case 0:
             /*Draw wireframes */
             glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-            unshadedShader.Use();
-            sphereObject.Draw(unshadedShader, view, projection);
+            sphereObject.Draw(objectShaders, 0, view, projection);
             break;
         case 1:
             /*Draw wireframes */
             glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-            unshadedShader.Use();
-            sphereObject.Draw(unshadedShader, view, projection);
-            sphereNormalsObject.Draw(unshadedShader, view, projection);
+            sphereObject.Draw(objectShaders, 0, view, projection);
+            drawNormals(sphereObject);
             break;
         case 2:
-            phongShader.Use();
-            sphereObject.Draw(phongShader, view, projection);
+            sphereObject.Draw(objectShaders, litFeatures, view, projection);
+            //Not into the G-buffer, which only takes lit surfaces. They go on after the lighting instead
+            if(showNormals && !deferred)
+                drawNormals(sphereObject);
             break;
         case 3:
-            renderAnimation(solarSystem, unshadedShader, view, projection);
+        case 6:
+            //Textured where there's a texture, which none of these meshes ("_") have
+            renderAnimation(animationFrame, objectShaders, SHADER_TEXTURED, view, projection);
             break;
         case 4:
-            textureShader.Use();
-            cubeObject.Draw(textureShader, view, projection);
+            cubeObject.Draw(objectShaders, SHADER_TEXTURED, view, projection);
+            if(showNormals)
+                drawNormals(cubeObject);
             break;
         case 5:
-            textureShader.Use();
-            thunderbirdObject.Draw(textureShader, view, projection);
+            thunderbirdObject.Draw(objectShaders, SHADER_TEXTURED, view, projection);
+            if(showNormals)
+                drawNormals(thunderbirdObject);
+            break;
+        case 7:
+            for(size_t i = 0; i < sphereField.size(); i++)
+                sphereField[i].Draw(objectShaders, litFeatures, view, projection);
+            if(showBounds)
+            {
+                for(size_t i = 0; i < sphereField.size(); i++)
+                {
+                    glm::vec3 extent(sphereField[i].scale);
+                    debugDraw.AddAABB(sphereField[i].worldPosition - extent, sphereField[i].worldPosition + extent, white);
+                }
+            }
+            break;
+        case 8:
+            for(size_t i = 0; i < thunderbirdCrowd.size(); i++)
+                thunderbirdCrowd[i].Draw(objectShaders, SHADER_TEXTURED, view, projection);
+            break;
+        case 9:
+            //The batches add SHADER_PROCEDURAL themselves
+            for(size_t i = 0; i < proceduralField.size(); i++)
+                proceduralField[i].Draw(objectShaders, litFeatures, view, projection);
 		}
 		//...sorry.
 
+		if(deferred)
+		{
+			deferredRenderer.Light(view, projection, pointLights);
+			if(e == 2 && showNormals)
+				drawNormals(sphereObject);
+		}
+
+		/* Debug lines from the scenes, all in one draw */
+		if(frustumFrozen)
+            debugDraw.AddFrustum(frozenFrustum, yellow);
+		debugDraw.Flush(view, projection);
+		uniformBuffers.EndFrame();
+		/* Streamed textures have heard from everything drawn with them, so can be given the detail they need */
+		textureStreamer.Update();
+
         // ImGui functions end here
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 		ImGui::Render();
 
 		glfwSwapBuffers(window);
+
+		perfStats.EndFrame(deltaTime);
+		/* Delete whatever was released a few frames ago and the GPU has finished with */
+		gpuResources.EndFrame();
 	}
 
 	/* Terminate properly */
+	framePipeline.WaitForWorker();
 	glfwTerminate();
 	return 0;
 }
 
 /*
- * Draw a solar system
+ * Move the solar system to where it is at the given simulation time
  * Order: Sun - Small planet - Cone thing - Large planet - LP moon - Tiny planet
  */
-void renderAnimation(std::vector<GraphicsObject> objects, Shader shader, glm::mat4 view, glm::mat4 projection)
+void updateAnimation(double time, std::vector<Transform>& transforms)
 {
-    if(objects.size() >= 6)
+    if(transforms.size() >= 6)
+    {
+        float t = (float)time;
+        glm::vec3 yAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+
+        //The sun stays where it is
+        transforms[0].position = glm::vec3(0.0f);
+        transforms[0].rotation = glm::quat();
+
+        glm::quat smallPlanetOrbit = glm::angleAxis(t * glm::radians(45.0f), yAxis);
+        transforms[1].rotation = smallPlanetOrbit;
+        transforms[1].position = smallPlanetOrbit * glm::vec3(2.0f, 0.0f, 0.0f);
+
+        //The cone follows the small planet around, just underneath it
+        transforms[2].rotation = smallPlanetOrbit;
+        transforms[2].position = smallPlanetOrbit * glm::vec3(0.0f, -2.0f, 0.0f);
+
+        glm::quat largePlanetOrbit = glm::angleAxis(t * glm::radians(20.0f), yAxis);
+        transforms[3].rotation = largePlanetOrbit;
+        transforms[3].position = largePlanetOrbit * glm::vec3(4.0f, 0.0f, 0.0f);
+
+        //The moon orbits the large planet on a tilted axis
+        glm::quat moonOrbit = largePlanetOrbit * glm::angleAxis(t * glm::radians(60.0f), glm::normalize(glm::vec3(0.0f, 1.0f, 1.0f)));
+        transforms[4].rotation = moonOrbit;
+        transforms[4].position = transforms[3].position + moonOrbit * glm::vec3(0.8f, 0.0f, 0.0f);
+
+        glm::quat tinyPlanetOrbit = glm::angleAxis(glm::radians(20.0f), glm::vec3(1.0f, 0.0f, 0.0f)) * glm::angleAxis(t * glm::radians(40.0f), yAxis);
+        transforms[5].rotation = tinyPlanetOrbit;
+        transforms[5].position = tinyPlanetOrbit * glm::vec3(7.0f, 0.0f, 0.0f);
+    }
+}
+
+/*
+ * Move each asteroid along its own tilted orbit, tumbling as it goes.
+ * The orbit parameters are made up from the index so that nothing needs storing,
+ * which also lets the asteroids be spread over the job system.
+ */
+void updateAsteroidBelt(double time, std::vector<Transform>& transforms)
+{
+    float t = (float)time;
+    jobSystem.ParallelFor((int)transforms.size(), 256, [t, &transforms](int begin, int end)
+    {
+        for(int i = begin; i < end; i++)
+        {
+            unsigned int hash = (unsigned int)i * 2654435761u;
+            float orbitRadius = 5.0f + (hash % 1000) * 0.004f;
+            float orbitSpeed = glm::radians(10.0f + (hash >> 10) % 30);
+            float phase = (hash >> 5) % 360;
+            float tilt = glm::radians(((hash >> 15) % 100) * 0.1f - 5.0f);
+            glm::vec3 spinAxis = glm::normalize(glm::vec3(1.0f, (hash >> 20) % 7, (hash >> 24) % 5));
+
+            glm::quat orbit = glm::angleAxis(tilt, glm::vec3(1.0f, 0.0f, 0.0f)) * glm::angleAxis(glm::radians(phase) + t * orbitSpeed, glm::vec3(0.0f, 1.0f, 0.0f));
+            transforms[i].position = orbit * glm::vec3(orbitRadius, 0.0f, 0.0f);
+            transforms[i].rotation = orbit * glm::angleAxis(t * 2.0f, spinAxis);
+        }
+    });
+}
+
+/* Scatter spheres of random sizes over a disc, in a few colours */
+void placeFieldSphere(int i, glm::vec3& position, float& radius, int& colour)
+{
+    unsigned int hash = (unsigned int)i * 2654435761u;
+    float distance = 12.0f * sqrtf(((hash >> 4) % 1000) / 1000.0f);
+    float angle = glm::radians((float)((hash >> 12) % 360));
+    radius = 0.05f + ((hash >> 20) % 100) * 0.004f;
+    position = glm::vec3(distance * cosf(angle), radius, distance * sinf(angle));
+    colour = hash % 4;
+}
+
+/*
+ * The sphere field in two levels of detail.
+ * Every one of them gets its mesh from the cache, so only a handful of meshes are made.
+ */
+void buildSphereField(std::vector<GraphicsObject>& field, int count)
+{
+    field.reserve(field.size() + count);
+    for(int i = 0; i < count; i++)
+    {
+        glm::vec3 position;
+        float radius;
+        int colour;
+        placeFieldSphere(i, position, radius, colour);
+
+        //Bigger spheres get the more detailed mesh
+        int segments = radius > 0.25f ? 24 : 12;
+        Mesh* mesh = meshCache.GetSphere(segments, segments / 2, "_", sphereFieldColours[colour]);
+        field.push_back(GraphicsObject(mesh, position, glm::quat(), radius));
+    }
+}
+
+/*
+ * The sphere field for the vertex shader to make, split up by colour.
+ * Every sphere gets a resolution to suit its size, which on the CPU would need a mesh each.
+ */
+void buildProceduralSphereField(std::vector<ProceduralShape> shapes[4], int count)
+{
+    for(int i = 0; i < count; i++)
+    {
+        glm::vec3 position;
+        float radius;
+        int colour;
+        placeFieldSphere(i, position, radius, colour);
+
+        int segments = 8 + (int)(radius * 100.0f);
+        shapes[colour].push_back(ProceduralShape::Sphere(position, radius, segments, segments / 2));
+    }
+}
+
+/*
+ * Draw a frame of an animated scene, as prepared by the simulation
+ */
+void renderAnimation(const FrameSnapshot& frame, ShaderPermutations& shaders, unsigned features, glm::mat4 view, glm::mat4 projection)
+{
+    /*Draw wireframes */
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+    for(size_t i = 0; i < frame.drawList.size(); i++)
+        frame.drawList[i].object->Draw(shaders, features, frame.drawList[i].model, view, projection);
+}
+
+/*
+ * Time a run of frames of the asteroid belt with the pipeline off, then again with it on
+ */
+void updatePipelineBenchmark(FramePipeline& pipeline, float frameTime)
+{
+    if(pipelineBenchmarkPhase < 0)
+        return;
+
+    //The first frame of each phase just sets things up
+    if(pipelineBenchmarkFrame == 0)
+    {
+        e = 6;
+        glfwSwapInterval(0);
+        pipeline.pipelined = (pipelineBenchmarkPhase == 1);
+        pipelineBenchmarkTotals[pipelineBenchmarkPhase] = 0.0;
+    }
+    else
+    {
+        pipelineBenchmarkTotals[pipelineBenchmarkPhase] += frameTime;
+    }
+
+    if(++pipelineBenchmarkFrame > PIPELINE_BENCHMARK_FRAMES)
     {
-        /*Draw wireframes */
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        shader.Use();
-
-        glm::mat4 smallPlanet_Model;
-        smallPlanet_Model = glm::rotate(smallPlanet_Model, (float)glfwGetTime() * glm::radians(45.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        smallPlanet_Model = glm::translate(smallPlanet_Model, glm::vec3(2.0f, 0.0f, 0.0f));
-        //smallPlanet_Model = glm::rotate(smallPlanet_Model, glm::radians(10.0f), glm::vec3(0.0f, 1.0f, 1.0f));
-        //smallPlanet_Model = glm::rotate(smallPlanet_Model, (float)glfwGetTime() * 10, glm::vec3(0.0f, 1.0f, 0.0f));
-
-        glm::mat4 smallCone_Model;
-        smallCone_Model = glm::rotate(smallCone_Model, (float)glfwGetTime() * glm::radians(45.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        smallCone_Model = glm::translate(smallCone_Model, glm::vec3(0.0f, -2.0f, 0.0f));
-
-        glm::mat4 largePlanet_Model;
-        largePlanet_Model = glm::rotate(largePlanet_Model, (float)glfwGetTime() * glm::radians(20.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        largePlanet_Model = glm::translate(largePlanet_Model, glm::vec3(4.0f, 0.0f, 0.0f));
-
-        glm::mat4 moon_Model;
-        moon_Model = glm::rotate(largePlanet_Model, (float)glfwGetTime() * glm::radians(60.0f), glm::normalize(glm::vec3(0.0f, 1.0f, 1.0f)));
-        moon_Model = glm::translate(moon_Model, glm::vec3(0.8f, 0.0f, 0.0f));
-
-        glm::mat4 tinyPlanet_Model;
-        tinyPlanet_Model = glm::rotate(tinyPlanet_Model, glm::radians(20.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-        tinyPlanet_Model = glm::rotate(tinyPlanet_Model, (float)glfwGetTime() * glm::radians(40.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        tinyPlanet_Model = glm::translate(tinyPlanet_Model, glm::vec3(7.0f, 0.0f, 0.0f));
-
-        objects[0].Draw(shader, view, projection);
-        objects[1].Draw(shader, smallPlanet_Model, view, projection);
-        objects[2].Draw(shader, smallCone_Model, view, projection);
-        objects[3].Draw(shader, largePlanet_Model, view, projection);
-        objects[4].Draw(shader, moon_Model, view, projection);
-        objects[5].Draw(shader, tinyPlanet_Model, view, projection);
+        std::cout << (pipelineBenchmarkPhase == 0 ? "Serial" : "Pipelined") << " asteroid belt: "
+                  << pipelineBenchmarkTotals[pipelineBenchmarkPhase] * 1000.0 / PIPELINE_BENCHMARK_FRAMES << " ms per frame" << std::endl;
+
+        pipelineBenchmarkFrame = 0;
+        if(++pipelineBenchmarkPhase > 1)
+        {
+            pipelineBenchmarkPhase = -1;
+            glfwSwapInterval(uncappedFrameRate ? 0 : 1);
+        }
     }
 }
 
@@ -300,6 +665,14 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
             e = 4;
         else if(keys[GLFW_KEY_F])
             e = 5;
+        else if(keys[GLFW_KEY_G])
+            e = 6;
+        else if(keys[GLFW_KEY_H])
+            e = 7;
+        else if(keys[GLFW_KEY_I])
+            e = 8;
+        else if(keys[GLFW_KEY_J])
+            e = 9;
         else if(keys[GLFW_KEY_Q] || keys[GLFW_KEY_ESCAPE])
             stillRunning = false; //Set the flag to close next frame
 	}
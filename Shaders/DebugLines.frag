@@ -0,0 +1,9 @@
+#version 400 core
+in vec4 lineColour;
+
+out vec4 colour;
+
+void main()
+{
+    colour = lineColour;
+}
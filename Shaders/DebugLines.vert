@@ -0,0 +1,13 @@
+#version 400 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec4 colour;
+
+uniform mat4 viewProjection;
+
+out vec4 lineColour;
+
+void main()
+{
+    gl_Position = viewProjection * vec4(position, 1.0f);
+    lineColour = colour;
+}
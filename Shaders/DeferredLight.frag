@@ -0,0 +1,75 @@
+#version 400 core
+/* Lights the G-buffer Object.frag wrote with GBUFFER. See DeferredLight.vert */
+#ifndef MAIN_LIGHT
+flat in vec4 lightSphere;
+flat in vec3 lightColour;
+#endif
+
+out vec4 colour;
+
+layout (std140) uniform FrameUniforms
+{
+    vec4 mainLightColour;
+    vec3 lightPos;
+    vec3 viewPos;
+};
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+
+/* Undo Object.frag's packNormal */
+vec3 unpackNormal(vec2 encoded)
+{
+    vec2 f = encoded * 2.0 - 1.0;
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    if(n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    if(depth == 1.0)
+    {
+        //Nothing was drawn here, so it stays the clear colour
+#ifdef MAIN_LIGHT
+        colour = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+#else
+        discard;
+#endif
+    }
+
+    //The world position back from the depth and where it is on screen
+    vec2 ndc = (gl_FragCoord.xy / vec2(textureSize(gDepth, 0))) * 2.0 - 1.0;
+    vec4 world = inverseViewProjection * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+    vec3 fragPos = world.xyz / world.w;
+
+    vec3 albedo = texelFetch(gAlbedo, pixel, 0).rgb;
+    vec3 normal = unpackNormal(texelFetch(gNormal, pixel, 0).xy);
+    vec3 viewDirection = normalize(viewPos - fragPos);
+
+#ifdef MAIN_LIGHT
+    //The same as Object.frag's LIT
+    vec3 lightDirection = normalize(lightPos - fragPos);
+    float diffuse = max(dot(normal, lightDirection), 0.0);
+    float specular = 0.5 * pow(max(dot(viewDirection, reflect(-lightDirection, normal)), 0.0), 32);
+    colour = vec4(albedo * (0.1 + diffuse + specular) * mainLightColour.rgb, 1.0);
+#else
+    //The same as Object.frag's pointLight
+    vec3 toLight = lightSphere.xyz - fragPos;
+    float lightDistance = length(toLight);
+    if(lightDistance >= lightSphere.w)
+        discard;
+    float falloff = 1.0 - (lightDistance * lightDistance) / (lightSphere.w * lightSphere.w);
+    vec3 lightDirection = toLight / max(lightDistance, 0.0001);
+
+    float diffuse = max(dot(normal, lightDirection), 0.0);
+    float specular = 0.5 * pow(max(dot(viewDirection, reflect(-lightDirection, normal)), 0.0), 32);
+    colour = vec4(albedo * (diffuse + specular) * falloff * falloff * lightColour, 1.0);
+#endif
+}
@@ -0,0 +1,54 @@
+#version 400 core
+/*
+ * The lighting passes of deferred shading (DeferredShading.h). With MAIN_LIGHT it's one triangle over the whole
+ * screen, for the light in FrameUniforms. Otherwise it's a quad per point light, an instance each, covering just
+ * the part of the screen the light's sphere can reach.
+ */
+#ifndef MAIN_LIGHT
+layout (location = 0) in vec4 positionRadius;  //Straight out of the LightUniforms buffer
+layout (location = 1) in vec4 colour;
+
+uniform mat4 viewProjection;
+
+flat out vec4 lightSphere;
+flat out vec3 lightColour;
+#endif
+
+void main()
+{
+#ifdef MAIN_LIGHT
+    //Corners at (-1, -1), (3, -1) and (-1, 3), which cover the screen
+    gl_Position = vec4(float((gl_VertexID & 1) * 4 - 1), float((gl_VertexID & 2) * 2 - 1), 0.0, 1.0);
+#else
+    lightSphere = positionRadius;
+    lightColour = colour.rgb;
+
+    //The screen rectangle around the sphere's bounding box, or the whole screen if the box goes behind the camera
+    vec2 low = vec2(1.0), high = vec2(-1.0);
+    bool behind = false;
+    for(int i = 0; i < 8; i++)
+    {
+        vec3 corner = vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1) * 2.0 - 1.0;
+        vec4 clip = viewProjection * vec4(positionRadius.xyz + positionRadius.w * corner, 1.0);
+        if(clip.w <= 0.0)
+        {
+            behind = true;
+            break;
+        }
+        low = min(low, clip.xy / clip.w);
+        high = max(high, clip.xy / clip.w);
+    }
+    if(behind)
+    {
+        low = vec2(-1.0);
+        high = vec2(1.0);
+    }
+    //Off the screen altogether clamps down to nothing
+    low = clamp(low, -1.0, 1.0);
+    high = clamp(high, -1.0, 1.0);
+
+    //A triangle strip: 0 and 1 along the bottom, 2 and 3 along the top
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    gl_Position = vec4(mix(low, high, corner), 0.0, 1.0);
+#endif
+}
@@ -0,0 +1,12 @@
+#version 400 core
+/* Hands each vertex of a mesh, drawn as points, to NormalLines.geom in model space */
+layout (location = 0) in vec3 position;
+layout (location = 2) in vec3 normal;
+
+out vec3 vertexNormal;
+
+void main()
+{
+    gl_Position = vec4(position, 1.0f);
+    vertexNormal = normal;
+}
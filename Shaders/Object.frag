@@ -0,0 +1,168 @@
+#version 400 core
+/*
+ * The fragment stage of every object shader. See Object.vert for the features, and for the two that are only here:
+ *  POINT_LIGHTS    with LIT, add up every light in LightUniforms as well as the main one (PointLights.h)
+ *  CLUSTERED       with LIT, add up just the lights in the fragment's cluster, out of shader storage buffers
+ *                  (LightClusters.h). Needs GL 4.3 or ARB_shader_storage_buffer_object
+ *  GBUFFER         with LIT, write the surface colour and packed normal for DeferredLight.frag to light later,
+ *                  instead of lighting it here (DeferredShading.h)
+ */
+#ifdef BINDLESS
+#extension GL_ARB_bindless_texture : require
+#endif
+#ifdef CLUSTERED
+#extension GL_ARB_shader_storage_buffer_object : require
+#endif
+#ifdef TEXTURED
+in vec2 texCoordFrag;
+#endif
+#ifdef TEXTURE_ARRAY
+flat in int layerFrag;
+#endif
+#ifdef LIT
+in vec3 fragPos;
+in vec3 normalVec;
+#endif
+
+layout (location = 0) out vec4 colour;
+#ifdef GBUFFER
+layout (location = 1) out vec2 packedNormal;
+#endif
+
+layout (std140) uniform ObjectUniforms
+{
+    mat4 MVPmatrix;
+    mat4 modelMatrix;
+    vec4 baseColour;
+    int textureLayer;
+    uvec2 textureHandle;    //Bindless, as two halves
+};
+
+#ifdef LIT
+layout (std140) uniform FrameUniforms
+{
+    vec4 lightColour;
+    vec3 lightPos;
+    vec3 viewPos;
+};
+#endif
+
+#if defined(POINT_LIGHTS) || defined(CLUSTERED)
+struct PointLight
+{
+    vec4 positionRadius;
+    vec4 colour;
+};
+#endif
+
+#ifdef POINT_LIGHTS
+layout (std140) uniform LightUniforms
+{
+    int lightCount;
+    PointLight lights[1024];    //MAX_UNIFORM_POINT_LIGHTS, the most of them there's room for
+};
+#endif
+
+#ifdef CLUSTERED
+/* Every light, in the same buffer as LightUniforms */
+layout (std430) buffer LightStorage
+{
+    int storedLightCount;
+    PointLight storedLights[];
+};
+
+/* The froxels: screen tiles, each cut into slices further apart the deeper they go. See LightClusters.h */
+layout (std430) buffer ClusterGrid
+{
+    vec4 depthPlane;        //Dot with a world position (w = 1) for its depth from the camera
+    vec4 tileDepth;         //Tile width and height in pixels, then the scale and bias from log(depth) to a slice
+    ivec4 clusterDims;      //Tiles across, tiles up, slices
+    uvec2 clusters[];       //The first of each cluster's lights in lightIndices, and how many
+};
+
+layout (std430) buffer ClusterLightIndices
+{
+    uint lightIndices[];
+};
+#endif
+
+#if defined(POINT_LIGHTS) || defined(CLUSTERED)
+/* Phong from one point light, fading out to nothing at its radius. The same as DeferredLight.frag's */
+vec3 pointLight(PointLight light, vec3 position, vec3 normal, vec3 viewDirection)
+{
+    vec3 toLight = light.positionRadius.xyz - position;
+    float lightDistance = length(toLight);
+    float falloff = clamp(1.0 - (lightDistance * lightDistance) / (light.positionRadius.w * light.positionRadius.w), 0.0, 1.0);
+    vec3 lightDirection = toLight / max(lightDistance, 0.0001);
+
+    float diffuse = max(dot(normal, lightDirection), 0.0);
+    float specular = 0.5 * pow(max(dot(viewDirection, reflect(-lightDirection, normal)), 0.0), 32);
+    return (diffuse + specular) * falloff * falloff * light.colour.rgb;
+}
+#endif
+
+#if defined(GBUFFER)
+/* Octahedral encoding: the unit sphere folded onto a square, then moved into 0 to 1 for a GL_RG16 target */
+vec2 packNormal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 folded = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return folded * 0.5 + 0.5;
+}
+#endif
+
+#if defined(TEXTURED) && defined(TEXTURE_ARRAY)
+uniform sampler2DArray ourTextures;
+#elif defined(TEXTURED) && !defined(BINDLESS)
+uniform sampler2D ourTexture;
+#endif
+
+void main()
+{
+    vec4 surface = baseColour;
+#if defined(TEXTURED) && defined(TEXTURE_ARRAY)
+    surface *= texture(ourTextures, vec3(texCoordFrag, layerFrag));
+#elif defined(TEXTURED) && defined(BINDLESS)
+    surface *= texture(sampler2D(textureHandle), texCoordFrag);
+#elif defined(TEXTURED)
+    surface *= texture(ourTexture, texCoordFrag);
+#endif
+
+#if defined(LIT) && defined(GBUFFER)
+    colour = vec4(surface.rgb, 1.0);
+    packedNormal = packNormal(normalize(normalVec));
+#elif defined(LIT)
+    float ambientStrength = 0.1f;
+    vec4 ambientLight = ambientStrength * lightColour;
+
+    vec3 normals = normalize(normalVec);
+    vec3 lightDirection = normalize(lightPos - fragPos);
+
+    float diffInt = max(dot(normals, lightDirection), 0.0);
+    vec4 diffuseLight = diffInt * lightColour;
+
+    float specularStrength = 0.5f;
+    vec3 viewDirection = normalize(viewPos - fragPos);
+    vec3 reflectDirection = reflect(-lightDirection, normals);
+    float specular = pow(max(dot(viewDirection, reflectDirection), 0.0), 32);
+    vec4 specularLight = specularStrength * specular * lightColour;
+
+    vec4 lighting = ambientLight + diffuseLight + specularLight;
+#ifdef POINT_LIGHTS
+    for(int i = 0; i < min(lightCount, 1024); i++)
+        lighting.rgb += pointLight(lights[i], fragPos, normals, viewDirection);
+#endif
+#ifdef CLUSTERED
+    float viewDepth = dot(depthPlane, vec4(fragPos, 1.0));
+    int slice = clamp(int(log(max(viewDepth, 0.0001)) * tileDepth.z + tileDepth.w), 0, clusterDims.z - 1);
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy / tileDepth.xy), ivec2(0), clusterDims.xy - 1);
+    uvec2 cluster = clusters[(slice * clusterDims.y + tile.y) * clusterDims.x + tile.x];
+    for(uint i = 0u; i < cluster.y; i++)
+        lighting.rgb += pointLight(storedLights[lightIndices[cluster.x + i]], fragPos, normals, viewDirection);
+#endif
+
+    colour = surface * lighting;
+#else
+    colour = surface;
+#endif
+}
@@ -0,0 +1,158 @@
+#version 400 core
+/*
+ * The vertex stage of every object shader. Shader adds a #define for each feature the permutation has
+ * (see ShaderFeature in ShaderLoader.h):
+ *  TEXTURED    pass the texture coordinates on
+ *  LIT         pass the world position and normal on, for Phong lighting
+ *  PROCEDURAL  work the vertex out from gl_VertexID and the instance's shape (ProceduralMesh.h) instead of
+ *              reading it, in the same order GetSpherePhong and GetConePhong lay their triangles out
+ *  TEXTURE_ARRAY   pass on which layer of the texture array to sample (TextureArrays.h)
+ *  INSTANCED   place each instance with its own model matrix, inside the object's, and take its texture
+ *              layer from the instance too (InstancedMesh.h)
+ *  BINDLESS    only changes the fragment stage, which samples textureHandle instead of a bound texture
+ */
+#ifdef PROCEDURAL
+layout (location = 3) in vec4 instancePlacement;   //Centre xyz, radius w
+layout (location = 4) in vec4 instanceShape;       //Segments, rings, height / radius (0 for a sphere)
+#else
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec2 texCoord;
+layout (location = 2) in vec3 normal;
+#endif
+#ifdef INSTANCED
+layout (location = 5) in mat4 instanceModel;        //Takes locations 5 to 8
+layout (location = 9) in int instanceLayer;
+#endif
+
+layout (std140) uniform ObjectUniforms
+{
+    mat4 MVPmatrix;
+    mat4 modelMatrix;
+    vec4 baseColour;
+    int textureLayer;
+    uvec2 textureHandle;    //Bindless, as two halves
+};
+
+#ifdef TEXTURED
+out vec2 texCoordFrag;
+#endif
+#ifdef TEXTURE_ARRAY
+flat out int layerFrag;
+#endif
+#ifdef LIT
+out vec3 fragPos;
+out vec3 normalVec;
+#endif
+
+#ifdef PROCEDURAL
+const float PI = 3.14159265358979;
+
+/* Triangle corners of a quad between two lines of latitude, as (ring step, segment step) */
+const ivec2 QUAD_CORNERS[6] = ivec2[6](ivec2(0, 0), ivec2(0, 1), ivec2(1, 0),
+                                       ivec2(0, 1), ivec2(1, 1), ivec2(1, 0));
+
+/* Point i on line of latitude j of a unit sphere. The normal is the same */
+vec3 spherePoint(int j, int i, int segments, int rings)
+{
+    float theta = PI / 2.0 - j * PI / rings;
+    float phi = (i % segments) * 2.0 * PI / segments;
+    return vec3(cos(theta) * cos(phi), sin(theta), cos(theta) * sin(phi));
+}
+
+void sphereVertex(int v, int segments, int rings, out vec3 position, out vec3 normal)
+{
+    int capVertices = 3 * segments;
+    int bandVertices = 6 * segments;
+    int j, i;
+
+    if(v < capVertices)
+    {
+        //Top cap: the pole, then two points on the first line of latitude
+        int corner = v % 3;
+        j = corner == 0 ? 0 : 1;
+        i = v / 3 + (corner == 2 ? 1 : 0);
+    }
+    else if(v >= capVertices + (rings - 2) * bandVertices)
+    {
+        //Bottom cap: the pole, then two points on the last line of latitude
+        int local = v - capVertices - (rings - 2) * bandVertices;
+        int corner = local % 3;
+        j = corner == 0 ? rings : rings - 1;
+        i = local / 3 + (corner == 2 ? 1 : 0);
+    }
+    else
+    {
+        int local = v - capVertices;
+        int segment = (local % bandVertices) / 6;
+        ivec2 corner = QUAD_CORNERS[local % 6];
+        j = local / bandVertices + 1 + corner.x;
+        i = segment + corner.y;
+    }
+
+    position = spherePoint(j, i, segments, rings);
+    normal = position;
+}
+
+void coneVertex(int v, int segments, float height, out vec3 position, out vec3 normal)
+{
+    int triangle = v / 3;
+    int corner = v % 3;
+    bool base = triangle >= segments;
+    int i = (base ? triangle - segments : triangle) + (corner == 2 ? 1 : 0);
+
+    float phi = (i % segments) * 2.0 * PI / segments;
+    vec3 rim = vec3(cos(phi), -height / 2.0, sin(phi));
+    position = corner == 1 ? vec3(0.0, base ? -height / 2.0 : height / 2.0, 0.0) : rim;
+
+    if(base)
+    {
+        normal = vec3(0.0, -1.0, 0.0);
+    }
+    else
+    {
+        //The tip takes the normal of the rim point it starts from
+        float along = (triangle % segments) * 2.0 * PI / segments;
+        float phiNormal = corner == 2 ? phi : along;
+        normal = normalize(vec3(height * cos(phiNormal), 1.0, height * sin(phiNormal)));
+    }
+}
+#endif
+
+void main()
+{
+#ifdef PROCEDURAL
+    int segments = int(instanceShape.x);
+    int rings = int(instanceShape.y);
+    float height = instanceShape.z;
+
+    vec3 shapePosition, vertexNormal;
+    if(height > 0.0)
+        coneVertex(gl_VertexID, segments, height, shapePosition, vertexNormal);
+    else
+        sphereVertex(gl_VertexID, segments, rings, shapePosition, vertexNormal);
+    vec3 modelPosition = instancePlacement.xyz + instancePlacement.w * shapePosition;
+    vec2 vertexTexCoord = vec2(0.0);
+#else
+    vec3 modelPosition = position;
+    vec3 vertexNormal = normal;
+    vec2 vertexTexCoord = texCoord;
+#endif
+#ifdef INSTANCED
+    modelPosition = vec3(instanceModel * vec4(modelPosition, 1.0f));
+    vertexNormal = mat3(instanceModel) * vertexNormal;
+#endif
+
+    gl_Position = MVPmatrix * vec4(modelPosition, 1.0f);
+#ifdef TEXTURED
+    texCoordFrag = vec2(vertexTexCoord.x, 1.0f - vertexTexCoord.y);
+#endif
+#if defined(TEXTURE_ARRAY) && defined(INSTANCED)
+    layerFrag = instanceLayer;
+#elif defined(TEXTURE_ARRAY)
+    layerFrag = textureLayer;
+#endif
+#ifdef LIT
+    fragPos = vec3(modelMatrix * vec4(modelPosition, 1.0f));
+    normalVec = vertexNormal;
+#endif
+}
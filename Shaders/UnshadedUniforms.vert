@@ -1,13 +1,11 @@
 #version 400 core
+/* Object.vert with no features, but with plain uniforms instead of the blocks, so the benchmarks can compare the two */
 layout (location = 0) in vec3 position;
-layout (location = 1) in vec2 texCoord;
 
 uniform mat4 MVPmatrix;
 
-out vec2 texCoordFrag;
-
 void main()
 {
     gl_Position = MVPmatrix * vec4(position, 1.0f);
-    texCoordFrag = vec2(texCoord.x, 1.0f - texCoord.y);
 }
+
@@ -0,0 +1,130 @@
+/*
+ * Asset packer: puts the demo's loose assets into one file for AssetPack.h to map at startup.
+ *
+ * Usage: AssetPacker [-o assets.pack] [-u] folder-or-file...
+ * e.g. AssetPacker models Images Shaders, run from the folder the demo runs in, so the names in the pack are
+ * the paths the demo asks for. Folders are packed with everything under them, apart from hidden files.
+ * Entries are LZ4 compressed where it saves at least an eighth (mostly the shaders and OBJs, as PNGs and KTX2s
+ * are compressed already). -u stores everything as it is.
+ * Once it's written the pack is opened and every entry read back and checked against its file.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "../Include/AssetPack.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+/* Add a file, or everything under a folder, to the sources */
+bool Gather(const std::string& path, std::vector<AssetPackSource>& sources)
+{
+    struct stat status;
+    if(stat(path.c_str(), &status) != 0)
+    {
+        std::cout << "Couldn't find " << path << std::endl;
+        return false;
+    }
+
+    if(S_ISDIR(status.st_mode))
+    {
+        DIR* folder = opendir(path.c_str());
+        if(folder == NULL)
+        {
+            std::cout << "Couldn't open " << path << std::endl;
+            return false;
+        }
+        std::vector<std::string> children;
+        for(struct dirent* child = readdir(folder); child != NULL; child = readdir(folder))
+            if(child->d_name[0] != '.')
+                children.push_back(child->d_name);
+        closedir(folder);
+
+        bool gathered = true;
+        std::string prefix = (path[path.size() - 1] == '/') ? path : path + "/";
+        for(size_t c = 0; c < children.size(); c++)
+            gathered = Gather(prefix + children[c], sources) && gathered;
+        return gathered;
+    }
+
+    AssetPackSource source;
+    source.name = path;
+    while(source.name.compare(0, 2, "./") == 0)
+        source.name.erase(0, 2);
+    Asset file;
+    if(!ReadLooseAsset(path, file))
+    {
+        std::cout << "Couldn't read " << path << std::endl;
+        return false;
+    }
+    source.data.assign(file.data, file.data + file.size);
+    sources.push_back(source);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::string output = ASSET_PACK_PATH;
+    bool compress = true;
+    std::vector<AssetPackSource> sources;
+    bool gathered = true;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else if(strcmp(argv[i], "-u") == 0)
+            compress = false;
+        else
+            gathered = Gather(argv[i], sources) && gathered;
+    }
+    if(sources.empty())
+    {
+        std::cout << "Usage: AssetPacker [-o assets.pack] [-u] folder-or-file..." << std::endl;
+        return 1;
+    }
+    if(!gathered)
+        return 1;
+
+    Clock::time_point start = Clock::now();
+    if(!WriteAssetPack(output, sources, compress))
+        return 1;
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    //Read it all back the way the demo will
+    AssetPack pack;
+    if(!pack.Open(output))
+        return 1;
+    int compressed = 0, failed = 0;
+    long original = 0, stored = 0;
+    for(size_t s = 0; s < sources.size(); s++)
+    {
+        Asset asset;
+        const AssetPackEntry* entry = pack.Find(sources[s].name);
+        if(entry == NULL || !pack.Read(sources[s].name, asset) || asset.size != sources[s].data.size() ||
+           (asset.size > 0 && memcmp(asset.data, sources[s].data.data(), asset.size) != 0))
+        {
+            std::cout << sources[s].name << " didn't read back the same" << std::endl;
+            failed++;
+            continue;
+        }
+
+        char line[200];
+        snprintf(line, sizeof(line), "%-40s %8.1f KB -> %8.1f KB%s", sources[s].name.c_str(), entry->size / 1024.0,
+                 entry->storedSize / 1024.0, (entry->flags & ASSET_LZ4) ? " (LZ4)" : "");
+        std::cout << line << std::endl;
+        original += entry->size;
+        stored += entry->storedSize;
+        if(entry->flags & ASSET_LZ4)
+            compressed++;
+    }
+    std::cout << "Packed " << sources.size() << " assets (" << compressed << " compressed) into " << output << ": "
+              << original / 1024 << " KB of assets, " << stored / 1024 << " KB stored, " << pack.GetBytes() / 1024
+              << " KB with the table and alignment, in " << seconds * 1000.0 << " ms" << std::endl;
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * Offline texture baker: turns PNGs (or anything else stb_image reads) into block-compressed KTX2 files
+ * with every mip level made ahead of time, for TextureLoader.h to upload as they are.
+ *
+ * Usage: TextureBaker [-f bc1|bc3|bc7] [-j threads] image.png...
+ * Each image is written next to itself with a .ktx2 extension, e.g. Images/thunderbird.png -> Images/thunderbird.ktx2.
+ * Without -f, images with no transparent pixels are baked to BC1 and the rest to BC3.
+ * Blocks are compressed on a job system, a row of blocks per job. -j sets its threads (default one per hardware
+ * thread) and -j 1 does it all on this thread.
+ */
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../Include/stb_image/stb_image.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <chrono>
+#include <string>
+#include <iostream>
+
+#include "../Include/BlockCompression.h"
+#include "../Include/KTX2File.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+/* Bake one image. formatChoice is a BlockFormat, or -1 to pick from the alpha */
+bool Bake(const std::string& path, int formatChoice, JobSystem* jobs)
+{
+    int width, height, n;
+    unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &n, 4);
+    if(!pixels)
+    {
+        std::cout << "Couldn't load " << path << std::endl;
+        return false;
+    }
+    RGBAImage image;
+    image.width = width;
+    image.height = height;
+    image.pixels.assign(pixels, pixels + width * height * 4);
+    stbi_image_free(pixels);
+
+    BlockFormat format = (BlockFormat)formatChoice;
+    if(formatChoice < 0)
+    {
+        format = BLOCK_BC1;
+        for(int p = 0; p < width * height; p++)
+            if(image.pixels[p * 4 + 3] != 255)
+                format = BLOCK_BC3;
+    }
+
+    Clock::time_point start = Clock::now();
+    std::vector<RGBAImage> mips = BuildMipChain(image);
+    KTX2Texture texture;
+    texture.format = format;
+    texture.width = width;
+    texture.height = height;
+    for(size_t l = 0; l < mips.size(); l++)
+        texture.levels.push_back(CompressImage(mips[l], format, jobs));
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::string bakedPath = BakedTexturePath(path);
+    if(!WriteKTX2(bakedPath, texture))
+        return false;
+
+    RGBAImage decoded = DecompressImage(texture.levels[0], format, width, height);
+    long uncompressed = 0;
+    for(size_t l = 0; l < mips.size(); l++)
+        uncompressed += (long)mips[l].width * mips[l].height * 3;
+    char line[160];
+    snprintf(line, sizeof(line), "%s: %dx%d %s, %d levels, %.1f KB (%.1f KB as RGB), %.1f dB, %.1f ms",
+             bakedPath.c_str(), width, height, BLOCK_FORMAT_NAMES[format], (int)mips.size(), texture.GetBytes() / 1024.0,
+             uncompressed / 1024.0, ImagePSNR(image, decoded, format == BLOCK_BC1 ? 3 : 4), seconds * 1000.0);
+    std::cout << line << std::endl;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    int format = -1;
+    int threads = jobSystem.ThreadCount();
+    std::vector<std::string> paths;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+        {
+            std::string name = argv[++i];
+            for(size_t c = 0; c < name.size(); c++)
+                name[c] = toupper(name[c]);
+            format = -2;
+            for(int f = 0; f < 3; f++)
+                if(name == BLOCK_FORMAT_NAMES[f])
+                    format = f;
+            if(format == -2)
+            {
+                std::cout << "Unknown format " << name << ", expected bc1, bc3 or bc7" << std::endl;
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else
+        {
+            paths.push_back(argv[i]);
+        }
+    }
+    if(paths.empty())
+    {
+        std::cout << "Usage: TextureBaker [-f bc1|bc3|bc7] [-j threads] image.png..." << std::endl;
+        return 1;
+    }
+
+    //The shared job system already has a thread per core, so only make another for a different count
+    JobSystem* jobs = &jobSystem;
+    if(threads <= 1)
+        jobs = NULL;
+    else if(threads != jobSystem.ThreadCount())
+        jobs = new JobSystem(threads - 1);
+
+    Clock::time_point start = Clock::now();
+    int failed = 0;
+    for(size_t i = 0; i < paths.size(); i++)
+        if(!Bake(paths[i], format, jobs))
+            failed++;
+    std::cout << "Baked " << paths.size() - failed << " of " << paths.size() << " textures in "
+              << std::chrono::duration<double>(Clock::now() - start).count() << " s on "
+              << (jobs != NULL ? jobs->ThreadCount() : 1) << " threads" << std::endl;
+
+    if(jobs != NULL && jobs != &jobSystem)
+        delete jobs;
+    return failed > 0 ? 1 : 0;
+}
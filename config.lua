@@ -7,7 +7,7 @@ print("Config.lua executed")
 GLFW = GLFW3
 GLew = true
 IMAGE = 'stb_image'
-STD = 'c++11'
+STD = 'c++14'
 BOOST = false
 BULLET = false
 MODEL = true
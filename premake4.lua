@@ -6,4 +6,18 @@ solution ('OpenGL_Intro')
         targetdir('./')
         links{'glew32', 'glfw3', 'opengl32'}
         files {"*.cpp"}
-        buildoptions{'-Wno-write-strings'}
\ No newline at end of file
+        buildoptions{'-std=c++14', '-Wno-write-strings', '-pthread'}
+        linkoptions{'-pthread'}
+
+      project("TextureBaker")
+        kind 'ConsoleApp'
+        targetdir('./')
+        files {"Tools/TextureBaker.cpp"}
+        buildoptions{'-std=c++14', '-Wno-write-strings', '-pthread'}
+        linkoptions{'-pthread'}
+
+      project("AssetPacker")
+        kind 'ConsoleApp'
+        targetdir('./')
+        files {"Tools/AssetPacker.cpp"}
+        buildoptions{'-std=c++14', '-Wno-write-strings'}